@@ -7,15 +7,21 @@ TEST_DIR := tests
 OBJ_DIR := obj
 
 ASSEMBLY :=compiler# change this to the name of the assembly you want to build
-COMPILER_FLAGS := -g -Wall -std=$(CXXSPEC) 
+COMPILER_FLAGS := -g -Wall -std=$(CXXSPEC) -pthread
 INCLUDE_FLAGS := -I$(ASSEMBLY)/src -I$(ASSEMBLY) -I/usr/local/lib/llvm/include
-LLVM := `llvm-config --ldflags --system-libs --libs core`
+LLVM := `llvm-config --ldflags --system-libs --libs core passes native orcjit perfjitevents`
 # LLVM := `llvm-config --cxxflags --ldflags --system-libs --libs core`
 # LINKER_FLAGS :=  -shared  
 LINKER_FLAGS :=  -L/usr/local/lib/llvm
 TEST_LINKER_FLAGS := -L./bin/ -l$(ASSEMBLY)
 DEFINES := -DQDEBUG -DQEXPORT
 
+# `make NO_LLVM=1` builds without the LLVM backend; programs only run on the VM
+ifeq ($(NO_LLVM),1)
+DEFINES += -DQ_NO_LLVM
+LLVM :=
+endif
+
 SRC_FILES := $(shell find $(ASSEMBLY) -name *.cc)		# .cc files
 TEST_FILES := $(shell find $(TEST_DIR) -name *.cc)		# .cc files
 DIRECTORIES := $(shell find $(ASSEMBLY) -type d)		# directories with .h files
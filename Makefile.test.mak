@@ -6,7 +6,7 @@ OBJ_DIR := obj
 
 ASSEMBLY := compiler
 TEST_DIR := tests
-COMPILER_FLAGS := -g -Werror -Wall -std=$(CXXSPEC) -fPIC
+COMPILER_FLAGS := -g -Werror -Wall -std=$(CXXSPEC) -fPIC -pthread
 INCLUDE_FLAGS := -I$(ASSEMBLY)/src -I$(ASSEMBLY)
 TEST_INCLUDE_FLAGS := -I$(TEST_DIR)/src -I$(TEST_DIR) 
 LINKER_FLAGS := -shared
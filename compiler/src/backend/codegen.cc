@@ -0,0 +1,601 @@
+#ifndef Q_NO_LLVM
+#include "codegen.h"
+#include "core/utils.h"
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/ModuleUtils.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace compiler {
+namespace backend {
+
+using namespace core;
+
+/// Errors are only made when they are returned, since making one
+/// stores its arguments
+static Error
+unsupported_operator(Operator op) {
+    return Error(ErrorCode::UnsupportedOperator, { DiagnosticArg::text(operator_to_cstr(op)) });
+}
+
+/// Priority of the module constructor. Runs after anything with a lower one
+constexpr i32 INIT_PRIORITY = 65535;
+
+CodeGen::CodeGen(Program& program, llvm::LLVMContext& context, std::string_view module_name)
+    : m_program(program)
+      , m_context(context)
+      , m_module(std::make_unique<llvm::Module>(llvm::StringRef(module_name.data(), module_name.size()), context))
+      , m_builder(context)
+    {}
+
+void CodeGen::enable_debug_info(std::string_view source_path) {
+    std::filesystem::path path(source_path);
+    m_debug = std::make_unique<llvm::DIBuilder>(*m_module);
+    m_debug_file = m_debug->createFile(path.filename().string(), path.parent_path().string());
+    m_debug->createCompileUnit(
+        llvm::dwarf::DW_LANG_C, m_debug_file, "craft", false, "", 0, 
+        llvm::StringRef(), llvm::DICompileUnit::LineTablesOnly
+    );
+    m_module->addModuleFlag(llvm::Module::Warning, "Debug Info Version", llvm::DEBUG_METADATA_VERSION);
+    m_module->addModuleFlag(llvm::Module::Warning, "Dwarf Version", 4);
+}
+
+Result<Unit, Error> CodeGen::lower() {
+    std::vector<const AstFunctionDecl*> functions;
+    for (const AstNode* node : m_program.nodes()) {
+        if (const AstFunctionDecl* function = utils::dyn_cast<AstFunctionDecl>(node)) {
+            functions.push_back(function);
+        }
+    }
+    return lower_unit(functions, true);
+}
+
+Result<Unit, Error> CodeGen::lower_unit(std::span<const AstFunctionDecl* const> functions, bool define_globals) {
+    // Functions are declared first, since the values of globals can call them
+    for (const AstNode* node : m_program.nodes()) {
+        if (const AstFunctionDecl* function = utils::dyn_cast<AstFunctionDecl>(node)) {
+            Result<Unit, Error> declared = declare_function(function);
+            if (declared.is_err()) {
+                return declared;
+            }
+        }
+    }
+
+    for (const AstNode* node : m_program.nodes()) {
+        if (const AstVarDecl* decl = utils::dyn_cast<AstVarDecl>(node)) {
+            Result<Unit, Error> lowered = lower_global(decl, define_globals);
+            if (lowered.is_err()) {
+                return lowered;
+            }
+        }
+    }
+
+    if (m_init != nullptr) {
+        m_builder.CreateRetVoid();
+    }
+
+    for (const AstFunctionDecl* function : functions) {
+        Result<Unit, Error> lowered = lower_function(function);
+        if (lowered.is_err()) {
+            return lowered;
+        }
+    }
+
+    if (m_debug != nullptr) {
+        m_debug->finalize();
+    }
+
+    std::string problems;
+    llvm::raw_string_ostream out(problems);
+    if (llvm::verifyModule(*m_module, &out)) {
+        return Err(Error(ErrorCode::InvalidModule, { DiagnosticArg::text(out.str()) }));
+    }
+    return Ok(Unit());
+}
+
+Result<Unit, Error> CodeGen::declare_function(const AstFunctionDecl* decl) {
+    std::vector<llvm::Type*> params;
+    for (const AstParamDecl* param : decl->params) {
+        Result<llvm::Type*, Error> type = lower_type(param->type);
+        if (type.is_err()) {
+            return Err(type.unwrap_err());
+        }
+        params.push_back(type.unwrap());
+    }
+
+    Result<llvm::Type*, Error> return_type = lower_type(decl->return_type);
+    if (return_type.is_err()) {
+        return Err(return_type.unwrap_err());
+    }
+
+    llvm::FunctionType* type = llvm::FunctionType::get(return_type.unwrap(), params, false);
+    m_functions[decl] = llvm::Function::Create(
+        type, llvm::GlobalValue::ExternalLinkage, 
+        std::string(Interner::global().lookup(decl->name)), *m_module
+    );
+    return Ok(Unit());
+}
+
+Result<Unit, Error> CodeGen::lower_global(const AstVarDecl* decl, bool define) {
+    const AstIdentifierExpr* name = utils::cast<AstIdentifierExpr>(decl->target);
+    const Type* type = decl->type.value_or(decl->value->get_type());
+    if (type == nullptr) {
+        return Err(Error(ErrorCode::UntypedExpression));
+    }
+
+    Result<llvm::Type*, Error> lowered_type = lower_type(type);
+    if (lowered_type.is_err()) {
+        return Err(lowered_type.unwrap_err());
+    }
+    llvm::Type* storage_type = lowered_type.unwrap();
+
+    // Literals are stored directly. Anything else starts out zeroed
+    // and is filled in when the module is loaded. Globals that another
+    // unit defines are only declared here
+    llvm::Constant* literal = define ? lower_literal(decl->value, storage_type) : nullptr;
+    llvm::Constant* initializer = nullptr;
+    if (define) {
+        initializer = literal != nullptr ? literal : llvm::Constant::getNullValue(storage_type);
+    }
+
+    llvm::GlobalVariable* storage = new llvm::GlobalVariable(
+        *m_module, storage_type, false, llvm::GlobalValue::ExternalLinkage, initializer,
+        std::string(Interner::global().lookup(name->name))
+    );
+
+    if (define && literal == nullptr) {
+        init_function();
+        Result<llvm::Value*, Error> value = lower_expr(decl->value);
+        if (value.is_err()) {
+            return Err(value.unwrap_err());
+        }
+        m_builder.CreateStore(convert(value.unwrap(), decl->value->get_type(), type), storage);
+    }
+
+    // Stored after its value is lowered, so it cannot refer to itself
+    m_storage[decl] = Storage{ storage, storage_type, true };
+    return Ok(Unit());
+}
+
+Result<Unit, Error> CodeGen::lower_function(const AstFunctionDecl* decl) {
+    llvm::Function* function = m_functions.at(decl);
+    llvm::BasicBlock* entry = llvm::BasicBlock::Create(m_context, "entry", function);
+    m_builder.SetInsertPoint(entry);
+
+    // Line tables only need to know where each function and
+    // statement is, so the types of functions are left empty
+    llvm::DISubprogram* subprogram = nullptr;
+    if (m_debug != nullptr) {
+        subprogram = m_debug->createFunction(
+            m_debug_file, function->getName(), function->getName(), m_debug_file, decl->line,
+            m_debug->createSubroutineType(m_debug->getOrCreateTypeArray({})), decl->line,
+            llvm::DINode::FlagZero, llvm::DISubprogram::SPFlagDefinition
+        );
+        function->setSubprogram(subprogram);
+    }
+
+    // Parameters are never assigned, so they stay in registers
+    for (usize i = 0; i < decl->params.size(); i++) {
+        llvm::Argument* arg = function->getArg(static_cast<u32>(i));
+        arg->setName(std::string(Interner::global().lookup(decl->params[i]->name)));
+        m_storage[decl->params[i]] = Storage{ arg, arg->getType(), false };
+    }
+
+    for (usize i = 0; i < decl->body.size(); i++) {
+        const AstNode* stmt = decl->body[i];
+        if (subprogram != nullptr) {
+            m_builder.SetCurrentDebugLocation(llvm::DILocation::get(m_context, decl->lines[i], 1, subprogram));
+        }
+
+        if (const AstReturnStmt* ret = utils::dyn_cast<AstReturnStmt>(stmt)) {
+            Result<llvm::Value*, Error> value = lower_expr(ret->value);
+            if (value.is_err()) {
+                return Err(value.unwrap_err());
+            }
+            m_builder.CreateRet(convert(value.unwrap(), ret->value->get_type(), decl->return_type));
+            m_builder.SetCurrentDebugLocation(llvm::DebugLoc());
+
+            // Nothing after a return is ever run
+            return Ok(Unit());
+        }
+
+        const AstVarDecl* local = utils::cast<AstVarDecl>(stmt);
+        const Type* type = local->type.value_or(local->value->get_type());
+        Result<llvm::Type*, Error> lowered_type = lower_type(type);
+        if (lowered_type.is_err()) {
+            return Err(lowered_type.unwrap_err());
+        }
+
+        // Slots go at the start of the entry block, where mem2reg looks for them
+        llvm::IRBuilder<> entry_builder(entry, entry->begin());
+        llvm::AllocaInst* slot = entry_builder.CreateAlloca(
+            lowered_type.unwrap(), nullptr, 
+            std::string(Interner::global().lookup(utils::cast<AstIdentifierExpr>(local->target)->name))
+        );
+
+        Result<llvm::Value*, Error> value = lower_expr(local->value);
+        if (value.is_err()) {
+            return Err(value.unwrap_err());
+        }
+        m_builder.CreateStore(convert(value.unwrap(), local->value->get_type(), type), slot);
+        m_storage[local] = Storage{ slot, lowered_type.unwrap(), true };
+    }
+    m_builder.SetCurrentDebugLocation(llvm::DebugLoc());
+    return Ok(Unit());
+}
+
+Result<llvm::Type*, Error> CodeGen::lower_type(const Type* type) {
+    if (const TypeInteger* integer = utils::dyn_cast<TypeInteger>(type)) {
+        return Ok(static_cast<llvm::Type*>(llvm::IntegerType::get(m_context, integer->size * 8)));
+    }
+    if (const TypeFloat* floating = utils::dyn_cast<TypeFloat>(type)) {
+        return Ok(floating->size == 4 ? llvm::Type::getFloatTy(m_context) : llvm::Type::getDoubleTy(m_context));
+    }
+    if (utils::isa<TypeBoolean>(type)) {
+        return Ok(static_cast<llvm::Type*>(llvm::Type::getInt1Ty(m_context)));
+    }
+    if (const TypePointer* pointer = utils::dyn_cast<TypePointer>(type)) {
+        Result<llvm::Type*, Error> target = lower_type(pointer->target);
+        if (target.is_err()) {
+            return target;
+        }
+        return Ok(static_cast<llvm::Type*>(llvm::PointerType::getUnqual(target.unwrap())));
+    }
+    if (const TypeArray* array = utils::dyn_cast<TypeArray>(type)) {
+        Result<llvm::Type*, Error> element = lower_type(array->target);
+        if (element.is_err()) {
+            return element;
+        }
+        return Ok(static_cast<llvm::Type*>(llvm::ArrayType::get(element.unwrap(), array->length)));
+    }
+
+    return Err(Error(ErrorCode::UnsupportedType, { DiagnosticArg::text(type->to_str()) }));
+}
+
+llvm::Constant* CodeGen::lower_literal(const AstExpr* expr, llvm::Type* type) {
+    switch (expr->kind) {
+        case AstKind::IntegerExpr:
+            return llvm::ConstantInt::get(type, utils::cast<AstIntegerExpr>(expr)->value);
+        case AstKind::FloatExpr:
+            return llvm::ConstantFP::get(type, utils::cast<AstFloatExpr>(expr)->value);
+        case AstKind::BoolExpr:
+            return llvm::ConstantInt::getBool(m_context, utils::cast<AstBoolExpr>(expr)->value);
+        default:
+            return nullptr;
+    }
+}
+
+llvm::Function* CodeGen::init_function() {
+    if (m_init == nullptr) {
+        llvm::FunctionType* type = llvm::FunctionType::get(llvm::Type::getVoidTy(m_context), false);
+        m_init = llvm::Function::Create(type, llvm::GlobalValue::InternalLinkage, "craft.init", *m_module);
+        m_builder.SetInsertPoint(llvm::BasicBlock::Create(m_context, "entry", m_init));
+        llvm::appendToGlobalCtors(*m_module, m_init, INIT_PRIORITY);
+    }
+    return m_init;
+}
+
+Result<llvm::Value*, Error> CodeGen::lower_expr(const AstExpr* root) {
+    // Walked with an explicit stack like analysis is, since
+    // expressions can be far too deep to recurse over
+    struct Frame {
+        const AstExpr* expr;
+        u32 stage;                  // operands lowered so far
+        llvm::BasicBlock* lhs_end;  // for `&&` and `||`, the block the lhs ends in
+        llvm::BasicBlock* merge;    // and the block they join in
+    };
+
+    std::vector<Frame> stack;
+    std::vector<llvm::Value*> values;
+    stack.push_back(Frame{ root, 0, nullptr, nullptr });
+
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        const AstExpr* expr = frame.expr;
+
+        if (expr->get_type() == nullptr) {
+            // Operators that analysis does not type yet are left without one
+            if (const AstBinaryExpr* binary = utils::dyn_cast<AstBinaryExpr>(expr)) {
+                return Err(Error(ErrorCode::UnsupportedOperator, { DiagnosticArg::text(operator_to_cstr(binary->op)) }));
+            }
+            return Err(Error(ErrorCode::UntypedExpression));
+        }
+
+        if (const AstIdentifierExpr* identifier = utils::dyn_cast<AstIdentifierExpr>(expr)) {
+            const Storage& storage = m_storage.at(identifier->decl);
+            values.push_back(storage.is_address 
+                ? m_builder.CreateLoad(storage.type, storage.value) 
+                : storage.value);
+            stack.pop_back();
+            continue;
+        }
+
+        if (const AstCallExpr* call = utils::dyn_cast<AstCallExpr>(expr)) {
+            if (frame.stage < call->args.size()) {
+                AstExpr* arg = call->args[frame.stage++];
+                stack.push_back(Frame{ arg, 0, nullptr, nullptr });
+                continue;
+            }
+
+            // The arguments were lowered in order, so they are on top of the stack
+            std::vector<llvm::Value*> args(values.end() - call->args.size(), values.end());
+            values.resize(values.size() - call->args.size());
+            values.push_back(m_builder.CreateCall(m_functions.at(call->target), args));
+            stack.pop_back();
+            continue;
+        }
+
+        if (const AstPrefixExpr* prefix = utils::dyn_cast<AstPrefixExpr>(expr)) {
+            if (frame.stage == 0) {
+                frame.stage = 1;
+                stack.push_back(Frame{ prefix->rhs, 0, nullptr, nullptr });
+                continue;
+            }
+
+            llvm::Value* rhs = values.back();
+            values.pop_back();
+            Result<llvm::Value*, Error> value = lower_prefix(prefix, rhs);
+            if (value.is_err()) {
+                return value;
+            }
+            values.push_back(value.unwrap());
+            stack.pop_back();
+            continue;
+        }
+
+        if (const AstBinaryExpr* binary = utils::dyn_cast<AstBinaryExpr>(expr)) {
+            bool is_and = binary->op == Operator::LOGICAL_AND;
+            bool is_logical = is_and || binary->op == Operator::LOGICAL_OR;
+
+            if (frame.stage == 0) {
+                frame.stage = 1;
+                stack.push_back(Frame{ binary->lhs, 0, nullptr, nullptr });
+                continue;
+            }
+
+            // The rhs of `&&` and `||` is only evaluated if the lhs
+            // does not decide the result already
+            if (frame.stage == 1) {
+                frame.stage = 2;
+                if (is_logical) {
+                    frame.lhs_end = m_builder.GetInsertBlock();
+                    llvm::Function* function = frame.lhs_end->getParent();
+                    llvm::BasicBlock* rhs_block = llvm::BasicBlock::Create(m_context, "rhs", function);
+                    frame.merge = llvm::BasicBlock::Create(m_context, "merge", function);
+                    if (is_and) {
+                        m_builder.CreateCondBr(values.back(), rhs_block, frame.merge);
+                    } else {
+                        m_builder.CreateCondBr(values.back(), frame.merge, rhs_block);
+                    }
+                    m_builder.SetInsertPoint(rhs_block);
+                }
+                stack.push_back(Frame{ binary->rhs, 0, nullptr, nullptr });
+                continue;
+            }
+
+            llvm::Value* rhs = values.back();
+            values.pop_back();
+            llvm::Value* lhs = values.back();
+            values.pop_back();
+
+            if (is_logical) {
+                // Coming straight from the lhs means it decided the result
+                llvm::BasicBlock* rhs_end = m_builder.GetInsertBlock();
+                m_builder.CreateBr(frame.merge);
+                m_builder.SetInsertPoint(frame.merge);
+
+                llvm::PHINode* phi = m_builder.CreatePHI(llvm::Type::getInt1Ty(m_context), 2);
+                phi->addIncoming(llvm::ConstantInt::getBool(m_context, !is_and), frame.lhs_end);
+                phi->addIncoming(rhs, rhs_end);
+                values.push_back(phi);
+            } else {
+                Result<llvm::Value*, Error> value = lower_binary(binary, lhs, rhs);
+                if (value.is_err()) {
+                    return value;
+                }
+                values.push_back(value.unwrap());
+            }
+            stack.pop_back();
+            continue;
+        }
+
+        Result<llvm::Type*, Error> type = lower_type(expr->get_type());
+        if (type.is_err()) {
+            return Err(type.unwrap_err());
+        }
+        values.push_back(lower_literal(expr, type.unwrap()));
+        stack.pop_back();
+    }
+
+    return Ok(values.back());
+}
+
+llvm::Value* CodeGen::convert(llvm::Value* value, const Type* from, const Type* to) {
+    if (from == to) {
+        return value;
+    }
+
+    llvm::Type* target = lower_type(to).unwrap();
+    const TypeInteger* int_from = utils::dyn_cast<TypeInteger>(from);
+    if (int_from != nullptr && utils::isa<TypeInteger>(to)) {
+        return m_builder.CreateIntCast(value, target, int_from->is_signed);
+    }
+    if (int_from != nullptr && utils::isa<TypeFloat>(to)) {
+        return int_from->is_signed
+            ? m_builder.CreateSIToFP(value, target)
+            : m_builder.CreateUIToFP(value, target);
+    }
+    if (utils::isa<TypeFloat>(from) && utils::isa<TypeFloat>(to)) {
+        return m_builder.CreateFPCast(value, target);
+    }
+    return value;
+}
+
+Result<llvm::Value*, Error> CodeGen::lower_prefix(const AstPrefixExpr* expr, llvm::Value* rhs) {
+    switch (expr->op) {
+        case Operator::MINUS:
+            if (utils::isa<TypeFloat>(expr->get_type())) {
+                return Ok(m_builder.CreateFNeg(rhs));
+            }
+            return Ok(m_builder.CreateNeg(rhs));
+
+        // `~` on integers and `!` on booleans both flip every bit
+        case Operator::BINARY_NOT:
+        case Operator::LOGICAL_NOT:
+            return Ok(m_builder.CreateNot(rhs));
+
+        default:
+            return Err(Error(ErrorCode::UnsupportedOperator, { DiagnosticArg::text(operator_to_cstr(expr->op)) }));
+    }
+}
+
+void CodeGen::check_divisor(llvm::Value* divisor) {
+    llvm::Function* function = m_builder.GetInsertBlock()->getParent();
+
+    // Every division of a function shares one block that reports it
+    llvm::BasicBlock*& trap = m_division_traps[function];
+    if (trap == nullptr) {
+        llvm::IRBuilder<>::InsertPointGuard guard(m_builder);
+        trap = llvm::BasicBlock::Create(m_context, "division_by_zero", function);
+        llvm::BasicBlock* report = llvm::BasicBlock::Create(m_context, "report", function);
+        llvm::BasicBlock* stop = llvm::BasicBlock::Create(m_context, "trap", function);
+
+        llvm::FunctionType* hook_type = llvm::FunctionType::get(m_builder.getVoidTy(), { m_builder.getInt8PtrTy() }, false);
+        llvm::Function* hook = m_module->getFunction(DIVISION_BY_ZERO_HOOK);
+        if (hook == nullptr) {
+            hook = llvm::Function::Create(hook_type, llvm::GlobalValue::ExternalWeakLinkage, DIVISION_BY_ZERO_HOOK, *m_module);
+            hook->setDoesNotReturn();
+            hook->addFnAttr(llvm::Attribute::Cold);
+        }
+
+        m_builder.SetInsertPoint(trap);
+        m_builder.CreateCondBr(m_builder.CreateIsNotNull(hook), report, stop);
+
+        m_builder.SetInsertPoint(report);
+        m_builder.CreateCall(hook_type, hook, { m_builder.CreateGlobalStringPtr(function->getName()) });
+        m_builder.CreateUnreachable();
+
+        m_builder.SetInsertPoint(stop);
+        m_builder.CreateIntrinsic(llvm::Intrinsic::trap, {}, {});
+        m_builder.CreateUnreachable();
+    }
+
+    llvm::BasicBlock* next = llvm::BasicBlock::Create(m_context, "divide", function);
+    m_builder.CreateCondBr(m_builder.CreateIsNull(divisor), trap, next);
+    m_builder.SetInsertPoint(next);
+}
+
+Result<llvm::Value*, Error> CodeGen::lower_binary(const AstBinaryExpr* expr, llvm::Value* lhs, llvm::Value* rhs) {
+    const Type* lhs_type = expr->lhs->get_type();
+    const Type* rhs_type = expr->rhs->get_type();
+
+    // Shifts keep the type of the value and take an amount of any width
+    if (expr->op == Operator::SHIFT_LEFT || expr->op == Operator::SHIFT_RIGHT) {
+        const TypeInteger* value_type = utils::dyn_cast<TypeInteger>(lhs_type);
+        const TypeInteger* amount_type = utils::dyn_cast<TypeInteger>(rhs_type);
+        if (value_type == nullptr || amount_type == nullptr) {
+            return Err(unsupported_operator(expr->op));
+        }
+
+        // Shifting by the width or more is poison in LLVM. The VM takes
+        // amounts modulo the width, so this does too
+        llvm::Value* amount = m_builder.CreateIntCast(rhs, lhs->getType(), amount_type->is_signed);
+        amount = m_builder.CreateAnd(amount, llvm::ConstantInt::get(lhs->getType(), value_type->size * 8 - 1));
+        if (expr->op == Operator::SHIFT_LEFT) {
+            return Ok(m_builder.CreateShl(lhs, amount));
+        }
+        return Ok(value_type->is_signed ? m_builder.CreateAShr(lhs, amount) : m_builder.CreateLShr(lhs, amount));
+    }
+
+    // Both operands are brought to their coalesced type first. For
+    // arithmetic that is the type of the result, and for comparisons
+    // it is the type they are compared in
+    const Type* common = lhs_type;
+    if (lhs_type != rhs_type) {
+        ResultType coalesced = m_program.types().coalesce(lhs_type, rhs_type);
+        if (coalesced.is_err()) {
+            return Err(coalesced.unwrap_err());
+        }
+        common = coalesced.unwrap();
+        lhs = convert(lhs, lhs_type, common);
+        rhs = convert(rhs, rhs_type, common);
+    }
+
+    const TypeInteger* integer = utils::dyn_cast<TypeInteger>(common);
+    bool is_float = utils::isa<TypeFloat>(common);
+    bool is_signed = integer != nullptr && integer->is_signed;
+
+    if (is_float) {
+        switch (expr->op) {
+            case Operator::PLUS: return Ok(m_builder.CreateFAdd(lhs, rhs));
+            case Operator::MINUS: return Ok(m_builder.CreateFSub(lhs, rhs));
+            case Operator::MUL: return Ok(m_builder.CreateFMul(lhs, rhs));
+            case Operator::DIV: return Ok(m_builder.CreateFDiv(lhs, rhs));
+            case Operator::MOD: return Ok(m_builder.CreateFRem(lhs, rhs));
+            case Operator::EQUAL: return Ok(m_builder.CreateFCmpOEQ(lhs, rhs));
+            case Operator::NOT_EQUAL: return Ok(m_builder.CreateFCmpUNE(lhs, rhs));
+            case Operator::LESS_THAN: return Ok(m_builder.CreateFCmpOLT(lhs, rhs));
+            case Operator::GREATER_THAN: return Ok(m_builder.CreateFCmpOGT(lhs, rhs));
+            case Operator::LESS_EQUAL: return Ok(m_builder.CreateFCmpOLE(lhs, rhs));
+            case Operator::GREATER_EQUAL: return Ok(m_builder.CreateFCmpOGE(lhs, rhs));
+            default: return Err(unsupported_operator(expr->op));
+        }
+    }
+
+    // Integers and booleans
+    switch (expr->op) {
+        case Operator::PLUS: return Ok(m_builder.CreateAdd(lhs, rhs));
+        case Operator::MINUS: return Ok(m_builder.CreateSub(lhs, rhs));
+        case Operator::MUL: return Ok(m_builder.CreateMul(lhs, rhs));
+        case Operator::DIV:
+        case Operator::MOD: {
+            check_divisor(rhs);
+            bool is_div = expr->op == Operator::DIV;
+            if (!is_signed) {
+                return Ok(is_div ? m_builder.CreateUDiv(lhs, rhs) : m_builder.CreateURem(lhs, rhs));
+            }
+
+            // Dividing the smallest value by -1 overflows, which LLVM
+            // leaves undefined. It wraps around in the VM, so dividing 
+            // by -1 is negating and the remainder is always 0
+            llvm::Value* by_minus_one = m_builder.CreateICmpEQ(rhs, llvm::ConstantInt::getSigned(rhs->getType(), -1));
+            llvm::Value* divisor = m_builder.CreateSelect(by_minus_one, llvm::ConstantInt::get(rhs->getType(), 1), rhs);
+            if (is_div) {
+                return Ok(m_builder.CreateSelect(by_minus_one, m_builder.CreateNeg(lhs), m_builder.CreateSDiv(lhs, divisor)));
+            }
+            return Ok(m_builder.CreateSelect(by_minus_one, llvm::ConstantInt::get(lhs->getType(), 0), m_builder.CreateSRem(lhs, divisor)));
+        }
+        case Operator::BINARY_AND: return Ok(m_builder.CreateAnd(lhs, rhs));
+        case Operator::BINARY_OR: return Ok(m_builder.CreateOr(lhs, rhs));
+        case Operator::BINARY_XOR: return Ok(m_builder.CreateXor(lhs, rhs));
+        case Operator::EQUAL: return Ok(m_builder.CreateICmpEQ(lhs, rhs));
+        case Operator::NOT_EQUAL: return Ok(m_builder.CreateICmpNE(lhs, rhs));
+        case Operator::LESS_THAN: return Ok(is_signed ? m_builder.CreateICmpSLT(lhs, rhs) : m_builder.CreateICmpULT(lhs, rhs));
+        case Operator::GREATER_THAN: return Ok(is_signed ? m_builder.CreateICmpSGT(lhs, rhs) : m_builder.CreateICmpUGT(lhs, rhs));
+        case Operator::LESS_EQUAL: return Ok(is_signed ? m_builder.CreateICmpSLE(lhs, rhs) : m_builder.CreateICmpULE(lhs, rhs));
+        case Operator::GREATER_EQUAL: return Ok(is_signed ? m_builder.CreateICmpSGE(lhs, rhs) : m_builder.CreateICmpUGE(lhs, rhs));
+        default: return Err(unsupported_operator(expr->op));
+    }
+}
+
+} // namespace backend
+
+namespace core {
+
+Result<std::unique_ptr<llvm::Module>, Error>
+Program::generate_llvm(llvm::LLVMContext& context, std::string_view module_name) {
+    backend::CodeGen codegen(*this, context, module_name);
+    Result<Unit, Error> lowered = codegen.lower();
+    if (lowered.is_err()) {
+        return Err(lowered.unwrap_err());
+    }
+    return Ok(codegen.take_module());
+}
+
+} // namespace core
+} // namespace compiler
+
+#endif // Q_NO_LLVM
@@ -0,0 +1,103 @@
+#pragma once
+#include "defines.h"
+#include "core/ast.h"
+#include "core/error.h"
+#include "core/result.h"
+#include "core/type.h"
+#include <llvm/IR/DIBuilder.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+
+namespace compiler {
+namespace backend {
+
+using core::Error;
+using core::Result;
+using core::Unit;
+
+/// Generated code calls this with the name of the function it is in
+/// when it divides an integer by zero, like the bytecode VM reports it.
+/// The reference is weak, so objects also link without it. Code that
+/// runs without it traps instead
+constexpr const char* DIVISION_BY_ZERO_HOOK = "craft_division_by_zero";
+
+/// Lowers an analyzed program to LLVM IR.
+/// Every top level `let` becomes a global of the LLVM type that its
+/// Craft type maps to: `iN` and `uN` to an N bit integer, `f32` and
+/// `f64` to float and double, and booleans to i1. A value that was
+/// folded to a literal is the initializer of its global. Any other
+/// value is computed in a module constructor, in source order.
+/// Every `define` becomes a function of the same name, whose locals
+/// live in stack slots that mem2reg turns into registers.
+class CodeGen {
+public:
+    CodeGen(core::Program& program, llvm::LLVMContext& context, std::string_view module_name);
+
+    /// Describe each function and the line of each of its statements
+    /// in DWARF, so tools that read line tables can map machine code
+    /// back to `source_path`. Has to be called before lowering
+    void enable_debug_info(std::string_view source_path);
+
+    /// Lower every top level node of the program
+    Result<Unit, Error> lower();
+
+    /// Lower one codegen unit of the program. Every global and function
+    /// is declared, but only `functions` get bodies, and the globals are 
+    /// only defined if `define_globals` is set. Everything else is left
+    /// to the modules of other units, which this one gets linked with
+    Result<Unit, Error> lower_unit(std::span<const core::AstFunctionDecl* const> functions, bool define_globals);
+
+    /// Hand over the module. The generator cannot be used afterwards
+    std::unique_ptr<llvm::Module> take_module() { return std::move(m_module); }
+
+private:
+    /// Where the value of a declaration is kept
+    struct Storage {
+        llvm::Value* value;  // the value itself, or its address
+        llvm::Type* type;
+        bool is_address;     // globals and locals are loaded from memory
+    };
+
+    Result<Unit, Error> declare_function(const core::AstFunctionDecl* decl);
+    Result<Unit, Error> lower_global(const core::AstVarDecl* decl, bool define);
+    Result<Unit, Error> lower_function(const core::AstFunctionDecl* decl);
+    Result<llvm::Type*, Error> lower_type(const core::Type* type);
+    Result<llvm::Value*, Error> lower_expr(const core::AstExpr* root);
+    Result<llvm::Value*, Error> lower_binary(const core::AstBinaryExpr* expr, llvm::Value* lhs, llvm::Value* rhs);
+    Result<llvm::Value*, Error> lower_prefix(const core::AstPrefixExpr* expr, llvm::Value* rhs);
+
+    /// The literal as an LLVM constant, or null if `expr` is not a literal
+    llvm::Constant* lower_literal(const core::AstExpr* expr, llvm::Type* type);
+
+    /// Convert a numeric value between Craft types
+    llvm::Value* convert(llvm::Value* value, const core::Type* from, const core::Type* to);
+
+    /// The function that computes non constant globals. Made on first use
+    llvm::Function* init_function();
+
+    /// Go on only if the integer `divisor` is not zero, and otherwise
+    /// to the block of the current function that reports it
+    void check_divisor(llvm::Value* divisor);
+
+    core::Program& m_program;
+    llvm::LLVMContext& m_context;
+    std::unique_ptr<llvm::Module> m_module;
+    llvm::IRBuilder<> m_builder;
+    llvm::Function* m_init = nullptr;
+
+    // Only set when debug info is enabled
+    std::unique_ptr<llvm::DIBuilder> m_debug;
+    llvm::DIFile* m_debug_file = nullptr;
+
+    std::unordered_map<const core::AstNode*, Storage> m_storage;
+    std::unordered_map<const core::AstFunctionDecl*, llvm::Function*> m_functions;
+    std::unordered_map<llvm::Function*, llvm::BasicBlock*> m_division_traps;
+};
+
+} // namespace backend
+} // namespace compiler
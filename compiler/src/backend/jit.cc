@@ -0,0 +1,192 @@
+#ifndef Q_NO_LLVM
+#include "jit.h"
+#include "codegen.h"
+#include "perf_map.h"
+#include "core/logger.h"
+#include <llvm/Config/llvm-config.h>
+#include <llvm/ExecutionEngine/JITEventListener.h>
+#include <llvm/ExecutionEngine/Orc/Core.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/ExecutionEngine/SectionMemoryManager.h>
+#include <llvm/Support/Error.h>
+#include <vector>
+
+namespace compiler {
+namespace backend {
+
+using namespace core;
+
+/// Called by JIT-compiled code that divides an integer by zero. The VM
+/// stops the program with the same error
+extern "C" [[noreturn]] void
+craft_division_by_zero(const char* function) {
+    Error(ErrorCode::IntegerDivisionByZero, { DiagnosticArg::text(function) }).emit();
+    exit(EXIT_FAILURE);
+}
+
+/// Turn an LLVM error into ours. Consumes `error`
+static Error
+jit_error(llvm::Error error) {
+    return Error(ErrorCode::JitFailed, { DiagnosticArg::text(llvm::toString(std::move(error))) });
+}
+
+Result<i32, Error> run_jit(Program& program, const JitOptions& options) {
+    Result<const AstFunctionDecl*, Error> main_res = program.entry_point();
+    if (main_res.is_err()) {
+        return Err(main_res.unwrap_err());
+    }
+
+    auto context = std::make_unique<llvm::LLVMContext>();
+    CodeGen codegen(program, *context, "craft");
+    if (options.jitdump) {
+        codegen.enable_debug_info(options.source_path);
+    }
+    Result<Unit, Error> lowered = codegen.lower();
+    if (lowered.is_err()) {
+        return Err(lowered.unwrap_err());
+    }
+    std::unique_ptr<llvm::Module> module = codegen.take_module();
+
+    // Listeners have to outlive the JIT, which tells them about
+    // each object it loads
+    std::unique_ptr<PerfMapListener> perf_map;
+    std::vector<llvm::JITEventListener*> listeners;
+    if (options.perf_map) {
+        perf_map = std::make_unique<PerfMapListener>();
+        listeners.push_back(perf_map.get());
+    }
+    if (options.jitdump) {
+        // Owned by LLVM. Null when LLVM was built without perf support
+        llvm::JITEventListener* jitdump = llvm::JITEventListener::createPerfJITEventListener();
+        if (jitdump != nullptr) {
+            listeners.push_back(jitdump);
+        } else {
+            logger::Warn("This build of LLVM cannot write jitdump files");
+        }
+    }
+
+    initialize_native_target();
+    llvm::orc::LLLazyJITBuilder builder;
+
+    // Instruction selection and register allocation run at the
+    // level that was asked for, not at the default one
+    OptLevel level = options.level;
+    llvm::Expected<llvm::orc::JITTargetMachineBuilder> machine_builder = llvm::orc::JITTargetMachineBuilder::detectHost();
+    if (!machine_builder) {
+        return Err(jit_error(machine_builder.takeError()));
+    }
+    machine_builder->setCodeGenOptLevel(codegen_level(level));
+    builder.setJITTargetMachineBuilder(std::move(machine_builder.get()));
+    if (!listeners.empty()) {
+        builder.setObjectLinkingLayerCreator(
+            [&listeners](llvm::orc::ExecutionSession& session, const llvm::Triple&) {
+                auto layer = std::make_unique<llvm::orc::RTDyldObjectLinkingLayer>(
+#if LLVM_VERSION_MAJOR >= 19
+                    session, [](const llvm::MemoryBuffer&) { return std::make_unique<llvm::SectionMemoryManager>(); }
+#else
+                    session, [] { return std::make_unique<llvm::SectionMemoryManager>(); }
+#endif
+                );
+                for (llvm::JITEventListener* listener : listeners) {
+                    layer->registerJITEventListener(*listener);
+                }
+                return llvm::Expected<std::unique_ptr<llvm::orc::ObjectLayer>>(std::move(layer));
+            }
+        );
+    }
+
+    llvm::Expected<std::unique_ptr<llvm::orc::LLLazyJIT>> jit_res = builder.create();
+    if (!jit_res) {
+        return Err(jit_error(jit_res.takeError()));
+    }
+    std::unique_ptr<llvm::orc::LLLazyJIT> jit = std::move(jit_res.get());
+
+    // The lazy layer splits the module into one piece per function
+    // before this layer sees it, so each function is optimized
+    // when it gets compiled. The JIT compiles on this thread only,
+    // which makes sharing one target machine safe. Even at -O0 locals
+    // are promoted to registers, since selecting instructions for
+    // code that keeps every value on the stack is far slower
+    if (level == OptLevel::O0) {
+        jit->getIRTransformLayer().setTransform(
+            [](llvm::orc::ThreadSafeModule piece, llvm::orc::MaterializationResponsibility&) {
+                piece.withModuleDo([](llvm::Module& piece_module) {
+                    promote_to_registers(piece_module);
+                });
+                return llvm::Expected<llvm::orc::ThreadSafeModule>(std::move(piece));
+            }
+        );
+    } else {
+        Result<std::unique_ptr<llvm::TargetMachine>, Error> machine_res = create_host_machine(level);
+        if (machine_res.is_err()) {
+            return Err(machine_res.unwrap_err());
+        }
+        std::shared_ptr<llvm::TargetMachine> machine = machine_res.unwrap();
+
+        jit->getIRTransformLayer().setTransform(
+            [machine, level](llvm::orc::ThreadSafeModule piece, llvm::orc::MaterializationResponsibility&) {
+                piece.withModuleDo([&](llvm::Module& piece_module) {
+                    optimize(piece_module, *machine, level);
+                });
+                return llvm::Expected<llvm::orc::ThreadSafeModule>(std::move(piece));
+            }
+        );
+    }
+
+    // Operators like `%` on floats become calls into the C library
+    llvm::Expected<std::unique_ptr<llvm::orc::DynamicLibrarySearchGenerator>> process_symbols =
+        llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(jit->getDataLayout().getGlobalPrefix());
+    if (!process_symbols) {
+        return Err(jit_error(process_symbols.takeError()));
+    }
+    jit->getMainJITDylib().addGenerator(std::move(process_symbols.get()));
+
+#if LLVM_VERSION_MAJOR >= 17
+    llvm::orc::ExecutorSymbolDef hook(llvm::orc::ExecutorAddr::fromPtr(&craft_division_by_zero), llvm::JITSymbolFlags::Exported);
+#else
+    llvm::JITEvaluatedSymbol hook(llvm::pointerToJITTargetAddress(&craft_division_by_zero), llvm::JITSymbolFlags::Exported);
+#endif
+    llvm::Error defined = jit->getMainJITDylib().define(
+        llvm::orc::absoluteSymbols({ { jit->mangleAndIntern(DIVISION_BY_ZERO_HOOK), hook } })
+    );
+    if (defined) {
+        return Err(jit_error(std::move(defined)));
+    }
+
+    module->setDataLayout(jit->getDataLayout());
+    llvm::orc::ThreadSafeModule jit_module(std::move(module), std::move(context));
+    if (llvm::Error error = jit->addLazyIRModule(std::move(jit_module))) {
+        return Err(jit_error(std::move(error)));
+    }
+
+    // Runs the module constructor that computes the globals
+    llvm::orc::JITDylib& main_dylib = jit->getMainJITDylib();
+    if (llvm::Error error = jit->initialize(main_dylib)) {
+        return Err(jit_error(std::move(error)));
+    }
+
+    auto symbol = jit->lookup("main");
+    if (!symbol) {
+        return Err(jit_error(symbol.takeError()));
+    }
+#if LLVM_VERSION_MAJOR >= 15
+    auto entry = symbol->toPtr<i32 (*)()>();
+#else
+    auto entry = reinterpret_cast<i32 (*)()>(symbol->getAddress());
+#endif
+    i32 exit_code = entry();
+
+    if (llvm::Error error = jit->deinitialize(main_dylib)) {
+        return Err(jit_error(std::move(error)));
+    }
+    return Ok(exit_code);
+}
+
+} // namespace backend
+} // namespace compiler
+
+#endif // Q_NO_LLVM
@@ -0,0 +1,28 @@
+#pragma once
+#include "defines.h"
+#include "core/ast.h"
+#include "core/error.h"
+#include "core/result.h"
+#include "target.h"
+#include <string>
+
+namespace compiler {
+namespace backend {
+
+/// How the JIT compiles a program, and what it tells profilers
+struct JitOptions {
+    OptLevel level = OptLevel::O0;
+    bool perf_map = false;   // write /tmp/perf-<pid>.map
+    bool jitdump = false;    // write a jitdump with line tables for `perf inject --jit`
+    std::string source_path; // file the line tables refer to
+};
+
+/// Compile an analyzed program in memory with LLVM's lazy ORC JIT and
+/// call its `define main(): i32`, returning what it returned.
+/// Each function is only compiled, and optimized, the first time it
+/// is called, so starting a script does not get slower as the program
+/// grows. Globals are set up before `main` runs
+Result<i32, Error> run_jit(core::Program& program, const JitOptions& options);
+
+} // namespace backend
+} // namespace compiler
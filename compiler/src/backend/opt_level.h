@@ -0,0 +1,16 @@
+#pragma once
+#include "defines.h"
+
+namespace compiler {
+namespace backend {
+
+/// Optimization level picked with `-O0` to `-O3`
+enum class OptLevel : u8 {
+    O0,
+    O1,
+    O2,
+    O3,
+};
+
+} // namespace backend
+} // namespace compiler
@@ -0,0 +1,69 @@
+#ifndef Q_NO_LLVM
+#include "perf_map.h"
+#include "core/logger.h"
+#include "platform/platform.h"
+#include <llvm/Object/SymbolSize.h>
+#include <format>
+
+namespace compiler {
+namespace backend {
+
+PerfMapListener::PerfMapListener() {
+    std::string path = std::format("/tmp/perf-{}.map", platform::process_id());
+    m_file = fopen(path.c_str(), "w");
+    if (m_file == nullptr) {
+        core::logger::Warn("Could not open perf map '{}'", path);
+    }
+}
+
+PerfMapListener::~PerfMapListener() {
+    if (m_file != nullptr) {
+        fclose(m_file);
+    }
+}
+
+void PerfMapListener::notifyObjectLoaded(
+    ObjectKey key, const llvm::object::ObjectFile& object, 
+    const llvm::RuntimeDyld::LoadedObjectInfo& info
+) {
+    if (m_file == nullptr) {
+        return;
+    }
+
+    // The copy made for debuggers has the addresses the code was loaded at
+    llvm::object::OwningBinary<llvm::object::ObjectFile> loaded = info.getObjectForDebug(object);
+    if (loaded.getBinary() == nullptr) {
+        return;
+    }
+
+    std::lock_guard lock(m_mutex);
+    for (const auto& [symbol, size] : llvm::object::computeSymbolSizes(*loaded.getBinary())) {
+        llvm::Expected<llvm::object::SymbolRef::Type> type = symbol.getType();
+        if (!type || *type != llvm::object::SymbolRef::ST_Function) {
+            llvm::consumeError(type.takeError());
+            continue;
+        }
+
+        llvm::Expected<llvm::StringRef> name = symbol.getName();
+        llvm::Expected<u64> address = symbol.getAddress();
+        if (!name || !address) {
+            llvm::consumeError(name.takeError());
+            llvm::consumeError(address.takeError());
+            continue;
+        }
+
+        fprintf(
+            m_file, "%llx %llx %.*s\n", 
+            static_cast<unsigned long long>(*address), static_cast<unsigned long long>(size), 
+            static_cast<int>(name->size()), name->data()
+        );
+    }
+
+    // perf may read the map while the program is still running
+    fflush(m_file);
+}
+
+} // namespace backend
+} // namespace compiler
+
+#endif // Q_NO_LLVM
@@ -0,0 +1,36 @@
+#pragma once
+#include "defines.h"
+#include <llvm/ExecutionEngine/JITEventListener.h>
+#include <cstdio>
+#include <mutex>
+
+namespace compiler {
+namespace backend {
+
+/// Writes `/tmp/perf-<pid>.map` for code that the JIT loads. `perf report`
+/// reads the file to put names on samples in code that has no symbols of
+/// its own. Each line is the start and size of a function in hex, then
+/// its name
+class PerfMapListener : public llvm::JITEventListener {
+public:
+    PerfMapListener();
+    ~PerfMapListener() override;
+
+    PerfMapListener(const PerfMapListener&) = delete;
+    PerfMapListener& operator=(const PerfMapListener&) = delete;
+
+    /// Whether the map file could be opened
+    bool is_open() const { return m_file != nullptr; }
+
+    void notifyObjectLoaded(
+        ObjectKey key, const llvm::object::ObjectFile& object, 
+        const llvm::RuntimeDyld::LoadedObjectInfo& info
+    ) override;
+
+private:
+    std::mutex m_mutex; // objects can be loaded from several threads
+    FILE* m_file;
+};
+
+} // namespace backend
+} // namespace compiler
@@ -0,0 +1,140 @@
+#ifndef Q_NO_LLVM
+#include "target.h"
+#include <llvm/Config/llvm-config.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Passes/OptimizationLevel.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/Mem2Reg.h>
+#include <mutex>
+
+#if LLVM_VERSION_MAJOR >= 17
+#include <llvm/TargetParser/Host.h>
+#else
+#include <llvm/Support/Host.h>
+#endif
+
+namespace compiler {
+namespace backend {
+
+using core::DiagnosticArg;
+using core::Err;
+using core::ErrorCode;
+using core::Ok;
+
+#if LLVM_VERSION_MAJOR >= 18
+constexpr llvm::CodeGenFileType OBJECT_FILE = llvm::CodeGenFileType::ObjectFile;
+#else
+constexpr llvm::CodeGenFileType OBJECT_FILE = llvm::CGFT_ObjectFile;
+#endif
+
+CodeGenLevel codegen_level(OptLevel level) {
+    switch (level) {
+        case OptLevel::O0: return CodeGenLevel::None;
+        case OptLevel::O1: return CodeGenLevel::Less;
+        case OptLevel::O2: return CodeGenLevel::Default;
+        case OptLevel::O3: return CodeGenLevel::Aggressive;
+    }
+    return CodeGenLevel::Default;
+}
+
+static llvm::OptimizationLevel
+pipeline_level(OptLevel level) {
+    switch (level) {
+        case OptLevel::O0: return llvm::OptimizationLevel::O0;
+        case OptLevel::O1: return llvm::OptimizationLevel::O1;
+        case OptLevel::O2: return llvm::OptimizationLevel::O2;
+        case OptLevel::O3: return llvm::OptimizationLevel::O3;
+    }
+    return llvm::OptimizationLevel::O2;
+}
+
+void initialize_native_target() {
+    static std::once_flag initialized;
+    std::call_once(initialized, [] {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+    });
+}
+
+Result<std::unique_ptr<llvm::TargetMachine>, Error> create_host_machine(OptLevel level) {
+    initialize_native_target();
+
+    std::string triple = llvm::sys::getDefaultTargetTriple();
+    std::string message;
+    const llvm::Target* target = llvm::TargetRegistry::lookupTarget(triple, message);
+    if (target == nullptr) {
+        return Err(Error(ErrorCode::NoTarget, { DiagnosticArg::text(triple), DiagnosticArg::text(message) }));
+    }
+
+    // Objects are built for the generic CPU, so they run on any
+    // machine with the same triple
+    llvm::TargetOptions options;
+    std::unique_ptr<llvm::TargetMachine> machine(target->createTargetMachine(
+        triple, "generic", "", options, llvm::Reloc::PIC_, {}, codegen_level(level)
+    ));
+    return Ok(std::move(machine));
+}
+
+void optimize(llvm::Module& module, llvm::TargetMachine& machine, OptLevel level) {
+    module.setDataLayout(machine.createDataLayout());
+    module.setTargetTriple(machine.getTargetTriple().str());
+
+    // These have to be declared in this order,
+    // so they are destroyed in the reverse one
+    llvm::LoopAnalysisManager loops;
+    llvm::FunctionAnalysisManager functions;
+    llvm::CGSCCAnalysisManager sccs;
+    llvm::ModuleAnalysisManager modules;
+
+    llvm::PassBuilder builder(&machine);
+    builder.registerModuleAnalyses(modules);
+    builder.registerCGSCCAnalyses(sccs);
+    builder.registerFunctionAnalyses(functions);
+    builder.registerLoopAnalyses(loops);
+    builder.crossRegisterProxies(loops, functions, sccs, modules);
+
+    llvm::ModulePassManager passes = level == OptLevel::O0
+        ? builder.buildO0DefaultPipeline(llvm::OptimizationLevel::O0)
+        : builder.buildPerModuleDefaultPipeline(pipeline_level(level));
+    passes.run(module, modules);
+}
+
+void promote_to_registers(llvm::Module& module) {
+    llvm::FunctionAnalysisManager functions;
+    llvm::PassBuilder builder;
+    builder.registerFunctionAnalyses(functions);
+
+    llvm::FunctionPassManager passes;
+    passes.addPass(llvm::PromotePass());
+    for (llvm::Function& function : module) {
+        if (!function.isDeclaration()) {
+            passes.run(function, functions);
+        }
+    }
+}
+
+Result<Unit, Error> emit_object(llvm::Module& module, llvm::TargetMachine& machine, const std::string& path) {
+    std::error_code error;
+    llvm::raw_fd_ostream out(path, error, llvm::sys::fs::OF_None);
+    if (error) {
+        return Err(Error(ErrorCode::CannotOpenOutput, { DiagnosticArg::text(path), DiagnosticArg::text(error.message()) }));
+    }
+
+    // Machine code is still emitted through the legacy pass manager
+    llvm::legacy::PassManager passes;
+    if (machine.addPassesToEmitFile(passes, out, nullptr, OBJECT_FILE)) {
+        return Err(Error(ErrorCode::CannotEmitObject));
+    }
+    passes.run(module);
+    out.flush();
+    return Ok(Unit());
+}
+
+} // namespace backend
+} // namespace compiler
+
+#endif // Q_NO_LLVM
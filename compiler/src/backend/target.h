@@ -0,0 +1,47 @@
+#pragma once
+#include "defines.h"
+#include "core/error.h"
+#include "core/result.h"
+#include "opt_level.h"
+#include <llvm/Config/llvm-config.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Target/TargetMachine.h>
+#include <memory>
+#include <string>
+
+namespace compiler {
+namespace backend {
+
+using core::Error;
+using core::Result;
+using core::Unit;
+
+#if LLVM_VERSION_MAJOR >= 18
+using CodeGenLevel = llvm::CodeGenOptLevel;
+#else
+using CodeGenLevel = llvm::CodeGenOpt::Level;
+#endif
+
+/// The level instructions are selected and registers allocated at
+CodeGenLevel codegen_level(OptLevel level);
+
+/// Register the host target with LLVM. Safe to call any number of times
+void initialize_native_target();
+
+/// Make a machine that generates code for the host, tuned for `level`
+Result<std::unique_ptr<llvm::TargetMachine>, Error> create_host_machine(OptLevel level);
+
+/// Set the module up for `machine` and run the new pass manager's
+/// default pipeline for `level` over it
+void optimize(llvm::Module& module, llvm::TargetMachine& machine, OptLevel level);
+
+/// Only promote the locals of every function from stack slots to
+/// registers, which is the least that keeps unoptimized code fast to
+/// select instructions for
+void promote_to_registers(llvm::Module& module);
+
+/// Write the module as an object file at `path`
+Result<Unit, Error> emit_object(llvm::Module& module, llvm::TargetMachine& machine, const std::string& path);
+
+} // namespace backend
+} // namespace compiler
@@ -0,0 +1,123 @@
+#ifndef Q_NO_LLVM
+#include "units.h"
+#include "codegen.h"
+#include "core/thread_pool.h"
+#include "core/utils.h"
+#include "platform/platform.h"
+#include <filesystem>
+#include <format>
+#include <optional>
+
+namespace compiler {
+namespace backend {
+
+using namespace core;
+
+std::vector<std::vector<const AstFunctionDecl*>>
+partition_units(const Program& program, usize count) {
+    std::vector<const AstFunctionDecl*> functions;
+    usize total_cost = 0;
+    for (const AstNode* node : program.nodes()) {
+        if (const AstFunctionDecl* function = utils::dyn_cast<AstFunctionDecl>(node)) {
+            functions.push_back(function);
+            total_cost += function->body.size() + 1;
+        }
+    }
+
+    count = std::max<usize>(count, 1);
+    usize target_cost = (total_cost + count - 1) / count;
+
+    std::vector<std::vector<const AstFunctionDecl*>> units(1);
+    usize unit_cost = 0;
+    for (const AstFunctionDecl* function : functions) {
+        if (unit_cost >= target_cost && units.size() < count) {
+            units.emplace_back();
+            unit_cost = 0;
+        }
+        units.back().push_back(function);
+        unit_cost += function->body.size() + 1;
+    }
+    return units;
+}
+
+/// Lower, optimize and emit one unit. Everything LLVM makes for it
+/// lives in its own context, so units can be compiled side by side
+static Result<Unit, Error>
+compile_unit(
+    Program& program, std::span<const AstFunctionDecl* const> functions,
+    bool define_globals, OptLevel level, const std::string& path
+) {
+    llvm::LLVMContext context;
+    CodeGen codegen(program, context, path);
+    Result<Unit, Error> lowered = codegen.lower_unit(functions, define_globals);
+    if (lowered.is_err()) {
+        return lowered;
+    }
+    std::unique_ptr<llvm::Module> module = codegen.take_module();
+
+    // Target machines are not thread safe, so each unit makes its own
+    Result<std::unique_ptr<llvm::TargetMachine>, Error> machine_res = create_host_machine(level);
+    if (machine_res.is_err()) {
+        return Err(machine_res.unwrap_err());
+    }
+    std::unique_ptr<llvm::TargetMachine> machine = machine_res.unwrap();
+
+    optimize(*module, *machine, level);
+    return emit_object(*module, *machine, path);
+}
+
+Result<Unit, Error> compile_units(
+    Program& program, usize units, usize jobs,
+    OptLevel level, const std::string& output
+) {
+    std::vector<std::vector<const AstFunctionDecl*>> partitions = partition_units(program, units);
+
+    std::vector<std::string> paths;
+    for (usize i = 0; i < partitions.size(); i++) {
+        paths.push_back(std::format("{}.{}.o", output, i));
+    }
+
+    std::vector<std::optional<Error>> errors(partitions.size());
+    ThreadPool pool(jobs);
+    pool.parallel_for(partitions.size(), 1, [&](usize begin, usize end, usize) {
+        for (usize i = begin; i < end; i++) {
+            Result<Unit, Error> compiled = compile_unit(program, partitions[i], i == 0, level, paths[i]);
+            if (compiled.is_err()) {
+                errors[i] = compiled.unwrap_err();
+            }
+        }
+    });
+
+    std::optional<Error> error;
+    for (const std::optional<Error>& unit_error : errors) {
+        if (unit_error.has_value()) {
+            error = unit_error;
+            break;
+        }
+    }
+
+    // A relocatable link keeps the result an object like the one
+    // a single unit would have made
+    if (!error.has_value()) {
+        std::vector<std::string> args = { "ld", "-r", "-o", output };
+        args.insert(args.end(), paths.begin(), paths.end());
+        if (platform::run_process(args) != 0) {
+            error = Error(ErrorCode::LinkFailed, { DiagnosticArg::text(output) });
+        }
+    }
+
+    std::error_code ignored;
+    for (const std::string& path : paths) {
+        std::filesystem::remove(path, ignored);
+    }
+
+    if (error.has_value()) {
+        return Err(error.value());
+    }
+    return Ok(Unit());
+}
+
+} // namespace backend
+} // namespace compiler
+
+#endif // Q_NO_LLVM
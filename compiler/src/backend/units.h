@@ -0,0 +1,33 @@
+#pragma once
+#include "defines.h"
+#include "core/ast.h"
+#include "core/error.h"
+#include "core/result.h"
+#include "target.h"
+#include <string>
+#include <vector>
+
+namespace compiler {
+namespace backend {
+
+/// Split the functions of a program into at most `count` codegen units.
+/// Each unit is a run of neighbouring functions, and the units have
+/// about the same number of statements. There is always at least one
+/// unit, and the first one also gets the globals
+std::vector<std::vector<const core::AstFunctionDecl*>>
+partition_units(const core::Program& program, usize count);
+
+/// Compile a program as separate codegen units. Each unit is lowered
+/// into a module and LLVM context of its own, then optimized and
+/// compiled to an object on a thread of the pool, with up to `jobs`
+/// threads (zero means one per hardware thread). The objects are
+/// linked into one relocatable object at `output`.
+/// Units cannot inline functions from each other, so this trades
+/// some optimization across functions for backend time
+Result<Unit, Error> compile_units(
+    core::Program& program, usize units, usize jobs,
+    OptLevel level, const std::string& output
+);
+
+} // namespace backend
+} // namespace compiler
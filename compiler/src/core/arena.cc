@@ -0,0 +1,52 @@
+#include "arena.h"
+#include <cstdlib>
+
+namespace compiler {
+namespace core {
+
+Arena::~Arena() {
+    Block* block = m_blocks;
+    while (block) {
+        Block* next = block->next;
+        std::free(block);
+        block = next;
+    }
+}
+
+/// Start a new block that is large enough for the allocation
+void* Arena::allocate_slow(usize size, usize alignment) {
+    usize needed = size + alignment + sizeof(Block);
+    usize block_size = needed > m_block_size ? needed : m_block_size;
+
+    Block* block = static_cast<Block*>(std::malloc(block_size));
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    block->next = m_blocks;
+    block->size = block_size;
+    m_blocks = block;
+
+    m_cursor = reinterpret_cast<char*>(block + 1);
+    m_end = reinterpret_cast<char*>(block) + block_size;
+    return allocate(size, alignment);
+}
+
+void Arena::reset() {
+    if (m_blocks == nullptr) {
+        return;
+    }
+
+    // Keep the oldest block around for reuse and free the rest
+    while (m_blocks->next) {
+        Block* next = m_blocks->next;
+        std::free(m_blocks);
+        m_blocks = next;
+    }
+
+    m_cursor = reinterpret_cast<char*>(m_blocks + 1);
+    m_end = reinterpret_cast<char*>(m_blocks) + m_blocks->size;
+    m_used = 0;
+}
+
+} // namespace core
+} // namespace compiler
@@ -0,0 +1,91 @@
+#pragma once
+#include "defines.h"
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace compiler {
+namespace core {
+
+/// Bump pointer allocator. Memory is handed out from large blocks and 
+/// is only given back all at once, by `reset()` or when the arena is
+/// destroyed. Destructors of objects made in the arena are never run,
+/// so they must not own memory outside of it.
+class Arena {
+public:
+    static constexpr usize DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    explicit Arena(usize block_size = DEFAULT_BLOCK_SIZE) noexcept
+        : m_block_size(block_size) {}
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /// Get `size` bytes aligned to `alignment`, which must be a power of two
+    void* allocate(usize size, usize alignment) {
+        uintptr_t cursor = reinterpret_cast<uintptr_t>(m_cursor);
+        uintptr_t aligned = (cursor + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+
+        if (m_cursor == nullptr || aligned + size > reinterpret_cast<uintptr_t>(m_end)) {
+            return allocate_slow(size, alignment);
+        }
+
+        m_cursor = reinterpret_cast<char*>(aligned + size);
+        m_used += size;
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    /// Construct a T in the arena
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    /// Copy a string into the arena
+    std::string_view copy_string(std::string_view str) {
+        char* data = static_cast<char*>(allocate(str.length(), 1));
+        std::memcpy(data, str.data(), str.length());
+        return std::string_view(data, str.length());
+    }
+
+    /// Copy the elements of a vector into the arena.
+    /// T must be trivially destructible, like everything else in here
+    template <typename T>
+    std::span<T> copy_array(const std::vector<T>& items) {
+        if (items.empty()) {
+            return {};
+        }
+        T* data = static_cast<T*>(allocate(sizeof(T) * items.size(), alignof(T)));
+        std::uninitialized_copy(items.begin(), items.end(), data);
+        return std::span<T>(data, items.size());
+    }
+
+    /// Release everything allocated so far. The first block is kept for reuse
+    void reset();
+
+    /// Number of bytes handed out since the last reset
+    usize bytes_used() const { return m_used; }
+
+private:
+    struct Block {
+        Block* next;
+        usize size;
+    };
+
+    void* allocate_slow(usize size, usize alignment);
+
+    Block* m_blocks = nullptr;  // most recent block first
+    char* m_cursor = nullptr;
+    char* m_end = nullptr;
+    usize m_block_size;
+    usize m_used = 0;
+};
+
+} // namespace core
+} // namespace compiler
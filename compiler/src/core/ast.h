@@ -6,13 +6,26 @@
 #include "utils.h"
 #include "error.h"
 #include "result.h"
+#include "interner.h"
+#include "arena.h"
+#include "type_context.h"
+#include "symbol_table.h"
 #include <cstdio>
+#include <memory>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
 /* #include <llvm/ADT/APFloat.h> */
 
+namespace llvm {
+class LLVMContext;
+class Module;
+}
+
 namespace compiler {
 
 namespace core {
@@ -22,28 +35,105 @@ namespace core {
 struct Program;
 struct AstNode;
 struct AstVarDecl;
+struct AstFunctionDecl;
+class ExprRef;
 
-/// Type alias for analyzing a result
+/// Result of analyzing a node. It only says whether analysis succeeded:
+/// a node that analysis rewrites is replaced through the ExprRef that
+/// points at it, so the new node never has to be handed back.
 /// TODO: Add aliases for returning Result<>s of 
 ///       AST nodes when parsing
-using AnalyzeResult = Result<AstNode*, Error>;
+using AnalyzeResult = Result<Unit, Error>;
+
+// Every node returns one of these, so it has to stay cheap to pass around
+static_assert(std::is_trivially_copyable_v<AnalyzeResult>);
+
+/// State used while analyzing nodes. Each analysis thread has its own,
+/// with a symbol table whose parent holds the program's globals
+struct AnalysisContext {
+    SymbolTable& symbols;
+    TypeContext& types;
+    Arena& arena;                 // new nodes made by rewrites go here
+    AstNode* declaring = nullptr; // declaration whose value is being analyzed
+    AstFunctionDecl* function = nullptr; // function whose body is being analyzed
+};
 
-    /// Enumeration of the precedences of the 
+/// Tag of every concrete AST node, checked by `utils::isa<>` and friends.
+/// Expressions are kept together so `AstExpr` can be checked with a range
+enum class AstKind : u8 {
+    VarDecl,
+    ParamDecl,
+    FunctionDecl,
+    ReturnStmt,
+
+    BinaryExpr,
+    PrefixExpr,
+    BoolExpr,
+    IntegerExpr,
+    FloatExpr,
+    IdentifierExpr,
+    CallExpr,
+
+    FIRST_EXPR = BinaryExpr,
+    LAST_EXPR = CallExpr,
+};
+
+/// Enumeration of the precedences of the 
 /// operators. Essentially which "bind
-/// tighter"
+/// tighter". Later entries bind tighter.
 enum operator_precedence {
+    LOWEST,
+    ASSIGNMENT,
+    LOGICAL_OR,
+    LOGICAL_AND,
+    BITWISE_OR,
+    BITWISE_XOR,
+    BITWISE_AND,
+    EQUALITY,
+    COMPARISON,
+    SHIFT,
     ADDSUB,
     MULDIVMOD,
+    PREFIX,
 };
 
 /// Enumeration of valid operators
-/// TODO: Finish adding the rest of the operators
 enum class Operator : u8 {
     PLUS,
     MINUS,
     MUL,
     DIV,
     MOD,
+
+    SHIFT_LEFT,
+    SHIFT_RIGHT,
+    BINARY_AND,
+    BINARY_OR,
+    BINARY_XOR,
+    BINARY_NOT,
+
+    LOGICAL_AND,
+    LOGICAL_OR,
+    LOGICAL_NOT,
+
+    EQUAL,
+    NOT_EQUAL,
+    LESS_THAN,
+    GREATER_THAN,
+    LESS_EQUAL,
+    GREATER_EQUAL,
+
+    ASSIGN,
+    ASSIGN_PLUS,
+    ASSIGN_MINUS,
+    ASSIGN_MUL,
+    ASSIGN_DIV,
+    ASSIGN_MOD,
+    ASSIGN_BINARY_AND,
+    ASSIGN_BINARY_OR,
+    ASSIGN_BINARY_XOR,
+    ASSIGN_SHIFT_LEFT,
+    ASSIGN_SHIFT_RIGHT,
 };
 
 /// Utility function to get an operator as a string value
@@ -55,37 +145,77 @@ constexpr const char * operator_to_cstr(const Operator& op) {
         case Operator::MUL: return "*";
         case Operator::DIV: return "/";
         case Operator::MOD: return "%";
+        case Operator::SHIFT_LEFT: return "<<";
+        case Operator::SHIFT_RIGHT: return ">>";
+        case Operator::BINARY_AND: return "&";
+        case Operator::BINARY_OR: return "|";
+        case Operator::BINARY_XOR: return "^";
+        case Operator::BINARY_NOT: return "~";
+        case Operator::LOGICAL_AND: return "&&";
+        case Operator::LOGICAL_OR: return "||";
+        case Operator::LOGICAL_NOT: return "!";
+        case Operator::EQUAL: return "==";
+        case Operator::NOT_EQUAL: return "!=";
+        case Operator::LESS_THAN: return "<";
+        case Operator::GREATER_THAN: return ">";
+        case Operator::LESS_EQUAL: return "<=";
+        case Operator::GREATER_EQUAL: return ">=";
+        case Operator::ASSIGN: return "=";
+        case Operator::ASSIGN_PLUS: return "+=";
+        case Operator::ASSIGN_MINUS: return "-=";
+        case Operator::ASSIGN_MUL: return "*=";
+        case Operator::ASSIGN_DIV: return "/=";
+        case Operator::ASSIGN_MOD: return "%=";
+        case Operator::ASSIGN_BINARY_AND: return "&=";
+        case Operator::ASSIGN_BINARY_OR: return "|=";
+        case Operator::ASSIGN_BINARY_XOR: return "^=";
+        case Operator::ASSIGN_SHIFT_LEFT: return "<<=";
+        case Operator::ASSIGN_SHIFT_RIGHT: return ">>=";
     }
 
     return "__illegal_operator__";
 }
 
-/// Abstract interface class for AST Nodes
+/// Abstract interface class for AST Nodes.
+/// Nodes are allocated in the Program's arena and are freed all at
+/// once with it. Their destructors are never run, so nodes must not 
+/// own memory outside of the arena.
 struct AstNode {
 public:
-    AstNode() noexcept = default;
+    explicit AstNode(AstKind kind) noexcept : kind(kind) {}
     virtual ~AstNode() = 0;
 
-    virtual AnalyzeResult analyze() = 0;
+    virtual AnalyzeResult analyze(AnalysisContext& ctx) = 0;
     virtual void print(u32 indent) {}
+
+    const AstKind kind;
 };
 
 // Represents the program 
 struct Program {
 public:
     Program() noexcept = default;
-    ~Program() {
-        for (usize i = 0; i < m_nodes.size(); i++) {
-            delete m_nodes[i];
-        }
-        
+
+    /// Arena that the nodes of this program are allocated in
+    Arena& arena() { return m_arena; }
+
+    /// The canonical types used by this program
+    TypeContext& types() { return m_types; }
+
+    /// Free the whole tree at once
+    void reset() {
         m_nodes.clear();
+        m_arena.reset();
+        m_worker_arenas.clear();
     }
 
     void add_node(AstNode* node) {
         this->m_nodes.push_back(node);
     }
 
+    /// The top level nodes, in source order
+    const std::vector<AstNode*>& nodes() const { return m_nodes; }
+
     void print() {
         core::logger::Trace("Program:\nNumber of Nodes: {}", m_nodes.size());
         for (usize i = 0; i < m_nodes.size(); i++) {
@@ -94,29 +224,103 @@ public:
         }
     }
 
-    void analyze() {
-        for (usize i = 0; i < m_nodes.size(); i++) {
-            m_nodes[i]->analyze();
-        }
-    }
+    /// Analyze every top level node, using up to `jobs` threads 
+    /// (zero means one per hardware thread). Errors are reported 
+    /// in source order. Returns the number of errors
+    usize analyze(usize jobs = 1);
 
-    void generate_llvm() {
+    /// The `define main(): i32` that running the program calls
+    Result<const AstFunctionDecl*, Error> entry_point() const;
 
-    }
+#ifndef Q_NO_LLVM
+    /// Lower the analyzed program to an LLVM module named `module_name`. 
+    /// Defined in the backend
+    Result<std::unique_ptr<llvm::Module>, Error> 
+    generate_llvm(llvm::LLVMContext& context, std::string_view module_name);
+#endif
 
 private:
+    // Owns every node in the program
+    Arena m_arena;
+
+    // Nodes made by rewrites on analysis threads other than the main one
+    std::vector<std::unique_ptr<Arena>> m_worker_arenas;
+
+    // Owns every type in the program. Types outlive `reset()`
+    TypeContext m_types;
+
     // The top level nodes in a program
     std::vector<AstNode*> m_nodes;
 };
 
 
-/* Expressions evaluate to values */
+/// How far the typing of an expression has got
+enum class TypeState : u8 {
+    Unresolved,
+    InProgress,  // its operands are being typed
+    Resolved,    // `type` is final. It can still be null if it has no type
+};
+
+/* Expressions evaluate to values.
+ * Every expression is typed exactly once, by `analyze()`, and the 
+ * result is stored on the node, so `get_type()` is only a field read. */
 struct AstExpr : public AstNode {
+    explicit AstExpr(AstKind kind, const Type* type = nullptr) noexcept 
+        : AstNode(kind)
+          , type(type)
+          , state(type ? TypeState::Resolved : TypeState::Unresolved)
+        {}
     ~AstExpr() override {}
 
-    virtual const Type* get_type() { return nullptr; };
-    AnalyzeResult analyze() override;
+    static bool classof(const AstNode* node) {
+        return node->kind >= AstKind::FIRST_EXPR && node->kind <= AstKind::LAST_EXPR;
+    }
+
+    const Type* get_type() const { return type; }
+
+    /// Type the expression in `root` and every expression under it. 
+    /// The tree is walked with an explicit stack in post order, so each 
+    /// node is checked once after its operands, however deep the tree is.
+    /// Nodes that get rewritten are replaced in the slots that hold them
+    static AnalyzeResult analyze_tree(ExprRef root, AnalysisContext& ctx);
+
+    /// Analyze an expression that nothing else points at. It can be 
+    /// rewritten in place, but not replaced by a node somewhere else
+    AnalyzeResult analyze(AnalysisContext& ctx) final;
+
+    /// Check this node alone and set its type. Its operands have already
+    /// been analyzed. `self` is the slot that holds this node, and is used
+    /// to replace it
+    virtual AnalyzeResult check(ExprRef self, AnalysisContext& ctx) = 0;
     void print(u32 indent) override {}
+
+    const Type* type;
+    TypeState state;
+};
+
+/// Rewrite handle for an expression: the slot that points at it, which is
+/// an operand of its parent or the value of a declaration. Passes replace 
+/// nodes through this instead of returning new ones, so nothing is 
+/// allocated or freed when a node stays as it is.
+class ExprRef {
+public:
+    explicit ExprRef(AstExpr** slot) noexcept : m_slot(slot) {}
+
+    AstExpr* get() const { return *m_slot; }
+    AstExpr* operator->() const { return *m_slot; }
+
+    /// Point the slot at another node that already exists
+    void set(AstExpr* expr) { *m_slot = expr; }
+
+    /// Replace the expression with a new T. If a T fits in the storage of
+    /// the node it replaces it is built there, and only otherwise is a new
+    /// node allocated in `arena`. The old node is gone afterwards, so
+    /// anything needed from it must be read first
+    template <typename T, typename... Args>
+    T* replace(Arena& arena, Args... args);
+
+private:
+    AstExpr** m_slot;
 };
 
 /* Represents a binary operator like 
@@ -124,21 +328,14 @@ struct AstExpr : public AstNode {
  */
 struct AstBinaryExpr : public AstExpr {
     AstBinaryExpr(AstNode* lhs, Operator op, AstNode* rhs)
-        : lhs(dynamic_cast<AstExpr*>(lhs))
+        : AstExpr(AstKind::BinaryExpr)
+          , lhs(utils::dyn_cast<AstExpr>(lhs))
           , op(op)
-          , rhs(dynamic_cast<AstExpr*>(rhs))
-          , type(nullptr)
+          , rhs(utils::dyn_cast<AstExpr>(rhs))
         {}
-    ~AstBinaryExpr() override {
-        delete lhs;
-        delete rhs;
-        if (type) {
-            delete type;
-        }
-    }
     
-    const Type* get_type() override;
-    AnalyzeResult analyze() override;
+    AnalyzeResult check(ExprRef self, AnalysisContext& ctx) override;
+    static bool classof(const AstNode* node) { return node->kind == AstKind::BinaryExpr; }
     void print(u32 indent) override {
         printf("[");
         lhs->print(0);
@@ -150,7 +347,6 @@ struct AstBinaryExpr : public AstExpr {
     AstExpr* lhs;
     Operator op;
     AstExpr* rhs;
-    Type* type;
 };
 
 /* Prefix expression: 
@@ -159,28 +355,21 @@ struct AstBinaryExpr : public AstExpr {
  */
 struct AstPrefixExpr : public AstExpr {
     AstPrefixExpr(Operator op, AstNode* rhs)
-        : op(op)
-          , rhs(dynamic_cast<AstExpr*>(rhs))
-          , type(nullptr)
+        : AstExpr(AstKind::PrefixExpr)
+          , op(op)
+          , rhs(utils::dyn_cast<AstExpr>(rhs))
         {}
-    ~AstPrefixExpr() override {
-        delete rhs;
-
-        if (type) {
-            delete type;
-        }
-    }
 
-    const Type* get_type() override;
-    AnalyzeResult analyze() override;
+    AnalyzeResult check(ExprRef self, AnalysisContext& ctx) override;
+    static bool classof(const AstNode* node) { return node->kind == AstKind::PrefixExpr; }
     void print(u32 indent) override {
         printf("[%s", operator_to_cstr(op));
         rhs->print(0);
+        printf("]");
     }
 
     Operator op;
     AstExpr* rhs;
-    Type* type;
 };
 
 /* Variable declarations
@@ -188,20 +377,19 @@ struct AstPrefixExpr : public AstExpr {
  * `let name: std::string = "John";
  */
 struct AstVarDecl : public AstNode {
-    AstVarDecl(AstNode* target, std::optional<Type*> annotation, AstNode* value)
-        : target(target), 
+    AstVarDecl(AstNode* target, std::optional<const Type*> annotation, AstNode* value)
+        : AstNode(AstKind::VarDecl),
+        target(target), 
         type(annotation),
-        value(dynamic_cast<AstExpr*>(value))
+        value(utils::dyn_cast<AstExpr>(value))
         {}
-    ~AstVarDecl() override {
-        delete target;
-        if (type.has_value()) {
-            delete type.value();
-        }
-        delete value;
-    }
 
-    AnalyzeResult analyze() override;
+    AnalyzeResult analyze(AnalysisContext& ctx) override;
+    static bool classof(const AstNode* node) { return node->kind == AstKind::VarDecl; }
+
+    /// Add the name to the innermost scope with its annotated type,
+    /// before the value is analyzed
+    Result<AstVarDecl*, Error> declare(AnalysisContext& ctx);
     void print(u32 indent) override {
         printf("let ");
         target->print(0);
@@ -215,96 +403,223 @@ struct AstVarDecl : public AstNode {
     }
    
     AstNode* target;
-    std::optional<Type*> type;
+    std::optional<const Type*> type;
     AstExpr* value;
 };
 
 // Represents a boolean literal
 struct AstBoolExpr : public AstExpr {
-    AstBoolExpr(bool value)
-        : value(value)
-          , type(new TypeBoolean())
+    AstBoolExpr(bool value, const Type* type)
+        : AstExpr(AstKind::BoolExpr, type)
+          , value(value)
         {}
-    ~AstBoolExpr() override {
-        if (type) {
-            delete type;
-        }
-    }
 
-    const Type* get_type() override;
-    AnalyzeResult analyze() override;
+    AnalyzeResult check(ExprRef self, AnalysisContext& ctx) override;
+    static bool classof(const AstNode* node) { return node->kind == AstKind::BoolExpr; }
     void print(u32 indent) override {
         printf("%d", value);
     }
 
     bool value;
-    Type* type;
 };
 
 // Represents an integer literal
 struct AstIntegerExpr : public AstExpr {
-    AstIntegerExpr(u64 value)
-        : value(value)
-          , type(new TypeInteger(false, 64))
+    AstIntegerExpr(u64 value, const Type* type)
+        : AstExpr(AstKind::IntegerExpr, type)
+          , value(value)
         {}
-    ~AstIntegerExpr() override {
-        if (type) {
-            delete type;
-        }
-    }
 
-    const Type* get_type() override;
-    AnalyzeResult analyze() override;
+    AnalyzeResult check(ExprRef self, AnalysisContext& ctx) override;
+    static bool classof(const AstNode* node) { return node->kind == AstKind::IntegerExpr; }
     void print(u32 indent) override {
-        printf("%lu", value);
+        // Signed constants are stored sign extended
+        const TypeInteger* int_type = utils::dyn_cast<TypeInteger>(type);
+        if (int_type && int_type->is_signed) {
+            printf("%ld", static_cast<i64>(value));
+        } else {
+            printf("%lu", value);
+        }
     }
 
-    u64 value;
-    Type* type;
+    u64 value; // sign extended to 64 bits when the type is signed
 };
     
 // Represents a floating point literal
 struct AstFloatExpr : public AstExpr {
-    AstFloatExpr(f64 value)
-        : value(value)
-          , type(new TypeFloat(64))
+    AstFloatExpr(f64 value, const Type* type)
+        : AstExpr(AstKind::FloatExpr, type)
+          , value(value)
     {}
-    ~AstFloatExpr() override {
-        if (type) {
-            delete type;
-        }
-    }
 
-    const Type* get_type() override;
-    AnalyzeResult analyze() override;
+    AnalyzeResult check(ExprRef self, AnalysisContext& ctx) override;
+    static bool classof(const AstNode* node) { return node->kind == AstKind::FloatExpr; }
     void print(u32 indent) override {
         printf("%lf", value);
     }
 
     f64 value;
-    Type* type;
 };
 
 // Represents an identifier
 struct AstIdentifierExpr : public AstExpr {
-    AstIdentifierExpr(Identifier name)
-        : name(name)
-          , type(new TypeIdentifier())
+    AstIdentifierExpr(Symbol name)
+        : AstExpr(AstKind::IdentifierExpr)
+          , name(name)
+        {}
+
+    AnalyzeResult check(ExprRef self, AnalysisContext& ctx) override;
+    static bool classof(const AstNode* node) { return node->kind == AstKind::IdentifierExpr; }
+    void print(u32 indent) override {
+        std::string_view text = Interner::global().lookup(name);
+        printf("%.*s", static_cast<int>(text.length()), text.data());
+    }
+    Symbol name;            // typed from the declaration of `name`
+    AstNode* decl = nullptr; // the declaration `name` resolved to
+};
+
+/* Function calls
+ * `add(1, x)`
+ */
+struct AstCallExpr : public AstExpr {
+    AstCallExpr(Symbol callee, std::span<AstExpr*> args)
+        : AstExpr(AstKind::CallExpr)
+          , callee(callee)
+          , args(args)
         {}
-    ~AstIdentifierExpr() override {
-        if (type) {
-            delete type;
+
+    AnalyzeResult check(ExprRef self, AnalysisContext& ctx) override;
+    static bool classof(const AstNode* node) { return node->kind == AstKind::CallExpr; }
+    void print(u32 indent) override {
+        std::string_view text = Interner::global().lookup(callee);
+        printf("%.*s(", static_cast<int>(text.length()), text.data());
+        for (usize i = 0; i < args.size(); i++) {
+            printf(i == 0 ? "" : ", ");
+            args[i]->print(0);
         }
+        printf(")");
+    }
+
+    Symbol callee;
+    std::span<AstExpr*> args;          // in the arena
+    AstFunctionDecl* target = nullptr; // the function `callee` resolved to
+};
+
+/* Parameters of a function
+ * `a: i32` in `define f(a: i32): i32 { ... }`
+ */
+struct AstParamDecl : public AstNode {
+    AstParamDecl(Symbol name, const Type* type)
+        : AstNode(AstKind::ParamDecl)
+          , name(name)
+          , type(type)
+        {}
+
+    /// Parameters are declared by their function
+    AnalyzeResult analyze(AnalysisContext& ctx) override { return Ok(Unit()); }
+    static bool classof(const AstNode* node) { return node->kind == AstKind::ParamDecl; }
+    void print(u32 indent) override {
+        std::string_view text = Interner::global().lookup(name);
+        printf("%.*s: %s", static_cast<int>(text.length()), text.data(), type->to_str().c_str());
     }
 
-    const Type* get_type() override;
-    AnalyzeResult analyze() override;
+    Symbol name;
+    const Type* type;
+};
+
+/* Return statements
+ * `return x + 1;`
+ */
+struct AstReturnStmt : public AstNode {
+    AstReturnStmt(AstNode* value)
+        : AstNode(AstKind::ReturnStmt)
+          , value(utils::dyn_cast<AstExpr>(value))
+        {}
+
+    AnalyzeResult analyze(AnalysisContext& ctx) override;
+    static bool classof(const AstNode* node) { return node->kind == AstKind::ReturnStmt; }
+    void print(u32 indent) override {
+        printf("return ");
+        value->print(0);
+    }
+
+    AstExpr* value;
+};
+
+/* Function definitions
+ * `define add(a: i32, b: i32): i32 { return a + b; }`
+ * The body is a list of `let` and `return` statements, 
+ * and has to end with a return
+ */
+struct AstFunctionDecl : public AstNode {
+    AstFunctionDecl(Symbol name, std::span<AstParamDecl*> params, const Type* return_type, std::span<AstNode*> body)
+        : AstNode(AstKind::FunctionDecl)
+          , name(name)
+          , params(params)
+          , return_type(return_type)
+          , body(body)
+        {}
+
+    AnalyzeResult analyze(AnalysisContext& ctx) override;
+    static bool classof(const AstNode* node) { return node->kind == AstKind::FunctionDecl; }
+
+    /// Add the name of the function to the innermost scope, so it can
+    /// be called before its body is analyzed
+    Result<AstFunctionDecl*, Error> declare(AnalysisContext& ctx);
     void print(u32 indent) override {
-        printf("%s", name.name.c_str());
+        std::string_view text = Interner::global().lookup(name);
+        printf("define %.*s(", static_cast<int>(text.length()), text.data());
+        for (usize i = 0; i < params.size(); i++) {
+            printf(i == 0 ? "" : ", ");
+            params[i]->print(0);
+        }
+        printf("): %s {\n", return_type->to_str().c_str());
+        for (AstNode* stmt : body) {
+            printf("%*s", static_cast<int>(indent + 4), "");
+            stmt->print(indent + 4);
+            printf(";\n");
+        }
+        printf("%*s}", static_cast<int>(indent), "");
     }
-    Identifier name;
-    Type* type;
+
+    Symbol name;
+    std::span<AstParamDecl*> params; // in the arena
+    const Type* return_type;
+    std::span<AstNode*> body;        // in the arena
+    u32 line = 0;                    // where `define` is, counting from 1
+    std::span<u32> lines;            // where each statement of the body starts
 };
 
+/// Size of the storage of a node of the given kind
+constexpr usize node_size(AstKind kind) {
+    switch (kind) {
+        case AstKind::VarDecl: return sizeof(AstVarDecl);
+        case AstKind::ParamDecl: return sizeof(AstParamDecl);
+        case AstKind::FunctionDecl: return sizeof(AstFunctionDecl);
+        case AstKind::ReturnStmt: return sizeof(AstReturnStmt);
+        case AstKind::BinaryExpr: return sizeof(AstBinaryExpr);
+        case AstKind::PrefixExpr: return sizeof(AstPrefixExpr);
+        case AstKind::BoolExpr: return sizeof(AstBoolExpr);
+        case AstKind::IntegerExpr: return sizeof(AstIntegerExpr);
+        case AstKind::FloatExpr: return sizeof(AstFloatExpr);
+        case AstKind::IdentifierExpr: return sizeof(AstIdentifierExpr);
+        case AstKind::CallExpr: return sizeof(AstCallExpr);
+    }
+    return 0;
+}
+
+template <typename T, typename... Args>
+T* ExprRef::replace(Arena& arena, Args... args) {
+    static_assert(std::is_base_of_v<AstExpr, T>, "ExprRef::replace. Not an expression");
+    static_assert(alignof(T) <= alignof(AstExpr), "ExprRef::replace. Over aligned node");
+
+    AstExpr* old = *m_slot;
+    T* node = sizeof(T) <= node_size(old->kind)
+        ? new (old) T(std::move(args)...)
+        : arena.make<T>(std::move(args)...);
+    *m_slot = node;
+    return node;
+}
+
 } // core namespace
 } // compiler namespace
@@ -1,2 +1,341 @@
+#include "driver.h"
+#include "core/ast.h"
+#include "core/flat_ast.h"
+#include "core/logger.h"
+#include "core/log_backend.h"
+#include "frontend/lexer.h"
+#include "frontend/parser.h"
+#include "frontend/token_buffer.h"
+#include "ir/ir_gen.h"
+#include "ir/verifier.h"
+#include "platform/platform.h"
+#include "vm/interpreter.h"
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <optional>
+
+#ifndef Q_NO_LLVM
+#include "backend/jit.h"
+#include "backend/target.h"
+#include "backend/units.h"
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/raw_ostream.h>
+#endif
+
+namespace compiler {
 namespace core {
+
+/// Source that gets compiled when no input file is given
+constexpr std::string_view EXAMPLE_SOURCE = "let x: i32[4] = 5 + 1;";
+
+/// Milliseconds elapsed since `start`
+static f64 
+elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
 }
+
+/// Parse the value of --log-level
+static std::optional<logger::Level>
+parse_log_level(std::string_view name) {
+    if (name == "trace") return logger::Level::Trace;
+    if (name == "debug") return logger::Level::Debug;
+    if (name == "info") return logger::Level::Info;
+    if (name == "warn") return logger::Level::Warn;
+    if (name == "error") return logger::Level::Error;
+    if (name == "fatal") return logger::Level::Fatal;
+    if (name == "off") return logger::Level::Off;
+    return {};
+}
+
+bool Driver::process_args() {
+    // The first argument is the name of the executable
+    for (usize i = 1; i < m_args.size(); i++) {
+        const std::string& arg = m_args[i];
+
+        // `craft run file.craft` runs the program instead of compiling it
+        if (i == 1 && arg == "run") {
+            m_options.run = true;
+        } else if (arg == "--batch-lex") {
+            m_options.batch_lex = true;
+        } else if (arg == "--async-log") {
+            m_options.async_log = true;
+        } else if (arg == "--flat-ast") {
+            m_options.flat_ast = true;
+        } else if (arg == "--print-ast") {
+            m_options.print_ast = true;
+        } else if (arg == "--vm") {
+            m_options.vm = true;
+        } else if (arg == "--perf-map") {
+            m_options.perf_map = true;
+        } else if (arg == "--jitdump") {
+            m_options.jitdump = true;
+        } else if (arg == "--emit-llvm") {
+            m_options.emit_llvm = true;
+        } else if (arg == "--emit-ir") {
+            m_options.emit_ir = true;
+        } else if (arg == "-O0") {
+            m_options.opt_level = backend::OptLevel::O0;
+        } else if (arg == "-O1") {
+            m_options.opt_level = backend::OptLevel::O1;
+        } else if (arg == "-O2") {
+            m_options.opt_level = backend::OptLevel::O2;
+        } else if (arg == "-O3") {
+            m_options.opt_level = backend::OptLevel::O3;
+        } else if (arg.starts_with("--output=")) {
+            m_options.output_path = arg.substr(9);
+        } else if (arg == "--time") {
+            m_options.time_phases = true;
+        } else if (arg.starts_with("--jobs=")) {
+            std::string_view value = std::string_view(arg).substr(7);
+            auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), m_options.jobs);
+            if (ec != std::errc() || end != value.data() + value.size()) {
+                logger::Error("Invalid number of jobs in '{}'", arg);
+                return false;
+            }
+        } else if (arg.starts_with("--codegen-units=")) {
+            std::string_view value = std::string_view(arg).substr(16);
+            auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), m_options.codegen_units);
+            if (ec != std::errc() || end != value.data() + value.size() || m_options.codegen_units == 0) {
+                logger::Error("Invalid number of codegen units in '{}'", arg);
+                return false;
+            }
+        } else if (arg.starts_with("--log-level=")) {
+            std::optional<logger::Level> level = parse_log_level(std::string_view(arg).substr(12));
+            if (!level.has_value()) {
+                logger::Error("Unknown log level in '{}'. Expected trace, debug, info, warn, error, fatal or off", arg);
+                return false;
+            }
+            m_options.log_level = level.value();
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            logger::Error("Unknown option '{}'", arg);
+            return false;
+        } else if (m_options.input_path.empty()) {
+            // A lone "-" means read the source from stdin
+            m_options.input_path = arg;
+        } else {
+            logger::Error("Only one input file is supported. Got '{}' and '{}'", m_options.input_path, arg);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+i32 Driver::run() {
+    logger::set_level(m_options.log_level);
+    if (m_options.async_log) {
+        logger::start_async();
+    }
+
+    std::string_view input = EXAMPLE_SOURCE;
+
+    // The source file has to outlive the parser since
+    // tokens point back into its contents
+    platform::SourceFile source;
+    if (!m_options.input_path.empty()) {
+        if (!source.open(m_options.input_path)) {
+            if (source.too_large()) {
+                logger::Fatal("Source file '{}' is larger than 4 GiB", m_options.input_path);
+                return EXIT_FAILURE;
+            }
+            logger::Fatal("Could not read source file '{}'", m_options.input_path);
+            return EXIT_FAILURE;
+        }
+        input = source.contents();
+    }
+
+    TokenBuffer tokens;
+    if (m_options.batch_lex) {
+        auto start = std::chrono::steady_clock::now();
+        Lexer(input).tokenize(tokens);
+
+        if (m_options.time_phases) {
+            logger::Info("Lexed {} tokens in {} ms", tokens.size(), elapsed_ms(start));
+        }
+    }
+
+    auto parse_start = std::chrono::steady_clock::now();
+    Program program = Program();
+    Parser parser = m_options.batch_lex 
+        ? Parser(input, tokens, program) 
+        : Parser(input, program);
+
+    AstNode* node = parser.next_node();
+    while (node != nullptr) {
+        program.add_node(node);
+        node = parser.next_node();
+    }
+
+    if (m_options.time_phases) {
+        logger::Info("Parsed in {} ms", elapsed_ms(parse_start));
+    }
+
+    if (m_options.flat_ast) {
+        auto flatten_start = std::chrono::steady_clock::now();
+        FlatAst flat = FlatAst::flatten(program);
+
+        if (m_options.time_phases) {
+            logger::Info("Flattened {} expressions in {} ms", flat.expr_count(), elapsed_ms(flatten_start));
+        }
+        logger::Info(
+            "{} of {} binary expressions have constant operands", 
+            flat.constant_binary_count(), flat.binaries().size()
+        );
+        logger::Info(
+            "Flat AST uses {} bytes. Pointer AST uses {} bytes", 
+            flat.bytes_used(), program.arena().bytes_used()
+        );
+    }
+
+    // Only printed when asked for, so what --emit-llvm and
+    // --emit-ir print can be piped into other tools
+    if (m_options.print_ast) {
+        program.print();
+    }
+
+    auto analyze_start = std::chrono::steady_clock::now();
+    usize errors = program.analyze(m_options.jobs);
+    if (m_options.time_phases) {
+        logger::Info("Analyzed in {} ms", elapsed_ms(analyze_start));
+    }
+
+    i32 exit_code = EXIT_FAILURE;
+    if (errors == 0) {
+        if (m_options.emit_ir) {
+            exit_code = emit_ir(program);
+        } else {
+            exit_code = m_options.run ? run_program(program) : generate(program);
+        }
+    }
+    logger::stop_async();
+    return exit_code;
+}
+
+i32 Driver::run_program(Program& program) {
+    auto run_start = std::chrono::steady_clock::now();
+#ifdef Q_NO_LLVM
+    Result<i32, Error> ran = vm::run_bytecode(program);
+#else
+    backend::JitOptions jit_options = {
+        .level = m_options.opt_level,
+        .perf_map = m_options.perf_map,
+        .jitdump = m_options.jitdump,
+        .source_path = m_options.input_path == "-" ? "<stdin>" : m_options.input_path,
+    };
+    Result<i32, Error> ran = m_options.vm 
+        ? vm::run_bytecode(program) 
+        : backend::run_jit(program, jit_options);
+#endif
+    if (ran.is_err()) {
+        ran.unwrap_err().emit();
+        return EXIT_FAILURE;
+    }
+
+    if (m_options.time_phases) {
+        logger::Info("Ran in {} ms", elapsed_ms(run_start));
+    }
+    return ran.unwrap();
+}
+
+i32 Driver::emit_ir(Program& program) {
+    auto lower_start = std::chrono::steady_clock::now();
+    Result<std::unique_ptr<ir::Module>, Error> generated = ir::IrGen(program).generate();
+    if (generated.is_err()) {
+        generated.unwrap_err().emit();
+        return EXIT_FAILURE;
+    }
+    std::unique_ptr<ir::Module> module = generated.unwrap();
+
+    Result<Unit, Error> verified = ir::verify(*module);
+    if (verified.is_err()) {
+        verified.unwrap_err().emit();
+        return EXIT_FAILURE;
+    }
+
+    if (m_options.time_phases) {
+        logger::Info("Lowered and verified IR in {} ms", elapsed_ms(lower_start));
+    }
+    module->print();
+    return EXIT_SUCCESS;
+}
+
+#ifdef Q_NO_LLVM
+i32 Driver::generate(Program& program) {
+    logger::Error("This build has no LLVM backend to write objects with. Use `craft run` to run the program");
+    return EXIT_FAILURE;
+}
+#else
+i32 Driver::generate(Program& program) {
+    std::string output = m_options.output_path;
+    if (output.empty()) {
+        bool named = !m_options.input_path.empty() && m_options.input_path != "-";
+        output = named 
+            ? std::filesystem::path(m_options.input_path).replace_extension(".o").string() 
+            : "out.o";
+    }
+
+    auto codegen_start = std::chrono::steady_clock::now();
+    // IR is printed as one module, so it is never split
+    if (m_options.codegen_units > 1 && !m_options.emit_llvm) {
+        Result<Unit, Error> compiled = backend::compile_units(
+            program, m_options.codegen_units, m_options.jobs, m_options.opt_level, output
+        );
+        if (compiled.is_err()) {
+            compiled.unwrap_err().emit();
+            return EXIT_FAILURE;
+        }
+
+        if (m_options.time_phases) {
+            logger::Info("Compiled codegen units to '{}' in {} ms", output, elapsed_ms(codegen_start));
+        }
+        return EXIT_SUCCESS;
+    }
+
+    llvm::LLVMContext context;
+    Result<std::unique_ptr<llvm::Module>, Error> generated = program.generate_llvm(context, output);
+    if (generated.is_err()) {
+        generated.unwrap_err().emit();
+        return EXIT_FAILURE;
+    }
+    std::unique_ptr<llvm::Module> module = generated.unwrap();
+
+    if (m_options.time_phases) {
+        logger::Info("Generated IR in {} ms", elapsed_ms(codegen_start));
+    }
+
+    Result<std::unique_ptr<llvm::TargetMachine>, Error> machine_res = backend::create_host_machine(m_options.opt_level);
+    if (machine_res.is_err()) {
+        machine_res.unwrap_err().emit();
+        return EXIT_FAILURE;
+    }
+    std::unique_ptr<llvm::TargetMachine> machine = machine_res.unwrap();
+
+    auto optimize_start = std::chrono::steady_clock::now();
+    backend::optimize(*module, *machine, m_options.opt_level);
+    if (m_options.time_phases) {
+        logger::Info("Optimized in {} ms", elapsed_ms(optimize_start));
+    }
+
+    if (m_options.emit_llvm) {
+        module->print(llvm::outs(), nullptr);
+        return EXIT_SUCCESS;
+    }
+
+    auto emit_start = std::chrono::steady_clock::now();
+    Result<Unit, Error> emitted = backend::emit_object(*module, *machine, output);
+    if (emitted.is_err()) {
+        emitted.unwrap_err().emit();
+        return EXIT_FAILURE;
+    }
+
+    if (m_options.time_phases) {
+        logger::Info("Emitted '{}' in {} ms", output, elapsed_ms(emit_start));
+    }
+    return EXIT_SUCCESS;
+}
+#endif
+
+} // namespace core
+} // namespace compiler
@@ -1,19 +1,62 @@
 #pragma once
 #include "defines.h"
+#include "core/logger.h"
+#include "backend/opt_level.h"
 #include <iostream>
 #include <string>
 #include <vector>
 
+namespace compiler {
 namespace core {
 
+struct Program;
+
+/// Options for a compilation, filled in from the command line
+struct CompileOptions {
+    std::string input_path; // empty compiles the built-in example
+    bool batch_lex = false; // lex the whole file before parsing
+    bool time_phases = false; // report how long each phase took
+    logger::Level log_level = logger::Level::Info;
+    bool async_log = false; // write log messages from a background thread
+    bool flat_ast = false; // build the flat AST after parsing
+    bool print_ast = false; // print the parsed tree to stdout before analysis
+    usize jobs = 1; // threads used for analysis. Zero means one per hardware thread
+    backend::OptLevel opt_level = backend::OptLevel::O0;
+    std::string output_path; // empty names the object after the input
+    bool emit_llvm = false; // print the optimized IR instead of writing an object
+    bool emit_ir = false; // print the verified SSA IR instead of writing an object
+    bool run = false; // JIT the program and call its main instead of writing an object
+    bool vm = false; // run on the bytecode interpreter instead of the JIT. Always on without LLVM
+    bool perf_map = false; // when running, write /tmp/perf-<pid>.map for perf
+    bool jitdump = false; // when running, write a jitdump with line tables for perf
+    usize codegen_units = 1; // modules the functions are split into, compiled on `jobs` threads
+};
+
 class Driver {
 public:
     Driver(std::vector<std::string> args)
         : m_args(args) {}
 
-    void process_args();
+    /// Read the command line arguments. Returns false if they are invalid
+    bool process_args();
+
+    /// Run the compiler with the processed options. Returns the exit code
+    i32 run();
+
+    const CompileOptions& options() const { return m_options; }
 private:
+    /// Generate code for an analyzed program and write it out
+    i32 generate(Program& program);
+
+    /// Run the `main` of an analyzed program. Returns what it returned
+    i32 run_program(Program& program);
+
+    /// Lower an analyzed program to SSA IR, verify it and print it
+    i32 emit_ir(Program& program);
+
     std::vector<std::string> m_args;
+    CompileOptions m_options;
 };
 
-}
+} // namespace core
+} // namespace compiler
@@ -0,0 +1,143 @@
+#include "error.h"
+#include "core/logger.h"
+#include <string>
+
+namespace compiler {
+namespace core {
+
+struct ErrorInfo {
+    Error::Type type;
+    std::string_view format;
+};
+
+/// Indexed by ErrorCode
+static constexpr ErrorInfo ERROR_INFOS[] = {
+    { Error::Type::Semantic, "AstExpr::analyze. The root expression was moved" },
+    { Error::Type::Semantic, "Expression depends on its own type" },
+    { Error::Type::Semantic, "Use of undeclared identifier '{}'" },
+    { Error::Type::Semantic, "'{}' is used in its own declaration" },
+    { Error::Type::Semantic, "The type of '{}' is not known here" },
+    { Error::Type::Semantic, "Redeclaration of '{}'" },
+    { Error::Type::Semantic, "AstVarDecl::analyze. Assigned expression type is not the same as specified" },
+    { Error::Type::Semantic, "Only numbers can be negated" },
+    { Error::Type::Semantic, "Operator `~` needs an integer" },
+    { Error::Type::Semantic, "Operator `!` needs a boolean" },
+    { Error::Type::Semantic, "Invalid operator for prefix expression." },
+    { Error::Type::Semantic, "Shift amount {} is out of range" },
+    { Error::Type::Semantic, "Division by zero in constant expression" },
+    { Error::Type::Semantic, "Invalid types cannot be coalesced" },
+    { Error::Type::Semantic, "'{}' is a function, not a value" },
+    { Error::Type::Semantic, "'{}' is not a function" },
+    { Error::Type::Semantic, "'{}' takes {} arguments but was given {}" },
+    { Error::Type::Semantic, "Argument {} of '{}' does not have the type of the parameter" },
+    { Error::Type::Semantic, "Returned value does not have the return type of '{}'" },
+    { Error::Type::Semantic, "'{}' does not end with a return" },
+    { Error::Type::Semantic, "Operator `{}` needs numbers" },
+    { Error::Type::Semantic, "Operator `{}` needs integers" },
+    { Error::Type::Semantic, "Operator `{}` needs booleans" },
+    { Error::Type::Semantic, "Operator `{}` needs two numbers of the same type" },
+    { Error::Type::Semantic, "Invalid operator for binary expression." },
+    { Error::Type::Semantic, "Only a variable can be assigned to" },
+    { Error::Type::Semantic, "Operator `{}` gives a value of another type than its variable has" },
+    { Error::Type::Semantic, "-{} is too small for any integer type" },
+
+    { Error::Type::Codegen, "An expression has no type to generate code for" },
+    { Error::Type::Codegen, "Values of type {} cannot be generated yet" },
+    { Error::Type::Codegen, "Operator `{}` cannot be generated yet" },
+    { Error::Type::Codegen, "The generated module is invalid: {}" },
+    { Error::Type::Codegen, "No target for '{}': {}" },
+    { Error::Type::Codegen, "Could not open '{}': {}" },
+    { Error::Type::Codegen, "The target cannot emit object files" },
+    { Error::Type::Codegen, "Could not link the objects of the codegen units into '{}'" },
+    { Error::Type::Codegen, "The program has no 'main' function to run" },
+    { Error::Type::Codegen, "'main' has to take no parameters and return i32" },
+    { Error::Type::Codegen, "The JIT failed: {}" },
+    { Error::Type::Codegen, "'{}' needs more registers than bytecode can address" },
+    { Error::Type::Codegen, "The IR of '{}' is invalid: {}" },
+
+    { Error::Type::Runtime, "Integer division by zero in '{}'" },
+    { Error::Type::Runtime, "Stack overflow when calling '{}'" },
+};
+
+static_assert(
+    sizeof(ERROR_INFOS) / sizeof(ERROR_INFOS[0]) == static_cast<usize>(ErrorCode::StackOverflow) + 1,
+    "Every error code needs a message"
+);
+
+static const char* 
+error_type_to_cstr(Error::Type type) {
+    switch (type) {
+        case Error::Type::FileSystem: return "File system";
+        case Error::Type::Lexer: return "Lexer";
+        case Error::Type::Parser: return "Parser";
+        case Error::Type::Semantic: return "Semantic";
+        case Error::Type::Codegen: return "Codegen";
+        case Error::Type::Runtime: return "Runtime";
+    }
+    return "Unknown";
+}
+
+u32 Diagnostics::add(std::initializer_list<DiagnosticArg> args) {
+    std::lock_guard lock(m_mutex);
+    u32 first = static_cast<u32>(m_args.size());
+    for (DiagnosticArg arg : args) {
+        if (arg.m_kind == DiagnosticArg::Kind::Text) {
+            arg.m_text = m_arena.copy_string(arg.m_text);
+        }
+        m_args.push_back(arg);
+    }
+    return first;
+}
+
+std::string Diagnostics::format(std::string_view format, u32 first, u32 count) const {
+    std::lock_guard lock(m_mutex);
+    std::string out;
+    out.reserve(format.size());
+
+    u32 next = 0;
+    for (usize i = 0; i < format.size(); i++) {
+        if (format[i] != '{' || i + 1 >= format.size() || format[i + 1] != '}' || next >= count) {
+            out.push_back(format[i]);
+            continue;
+        }
+
+        const DiagnosticArg& arg = m_args[first + next++];
+        switch (arg.m_kind) {
+            case DiagnosticArg::Kind::Symbol: 
+                out += Interner::global().lookup(static_cast<Symbol>(arg.m_value)); 
+                break;
+            case DiagnosticArg::Kind::Integer: 
+                out += std::to_string(arg.m_value); 
+                break;
+            case DiagnosticArg::Kind::Text: 
+                out += arg.m_text; 
+                break;
+        }
+        i++;
+    }
+    return out;
+}
+
+Diagnostics& Diagnostics::global() {
+    static Diagnostics diagnostics;
+    return diagnostics;
+}
+
+Error::Type Error::type() const {
+    return ERROR_INFOS[static_cast<usize>(m_code)].type;
+}
+
+std::string Error::message() const {
+    std::string_view format = ERROR_INFOS[static_cast<usize>(m_code)].format;
+    if (m_arg_count == 0) {
+        return std::string(format);
+    }
+    return Diagnostics::global().format(format, m_first_arg, m_arg_count);
+}
+
+void Error::emit() const {
+    logger::Error("{} error: {}", error_type_to_cstr(type()), message());
+}
+
+} // namespace core
+} // namespace compiler
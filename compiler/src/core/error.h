@@ -1,12 +1,125 @@
 #pragma once
 #include "defines.h"
+#include "arena.h"
+#include "interner.h"
+#include <initializer_list>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace compiler {
 namespace core {
 
-/// Abstract interface for errors encountered 
-/// during compilation
+/// Everything that can go wrong in compilation. The message of each 
+/// code is in error.cc, and is only formatted when the error is emitted
+enum class ErrorCode : u16 {
+    // Semantic
+    RootMoved,
+    CyclicType,
+    UndeclaredIdentifier,
+    SelfReference,
+    UnknownType,
+    Redeclaration,
+    TypeMismatch,
+    NegateNonNumber,
+    ComplementNonInteger,
+    NotNonBoolean,
+    InvalidPrefixOperator,
+    ShiftOutOfRange,
+    DivisionByZero,
+    InvalidCoalesce,
+    NotAValue,
+    NotAFunction,
+    ArgumentCount,
+    ArgumentMismatch,
+    ReturnMismatch,
+    MissingReturn,
+    ArithmeticNonNumber,
+    BitwiseNonInteger,
+    LogicalNonBoolean,
+    ComparisonMismatch,
+    InvalidBinaryOperator,
+    AssignToNonVariable,
+    AssignMismatch,
+    NegationOutOfRange,
+
+    // Code generation
+    UntypedExpression,
+    UnsupportedType,
+    UnsupportedOperator,
+    InvalidModule,
+    NoTarget,
+    CannotOpenOutput,
+    CannotEmitObject,
+    LinkFailed,
+    MissingMain,
+    InvalidMain,
+    JitFailed,
+    TooManyRegisters,
+    InvalidIr,
+
+    // Running bytecode
+    IntegerDivisionByZero,
+    StackOverflow,
+};
+
+/// Value that fills a `{}` in the message of an error
+class DiagnosticArg {
+public:
+    enum class Kind : u8 {
+        Symbol,
+        Integer,
+        Text,
+    };
+
+    static DiagnosticArg symbol(Symbol symbol) { return { Kind::Symbol, symbol, {} }; }
+    static DiagnosticArg integer(i64 value) { return { Kind::Integer, value, {} }; }
+    /// The text is copied when the error is made
+    static DiagnosticArg text(std::string_view text) { return { Kind::Text, 0, text }; }
+
+private:
+    friend class Diagnostics;
+
+    DiagnosticArg(Kind kind, i64 value, std::string_view text) noexcept
+        : m_kind(kind)
+          , m_value(value)
+          , m_text(text)
+        {}
+
+    Kind m_kind;
+    i64 m_value;  // symbol or integer
+    std::string_view m_text;
+};
+
+/// Arguments of the errors made so far. Errors only hold a handle to 
+/// theirs, so an error without arguments is never more than its code,
+/// and one with arguments costs a short locked append. Errors are
+/// made on every analysis thread, which is why this locks.
+class Diagnostics {
+public:
+    Diagnostics() noexcept = default;
+
+    Diagnostics(const Diagnostics&) = delete;
+    Diagnostics& operator=(const Diagnostics&) = delete;
+
+    /// Store arguments and get the index of the first one
+    u32 add(std::initializer_list<DiagnosticArg> args);
+
+    /// Fill the `{}`s of `format` with `count` arguments starting at `first`
+    std::string format(std::string_view format, u32 first, u32 count) const;
+
+    /// The diagnostics shared by the whole compiler
+    static Diagnostics& global();
+
+private:
+    mutable std::mutex m_mutex;
+    Arena m_arena;  // text of arguments
+    std::vector<DiagnosticArg> m_args;
+};
+
+/// An error encountered during compilation. It is a code and a handle 
+/// to its arguments, so it is trivially copyable and fits in a register
 class Error {
 public:
     enum class Type {
@@ -14,19 +127,38 @@ public:
         Lexer,
         Parser,
         Semantic,
+        Codegen,
+        Runtime,
     };
 
-    Error(Type type, std::string msg)
-        : m_type(type)
-          , m_msg(msg)
+    explicit Error(ErrorCode code) noexcept
+        : m_code(code)
+          , m_arg_count(0)
+          , m_first_arg(0)
+        {}
+
+    Error(ErrorCode code, std::initializer_list<DiagnosticArg> args)
+        : m_code(code)
+          , m_arg_count(static_cast<u16>(args.size()))
+          , m_first_arg(Diagnostics::global().add(args))
         {}
 
-    void emit();
+    /// Report the error through the logger
+    void emit() const;
+
+    ErrorCode code() const { return m_code; }
+    Type type() const;
+
+    /// Format the message of the error
+    std::string message() const;
 
 private:
-    Type m_type;
-    std::string m_msg;
+    ErrorCode m_code;
+    u16 m_arg_count;
+    u32 m_first_arg;
 };
 
+static_assert(sizeof(Error) == 8, "Error should fit in a register");
+
 } // namespace core
 } // namespace compiler
@@ -0,0 +1,231 @@
+#include "flat_ast.h"
+#include "core/utils.h"
+#include "core/logger.h"
+#include <utility>
+
+namespace compiler {
+namespace core {
+
+template <typename T>
+static usize 
+capacity_bytes(const std::vector<T>& vec) {
+    return vec.capacity() * sizeof(T);
+}
+
+FlatAst FlatAst::flatten(const Program& program) {
+    FlatAst flat;
+    std::vector<ExprId> operands;
+
+    for (const AstNode* node : program.nodes()) {
+        if (const AstVarDecl* decl = utils::dyn_cast<AstVarDecl>(node)) {
+            flat.m_statements.push_back(flat.flatten_var_decl(decl, operands));
+        } else if (const AstFunctionDecl* function = utils::dyn_cast<AstFunctionDecl>(node)) {
+            FlatFunction flat_function = {
+                .name = function->name,
+                .return_type = function->return_type,
+                .first_param = static_cast<u32>(flat.m_params.size()),
+                .param_count = static_cast<u32>(function->params.size()),
+                .first_stmt = static_cast<u32>(flat.m_body.size()),
+                .stmt_count = static_cast<u32>(function->body.size()),
+            };
+            for (const AstParamDecl* param : function->params) {
+                flat.m_params.push_back(FlatParam{ param->name, param->type });
+            }
+
+            // The statements of a body are flattened first, so they 
+            // stay next to each other
+            for (const AstNode* stmt : function->body) {
+                if (const AstVarDecl* local = utils::dyn_cast<AstVarDecl>(stmt)) {
+                    flat.m_body.push_back(flat.flatten_var_decl(local, operands));
+                } else if (const AstReturnStmt* ret = utils::dyn_cast<AstReturnStmt>(stmt)) {
+                    flat.m_body.push_back(FlatStmt{ AstKind::ReturnStmt, static_cast<u32>(flat.m_returns.size()) });
+                    flat.m_returns.push_back(flat.flatten_expr(ret->value, operands));
+                } else {
+                    core::logger::Error("FlatAst::flatten. Unsupported statement");
+                }
+            }
+
+            flat.m_statements.push_back(FlatStmt{ AstKind::FunctionDecl, static_cast<u32>(flat.m_functions.size()) });
+            flat.m_functions.push_back(flat_function);
+        } else {
+            core::logger::Error("FlatAst::flatten. Unsupported top level node");
+        }
+    }
+
+    flat.shrink_to_fit();
+    return flat;
+}
+
+FlatStmt FlatAst::flatten_var_decl(const AstVarDecl* decl, std::vector<ExprId>& operands) {
+    const AstIdentifierExpr* target = utils::dyn_cast<AstIdentifierExpr>(decl->target);
+    FlatVarDecl flat_decl = {
+        .name = target ? target->name : INVALID_SYMBOL,
+        .value = flatten_expr(decl->value, operands),
+        .type = decl->type.value_or(nullptr),
+    };
+
+    FlatStmt stmt = { AstKind::VarDecl, static_cast<u32>(m_var_decls.size()) };
+    m_var_decls.push_back(flat_decl);
+    return stmt;
+}
+
+usize FlatAst::constant_binary_count() const {
+    auto is_literal = [&](ExprId id) {
+        AstKind kind = m_kinds[id];
+        return kind == AstKind::IntegerExpr || kind == AstKind::FloatExpr || kind == AstKind::BoolExpr;
+    };
+
+    usize count = 0;
+    for (const FlatBinary& binary : m_binaries) {
+        if (is_literal(m_children[binary.first_child]) && is_literal(m_children[binary.first_child + 1])) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// The pools grow by doubling while flattening, 
+// so trim them once the size is known
+void FlatAst::shrink_to_fit() {
+    m_kinds.shrink_to_fit();
+    m_slots.shrink_to_fit();
+    m_types.shrink_to_fit();
+    m_children.shrink_to_fit();
+    m_binaries.shrink_to_fit();
+    m_prefixes.shrink_to_fit();
+    m_integers.shrink_to_fit();
+    m_floats.shrink_to_fit();
+    m_booleans.shrink_to_fit();
+    m_identifiers.shrink_to_fit();
+    m_calls.shrink_to_fit();
+    m_var_decls.shrink_to_fit();
+    m_returns.shrink_to_fit();
+    m_params.shrink_to_fit();
+    m_functions.shrink_to_fit();
+    m_statements.shrink_to_fit();
+    m_body.shrink_to_fit();
+}
+
+ExprId FlatAst::push_expr(AstKind kind, u32 slot, const Type* type) {
+    ExprId id = static_cast<ExprId>(m_kinds.size());
+    m_kinds.push_back(kind);
+    m_slots.push_back(slot);
+    m_types.push_back(type);
+    return id;
+}
+
+// Walk the tree in post order with an explicit stack, since 
+// long operator chains nest far deeper than the call stack allows.
+// Finished operands wait on `operands` until their parent is built
+ExprId FlatAst::flatten_expr(const AstExpr* root, std::vector<ExprId>& operands) {
+    if (root == nullptr) {
+        return INVALID_EXPR;
+    }
+
+    std::vector<std::pair<const AstExpr*, bool>> stack;
+    stack.emplace_back(root, false);
+
+    while (!stack.empty()) {
+        auto [expr, expanded] = stack.back();
+
+        if (!expanded) {
+            stack.back().second = true;
+            if (const AstBinaryExpr* binary = utils::dyn_cast<AstBinaryExpr>(expr)) {
+                // Pushed in reverse so the lhs is finished first
+                stack.emplace_back(binary->rhs, false);
+                stack.emplace_back(binary->lhs, false);
+                continue;
+            }
+            if (const AstPrefixExpr* prefix = utils::dyn_cast<AstPrefixExpr>(expr)) {
+                stack.emplace_back(prefix->rhs, false);
+                continue;
+            }
+            if (const AstCallExpr* call = utils::dyn_cast<AstCallExpr>(expr)) {
+                for (usize i = call->args.size(); i > 0; i--) {
+                    stack.emplace_back(call->args[i - 1], false);
+                }
+                continue;
+            }
+        }
+        stack.pop_back();
+
+        ExprId id = INVALID_EXPR;
+        switch (expr->kind) {
+            case AstKind::BinaryExpr: {
+                const AstBinaryExpr* binary = utils::cast<AstBinaryExpr>(expr);
+                ExprId rhs = operands.back(); operands.pop_back();
+                ExprId lhs = operands.back(); operands.pop_back();
+
+                u32 first_child = static_cast<u32>(m_children.size());
+                m_children.push_back(lhs);
+                m_children.push_back(rhs);
+                id = push_expr(expr->kind, static_cast<u32>(m_binaries.size()), binary->type);
+                m_binaries.push_back(FlatBinary{ binary->op, first_child });
+                break;
+            }
+            case AstKind::PrefixExpr: {
+                const AstPrefixExpr* prefix = utils::cast<AstPrefixExpr>(expr);
+                ExprId operand = operands.back(); operands.pop_back();
+
+                id = push_expr(expr->kind, static_cast<u32>(m_prefixes.size()), prefix->type);
+                m_prefixes.push_back(FlatPrefix{ prefix->op, operand });
+                break;
+            }
+            case AstKind::IntegerExpr: {
+                const AstIntegerExpr* integer = utils::cast<AstIntegerExpr>(expr);
+                id = push_expr(expr->kind, static_cast<u32>(m_integers.size()), integer->type);
+                m_integers.push_back(integer->value);
+                break;
+            }
+            case AstKind::FloatExpr: {
+                const AstFloatExpr* floating = utils::cast<AstFloatExpr>(expr);
+                id = push_expr(expr->kind, static_cast<u32>(m_floats.size()), floating->type);
+                m_floats.push_back(floating->value);
+                break;
+            }
+            case AstKind::BoolExpr: {
+                const AstBoolExpr* boolean = utils::cast<AstBoolExpr>(expr);
+                id = push_expr(expr->kind, static_cast<u32>(m_booleans.size()), boolean->type);
+                m_booleans.push_back(boolean->value);
+                break;
+            }
+            case AstKind::IdentifierExpr: {
+                const AstIdentifierExpr* identifier = utils::cast<AstIdentifierExpr>(expr);
+                id = push_expr(expr->kind, static_cast<u32>(m_identifiers.size()), identifier->type);
+                m_identifiers.push_back(identifier->name);
+                break;
+            }
+            case AstKind::CallExpr: {
+                const AstCallExpr* call = utils::cast<AstCallExpr>(expr);
+                u32 arg_count = static_cast<u32>(call->args.size());
+                u32 first_child = static_cast<u32>(m_children.size());
+                m_children.insert(m_children.end(), operands.end() - arg_count, operands.end());
+                operands.resize(operands.size() - arg_count);
+
+                id = push_expr(expr->kind, static_cast<u32>(m_calls.size()), call->type);
+                m_calls.push_back(FlatCall{ call->callee, first_child, arg_count });
+                break;
+            }
+            default:
+                core::logger::Error("FlatAst::flatten_expr. Unsupported expression");
+                break;
+        }
+        operands.push_back(id);
+    }
+
+    ExprId id = operands.back();
+    operands.pop_back();
+    return id;
+}
+
+usize FlatAst::bytes_used() const {
+    return capacity_bytes(m_kinds) + capacity_bytes(m_slots) + capacity_bytes(m_types)
+        + capacity_bytes(m_children) + capacity_bytes(m_binaries) + capacity_bytes(m_prefixes)
+        + capacity_bytes(m_integers) + capacity_bytes(m_floats) + capacity_bytes(m_booleans)
+        + capacity_bytes(m_identifiers) + capacity_bytes(m_calls) + capacity_bytes(m_var_decls)
+        + capacity_bytes(m_returns) + capacity_bytes(m_params) + capacity_bytes(m_functions)
+        + capacity_bytes(m_statements) + capacity_bytes(m_body);
+}
+
+} // namespace core
+} // namespace compiler
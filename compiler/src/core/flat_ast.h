@@ -0,0 +1,159 @@
+#pragma once
+#include "defines.h"
+#include "ast.h"
+#include "type.h"
+#include "interner.h"
+#include <span>
+#include <vector>
+
+namespace compiler {
+namespace core {
+
+/// Index of an expression in a FlatAst
+using ExprId = u32;
+
+constexpr ExprId INVALID_EXPR = ~ExprId(0);
+
+/// Binary expression. Its operands are `children[first_child]` (lhs)
+/// and `children[first_child + 1]` (rhs)
+struct FlatBinary {
+    Operator op;
+    u32 first_child;
+};
+
+struct FlatPrefix {
+    Operator op;
+    ExprId operand;
+};
+
+/// Call of `callee`. Its arguments are `children[first_child]` 
+/// up to `children[first_child + arg_count]`
+struct FlatCall {
+    Symbol callee;
+    u32 first_child;
+    u32 arg_count;
+};
+
+/// `let name: type = value`. `type` is null when there is no annotation
+struct FlatVarDecl {
+    Symbol name;
+    ExprId value;
+    const Type* type;
+};
+
+/// Statement at the top level of a program or in a function body
+struct FlatStmt {
+    AstKind kind;
+    u32 index; // into the pool for `kind`
+};
+
+struct FlatParam {
+    Symbol name;
+    const Type* type;
+};
+
+/// `define name(params): return_type { body }`. Its parameters are
+/// `params[first_param]` up to `params[first_param + param_count]`,
+/// and its statements are `body[first_stmt]` up to 
+/// `body[first_stmt + stmt_count]`
+struct FlatFunction {
+    Symbol name;
+    const Type* return_type;
+    u32 first_param;
+    u32 param_count;
+    u32 first_stmt;
+    u32 stmt_count;
+};
+
+/// The AST of a program stored as flat arrays instead of a pointer tree.
+/// Every expression has an ExprId, and `kind(id)` together with `slot(id)` 
+/// say which pool the node lives in and where. Nodes of the same class 
+/// sit next to each other in their pool, so a pass can walk all of them 
+/// in order, and the operands of a node are stored next to each other 
+/// in `children`. Expressions are laid out in post order, so operands 
+/// always come before the node that uses them.
+class FlatAst {
+public:
+    FlatAst() noexcept = default;
+
+    /// Build the flat form of every top level node in `program`
+    static FlatAst flatten(const Program& program);
+
+    [[ nodiscard ]] usize expr_count() const { return m_kinds.size(); }
+    [[ nodiscard ]] AstKind kind(ExprId id) const { return m_kinds[id]; }
+    [[ nodiscard ]] u32 slot(ExprId id) const { return m_slots[id]; }
+
+    /// Type of an expression. Null until it is known
+    [[ nodiscard ]] const Type* type(ExprId id) const { return m_types[id]; }
+    void set_type(ExprId id, const Type* type) { m_types[id] = type; }
+
+    const FlatBinary& binary(ExprId id) const { return m_binaries[m_slots[id]]; }
+    const FlatPrefix& prefix(ExprId id) const { return m_prefixes[m_slots[id]]; }
+    ExprId lhs(ExprId id) const { return m_children[binary(id).first_child]; }
+    ExprId rhs(ExprId id) const { return m_children[binary(id).first_child + 1]; }
+    u64 integer(ExprId id) const { return m_integers[m_slots[id]]; }
+    f64 floating(ExprId id) const { return m_floats[m_slots[id]]; }
+    bool boolean(ExprId id) const { return m_booleans[m_slots[id]] != 0; }
+    Symbol identifier(ExprId id) const { return m_identifiers[m_slots[id]]; }
+    const FlatCall& call(ExprId id) const { return m_calls[m_slots[id]]; }
+    std::span<const ExprId> args(ExprId id) const { 
+        return std::span<const ExprId>(m_children).subspan(call(id).first_child, call(id).arg_count); 
+    }
+
+    /// Pools, for passes that look at every node of one class
+    std::span<const FlatStmt> statements() const { return m_statements; }
+    std::span<const FlatVarDecl> var_decls() const { return m_var_decls; }
+    std::span<const FlatFunction> functions() const { return m_functions; }
+    std::span<const FlatBinary> binaries() const { return m_binaries; }
+    std::span<const FlatPrefix> prefixes() const { return m_prefixes; }
+
+    /// Value of each return statement
+    std::span<const ExprId> returns() const { return m_returns; }
+
+    std::span<const FlatParam> params(const FlatFunction& function) const {
+        return std::span<const FlatParam>(m_params).subspan(function.first_param, function.param_count);
+    }
+    std::span<const FlatStmt> body(const FlatFunction& function) const {
+        return std::span<const FlatStmt>(m_body).subspan(function.first_stmt, function.stmt_count);
+    }
+
+    /// Number of binary expressions whose operands are both literals,
+    /// found with one pass over the binary pool
+    usize constant_binary_count() const;
+
+    /// Bytes of memory held by the arrays
+    usize bytes_used() const;
+
+private:
+    ExprId push_expr(AstKind kind, u32 slot, const Type* type);
+    ExprId flatten_expr(const AstExpr* root, std::vector<ExprId>& operands);
+    FlatStmt flatten_var_decl(const AstVarDecl* decl, std::vector<ExprId>& operands);
+    void shrink_to_fit();
+
+    // One entry per expression, indexed by ExprId
+    std::vector<AstKind> m_kinds;
+    std::vector<u32> m_slots;
+    std::vector<const Type*> m_types;
+
+    // Operands of binary expressions, in pairs, and arguments of calls
+    std::vector<ExprId> m_children;
+
+    // Pools of each node class
+    std::vector<FlatBinary> m_binaries;
+    std::vector<FlatPrefix> m_prefixes;
+    std::vector<u64> m_integers;
+    std::vector<f64> m_floats;
+    std::vector<u8> m_booleans;
+    std::vector<Symbol> m_identifiers;
+    std::vector<FlatCall> m_calls;
+    std::vector<FlatVarDecl> m_var_decls;
+    std::vector<ExprId> m_returns;
+    std::vector<FlatParam> m_params;
+    std::vector<FlatFunction> m_functions;
+
+    std::vector<FlatStmt> m_statements;  // top level
+    std::vector<FlatStmt> m_body;        // of every function, one after the other
+};
+
+} // namespace core
+} // namespace compiler
@@ -0,0 +1,73 @@
+#include "interner.h"
+
+namespace compiler {
+namespace core {
+
+constexpr usize INITIAL_SLOTS = 1024;
+
+/// FNV-1a. Identifiers are short, so this is hard to beat
+static u32 
+hash_string(std::string_view text) {
+    u32 hash = 2166136261u;
+    for (char c : text) {
+        hash ^= static_cast<u8>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+Interner::Interner() 
+    : m_slots(INITIAL_SLOTS, Slot{ 0, INVALID_SYMBOL }) 
+{}
+
+Symbol Interner::intern(std::string_view text) {
+    u32 hash = hash_string(text);
+    usize mask = m_slots.size() - 1;
+
+    for (usize i = hash & mask;; i = (i + 1) & mask) {
+        Slot& slot = m_slots[i];
+        if (slot.symbol == INVALID_SYMBOL) {
+            Symbol symbol = static_cast<Symbol>(m_strings.size());
+            m_strings.push_back(m_arena.copy_string(text));
+            slot = Slot{ hash, symbol };
+
+            // Keep the load factor under a half so probe sequences stay short
+            if (m_strings.size() * 2 > m_slots.size()) {
+                grow();
+            }
+            return symbol;
+        }
+
+        if (slot.hash == hash && m_strings[slot.symbol] == text) {
+            return slot.symbol;
+        }
+    }
+}
+
+/// Double the table and re-insert every symbol
+void Interner::grow() {
+    std::vector<Slot> slots(m_slots.size() * 2, Slot{ 0, INVALID_SYMBOL });
+    usize mask = slots.size() - 1;
+
+    for (const Slot& slot : m_slots) {
+        if (slot.symbol == INVALID_SYMBOL) {
+            continue;
+        }
+
+        usize i = slot.hash & mask;
+        while (slots[i].symbol != INVALID_SYMBOL) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = slot;
+    }
+
+    m_slots = std::move(slots);
+}
+
+Interner& Interner::global() {
+    static Interner interner;
+    return interner;
+}
+
+} // namespace core
+} // namespace compiler
@@ -0,0 +1,56 @@
+#pragma once
+#include "defines.h"
+#include "arena.h"
+#include <string_view>
+#include <vector>
+
+namespace compiler {
+namespace core {
+
+/// Dense id of an interned string. Two symbols are equal 
+/// exactly when the strings they were interned from are.
+using Symbol = u32;
+
+constexpr Symbol INVALID_SYMBOL = ~Symbol(0);
+
+/// Maps identifier text to dense symbol ids. The text is copied into 
+/// an arena once, and the lookup table is a flat open addressing 
+/// hash table, so interning a name that was seen before does not allocate.
+/// Interning is not thread safe. Once it is done, symbols can be 
+/// looked up from any thread.
+class Interner {
+public:
+    Interner();
+
+    Interner(const Interner&) = delete;
+    Interner& operator=(const Interner&) = delete;
+
+    /// Get the symbol for `text`, adding it if it has not been seen before
+    Symbol intern(std::string_view text);
+
+    /// Get the text that a symbol was interned from
+    std::string_view lookup(Symbol symbol) const {
+        return m_strings[symbol];
+    }
+
+    /// Number of distinct strings interned
+    usize size() const { return m_strings.size(); }
+
+    /// The interner shared by the whole compiler
+    static Interner& global();
+
+private:
+    struct Slot {
+        u32 hash;
+        Symbol symbol; // INVALID_SYMBOL when empty
+    };
+
+    void grow();
+
+    Arena m_arena;
+    std::vector<Slot> m_slots;  // size is always a power of two
+    std::vector<std::string_view> m_strings; // indexed by symbol
+};
+
+} // namespace core
+} // namespace compiler
@@ -0,0 +1,225 @@
+#include "log_backend.h"
+#include "platform/platform.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace compiler {
+namespace core {
+namespace logger {
+
+constexpr u32 ERR_BIT = 1u << 31;
+constexpr usize HEADER_SIZE = sizeof(u32);
+
+/// How long the flusher sleeps between batches when nobody wakes it
+constexpr auto FLUSH_INTERVAL = std::chrono::milliseconds(5);
+
+void RingBuffer::copy_in(u64 position, const char* data, usize size) {
+    usize offset = position & (CAPACITY - 1);
+    usize first = std::min(size, CAPACITY - offset);
+    std::memcpy(m_data + offset, data, first);
+    std::memcpy(m_data, data + first, size - first);
+}
+
+void RingBuffer::copy_out(u64 position, char* data, usize size) const {
+    usize offset = position & (CAPACITY - 1);
+    usize first = std::min(size, CAPACITY - offset);
+    std::memcpy(data, m_data + offset, first);
+    std::memcpy(data + first, m_data, size - first);
+}
+
+bool RingBuffer::push(Stream stream, std::string_view msg) {
+    u64 head = m_head.load(std::memory_order_relaxed);
+    u64 tail = m_tail.load(std::memory_order_acquire);
+
+    usize needed = HEADER_SIZE + msg.size();
+    if (CAPACITY - (head - tail) < needed) {
+        return false;
+    }
+
+    u32 header = static_cast<u32>(msg.size()) | (stream == Stream::Err ? ERR_BIT : 0);
+    copy_in(head, reinterpret_cast<const char*>(&header), HEADER_SIZE);
+    copy_in(head + HEADER_SIZE, msg.data(), msg.size());
+
+    m_head.store(head + needed, std::memory_order_release);
+    return true;
+}
+
+void RingBuffer::drain(std::string& out, std::string& err) {
+    u64 tail = m_tail.load(std::memory_order_relaxed);
+    u64 head = m_head.load(std::memory_order_acquire);
+
+    while (tail < head) {
+        u32 header;
+        copy_out(tail, reinterpret_cast<char*>(&header), HEADER_SIZE);
+
+        usize size = header & ~ERR_BIT;
+        std::string& batch = (header & ERR_BIT) ? err : out;
+        usize start = batch.size();
+        batch.resize(start + size);
+        copy_out(tail + HEADER_SIZE, batch.data() + start, size);
+
+        tail += HEADER_SIZE + size;
+    }
+
+    m_tail.store(tail, std::memory_order_release);
+}
+
+/// Shared state of the backend. Rings are never freed, so a thread 
+/// that exits while the backend is running leaves nothing dangling.
+struct Backend {
+    std::atomic<bool> running { false };
+    std::atomic<u32> submitters { 0 }; // threads inside submit, waited for by stop_async
+
+    std::mutex rings_mutex; // guards `rings`
+    std::vector<std::unique_ptr<RingBuffer>> rings;
+
+    std::mutex flush_mutex; // only one consumer drains at a time
+    std::string out_batch;
+    std::string err_batch;
+
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    bool stop_requested = false;
+    std::thread flusher;
+};
+
+static Backend& backend() {
+    static Backend* state = new Backend(); // leaked so it outlives thread_local rings
+    return *state;
+}
+
+/// Get the calling thread's ring, registering it the first time
+static RingBuffer& thread_ring() {
+    thread_local RingBuffer* ring = nullptr;
+    if (ring == nullptr) {
+        Backend& state = backend();
+        std::lock_guard<std::mutex> lock(state.rings_mutex);
+        state.rings.push_back(std::make_unique<RingBuffer>());
+        ring = state.rings.back().get();
+    }
+    return *ring;
+}
+
+void flush() {
+    Backend& state = backend();
+    std::lock_guard<std::mutex> lock(state.flush_mutex);
+
+    {
+        std::lock_guard<std::mutex> rings_lock(state.rings_mutex);
+        for (const std::unique_ptr<RingBuffer>& ring : state.rings) {
+            ring->drain(state.out_batch, state.err_batch);
+        }
+    }
+
+    if (!state.out_batch.empty()) {
+        platform::console_write_raw(state.out_batch.data(), state.out_batch.size());
+        state.out_batch.clear();
+    }
+    if (!state.err_batch.empty()) {
+        platform::console_error_raw(state.err_batch.data(), state.err_batch.size());
+        state.err_batch.clear();
+    }
+}
+
+/// Counts the calling thread as a submitter for as long as it lives
+struct SubmitGuard {
+    std::atomic<u32>& submitters;
+
+    explicit SubmitGuard(std::atomic<u32>& submitters) : submitters(submitters) { submitters.fetch_add(1); }
+    ~SubmitGuard() { submitters.fetch_sub(1); }
+};
+
+bool submit(Stream stream, std::string_view msg) {
+    Backend& state = backend();
+
+    // Registered before `running` is checked, so stop_async either 
+    // makes us see false or waits for us before its last flush
+    SubmitGuard guard(state.submitters);
+    if (!state.running.load()) {
+        return false;
+    }
+
+    // Messages that could never fit in the ring skip it, 
+    // after everything queued before them
+    if (msg.size() + HEADER_SIZE > RingBuffer::CAPACITY / 2) {
+        flush();
+        if (stream == Stream::Err) {
+            platform::console_error_raw(msg.data(), msg.size());
+        } else {
+            platform::console_write_raw(msg.data(), msg.size());
+        }
+        return true;
+    }
+
+    // When the ring is full, make room by flushing from this thread
+    RingBuffer& ring = thread_ring();
+    while (!ring.push(stream, msg)) {
+        flush();
+    }
+    return true;
+}
+
+static void flusher_main() {
+    Backend& state = backend();
+    std::unique_lock<std::mutex> lock(state.wake_mutex);
+
+    while (!state.stop_requested) {
+        state.wake.wait_for(lock, FLUSH_INTERVAL);
+
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+void start_async() {
+    Backend& state = backend();
+    if (state.running.load()) {
+        return;
+    }
+
+    state.stop_requested = false;
+    state.flusher = std::thread(flusher_main);
+    state.running.store(true, std::memory_order_release);
+
+    // Make sure nothing is lost if the program exits without stopping us
+    static bool registered = false;
+    if (!registered) {
+        registered = true;
+        std::atexit(stop_async);
+    }
+}
+
+void stop_async() {
+    Backend& state = backend();
+    if (!state.running.exchange(false)) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(state.wake_mutex);
+        state.stop_requested = true;
+    }
+    state.wake.notify_one();
+    state.flusher.join();
+
+    // Threads that got past the `running` check may still be pushing
+    while (state.submitters.load() != 0) {
+        std::this_thread::yield();
+    }
+    flush();
+}
+
+bool async_enabled() {
+    return backend().running.load(std::memory_order_relaxed);
+}
+
+} // namespace logger
+} // namespace core
+} // namespace compiler
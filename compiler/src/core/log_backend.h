@@ -0,0 +1,59 @@
+#pragma once
+#include "defines.h"
+#include <atomic>
+#include <string>
+#include <string_view>
+
+namespace compiler {
+namespace core {
+namespace logger {
+
+/// Which console stream a log record goes to
+enum class Stream : u8 {
+    Out,
+    Err,
+};
+
+/// Lock free single producer, single consumer byte ring. Each logging
+/// thread owns one and is its only producer, and the flusher is the
+/// only consumer. Records are a 4 byte header (length, with the top 
+/// bit marking stderr) followed by the message bytes.
+class RingBuffer {
+public:
+    static constexpr usize CAPACITY = 64 * 1024; // must be a power of two
+
+    /// Append a message. Returns false if there is not enough room
+    bool push(Stream stream, std::string_view msg);
+
+    /// Move every complete record into the stdout or stderr batch
+    void drain(std::string& out, std::string& err);
+
+private:
+    void copy_in(u64 position, const char* data, usize size);
+    void copy_out(u64 position, char* data, usize size) const;
+
+    alignas(64) std::atomic<u64> m_head { 0 }; // advanced by the producer
+    alignas(64) std::atomic<u64> m_tail { 0 }; // advanced by the consumer
+    char m_data[CAPACITY];
+};
+
+/// Start the asynchronous backend. From now on messages are formatted 
+/// into the calling thread's ring buffer, and a background thread writes
+/// them out in batches with one write per stream.
+void start_async();
+
+/// Flush what is left and stop the background thread
+void stop_async();
+
+/// Whether messages currently go through the asynchronous backend
+bool async_enabled();
+
+/// Write everything that is buffered right now. Called on fatal errors
+void flush();
+
+/// Queue a formatted message. Returns false if the backend is not running
+bool submit(Stream stream, std::string_view msg);
+
+} // namespace logger
+} // namespace core
+} // namespace compiler
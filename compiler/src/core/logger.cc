@@ -0,0 +1,48 @@
+#include "logger.h"
+#include "log_backend.h"
+#include <iterator>
+
+namespace compiler {
+namespace core {
+namespace logger {
+
+void write(Level level, std::string_view format, std::format_args args) {
+    const char* color;
+    const char* tag;
+    switch (level) {
+        case Level::Fatal: color = RED; tag = "[FATAL]"; break;
+        case Level::Error: color = ORANGE; tag = "[ERROR]"; break;
+        case Level::Warn: color = YELLOW; tag = "[WARN]"; break;
+        case Level::Debug: color = MAGENTA; tag = "[DEBUG]"; break;
+        case Level::Info: color = BLUE; tag = "[INFO]"; break;
+        default: color = CYAN; tag = "[TRACE]"; break;
+    }
+
+    // Reused between messages, so formatting does not allocate once it has grown
+    thread_local std::string msg;
+    msg.clear();
+    msg += color;
+    msg += tag;
+    std::vformat_to(std::back_inserter(msg), format, args);
+    msg += DEFAULT;
+    msg += ENDL;
+
+    Stream stream = level >= Level::Error ? Stream::Err : Stream::Out;
+    if (submit(stream, msg)) {
+        // Whatever happens after a fatal error, the messages leading up to it must not be lost
+        if (level == Level::Fatal) {
+            flush();
+        }
+        return;
+    }
+
+    if (stream == Stream::Err) {
+        platform::console_error(msg);
+    } else {
+        platform::console_write(msg);
+    }
+}
+
+} // namespace logger
+} // namespace core
+} // namespace compiler
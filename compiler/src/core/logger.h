@@ -1,7 +1,28 @@
 #pragma once
 #include "platform/platform.h"
+#include <atomic>
 #include <format>
 #include <string>
+#include <string_view>
+
+/// Compile time log threshold. Messages below it are removed entirely 
+/// when logged through the QLOG_* macros, including the evaluation 
+/// of their arguments. Override with -DQ_LOG_LEVEL=Q_LOG_LEVEL_<LEVEL>
+#define Q_LOG_LEVEL_TRACE 0
+#define Q_LOG_LEVEL_DEBUG 1
+#define Q_LOG_LEVEL_INFO  2
+#define Q_LOG_LEVEL_WARN  3
+#define Q_LOG_LEVEL_ERROR 4
+#define Q_LOG_LEVEL_FATAL 5
+#define Q_LOG_LEVEL_OFF   6
+
+#ifndef Q_LOG_LEVEL
+#ifdef QDEBUG
+#define Q_LOG_LEVEL Q_LOG_LEVEL_TRACE
+#else
+#define Q_LOG_LEVEL Q_LOG_LEVEL_INFO
+#endif
+#endif
 
 namespace compiler {
 
@@ -21,54 +42,128 @@ constexpr const char* GREEN = "\x1b[32m";
 constexpr const char* DEFAULT = "\x1b[0m";
 constexpr char ENDL = '\n';
 
+/// Severity of a message. Values line up with the Q_LOG_LEVEL_* macros
+enum class Level : u8 {
+    Trace = Q_LOG_LEVEL_TRACE,
+    Debug = Q_LOG_LEVEL_DEBUG,
+    Info = Q_LOG_LEVEL_INFO,
+    Warn = Q_LOG_LEVEL_WARN,
+    Error = Q_LOG_LEVEL_ERROR,
+    Fatal = Q_LOG_LEVEL_FATAL,
+    Off = Q_LOG_LEVEL_OFF,
+};
+
+/// Run time threshold. Starts at Info
+inline std::atomic<Level>& runtime_level() {
+    static std::atomic<Level> level { Level::Info };
+    return level;
+}
+
+inline void set_level(Level level) {
+    runtime_level().store(level, std::memory_order_relaxed);
+}
+
+/// Whether messages of this level were compiled in
+constexpr bool compiled_in(Level level) {
+    return static_cast<u8>(level) >= Q_LOG_LEVEL;
+}
+
+/// Whether messages of this level should be written
+inline bool enabled(Level level) {
+    return compiled_in(level) 
+        && level >= runtime_level().load(std::memory_order_relaxed);
+}
+
+/// Format the message once, straight into its final buffer, and write it
+void write(Level level, std::string_view format, std::format_args args);
+
 template <typename... Args> 
 void Fatal(const char* format, Args&& ...args) {
-    std::string msg = std::vformat(format, std::make_format_args(args...));
-
-    msg = RED + std::string("[FATAL]") + msg + DEFAULT + ENDL;
-    platform::console_error(msg);
+    if (enabled(Level::Fatal)) {
+        write(Level::Fatal, format, std::make_format_args(args...));
+    }
 }
 
 template <typename... Args> 
 void Error(const char* format, Args&& ...args) {
-    std::string msg = std::vformat(format, std::make_format_args(args...));
-
-    msg = ORANGE + std::string("[ERROR]") + msg + DEFAULT + ENDL;
-    platform::console_error(msg);
+    if (enabled(Level::Error)) {
+        write(Level::Error, format, std::make_format_args(args...));
+    }
 }
 
 template <typename... Args> 
 void Warn(const char* format, Args&& ...args) {
-    std::string msg = std::vformat(format, std::make_format_args(args...));
-
-    msg = YELLOW + std::string("[WARN]") + msg + DEFAULT + ENDL;
-    platform::console_write(msg);
+    if (enabled(Level::Warn)) {
+        write(Level::Warn, format, std::make_format_args(args...));
+    }
 }
 
 template <typename... Args> 
 void Debug(const char* format, Args&& ...args) {
-    std::string msg = std::vformat(format, std::make_format_args(args...));
-
-    msg = MAGENTA + std::string("[DEBUG]") + msg + DEFAULT + ENDL;
-    platform::console_write(msg);
+    if (enabled(Level::Debug)) {
+        write(Level::Debug, format, std::make_format_args(args...));
+    }
 }
 
 template <typename... Args> 
 void Info(const char* format, Args&& ...args) {
-    std::string msg = std::vformat(format, std::make_format_args(args...));
-
-    msg = BLUE + std::string("[INFO]") + msg + DEFAULT + ENDL;
-    platform::console_write(msg);
+    if (enabled(Level::Info)) {
+        write(Level::Info, format, std::make_format_args(args...));
+    }
 }
 
 template <typename... Args> 
 void Trace(const char* format, Args&& ...args) {
-    std::string msg = std::vformat(format, std::make_format_args(args...));
-
-    msg = CYAN + std::string("[TRACE]") + msg + DEFAULT + ENDL;
-    platform::console_write(msg);
+    if (enabled(Level::Trace)) {
+        write(Level::Trace, format, std::make_format_args(args...));
+    }
 }
 
 } // namespace logger
 } // namespace core
 } // namespace compiler
+
+/// Logging macros for hot paths. Arguments are only evaluated when the
+/// level is enabled, and levels below Q_LOG_LEVEL compile to nothing.
+#define QLOG_IMPL(level, ...) \
+    do { \
+        if (::compiler::core::logger::enabled(::compiler::core::logger::Level::level)) { \
+            ::compiler::core::logger::level(__VA_ARGS__); \
+        } \
+    } while (0)
+
+#if Q_LOG_LEVEL <= Q_LOG_LEVEL_TRACE
+#define QLOG_TRACE(...) QLOG_IMPL(Trace, __VA_ARGS__)
+#else
+#define QLOG_TRACE(...) ((void)0)
+#endif
+
+#if Q_LOG_LEVEL <= Q_LOG_LEVEL_DEBUG
+#define QLOG_DEBUG(...) QLOG_IMPL(Debug, __VA_ARGS__)
+#else
+#define QLOG_DEBUG(...) ((void)0)
+#endif
+
+#if Q_LOG_LEVEL <= Q_LOG_LEVEL_INFO
+#define QLOG_INFO(...) QLOG_IMPL(Info, __VA_ARGS__)
+#else
+#define QLOG_INFO(...) ((void)0)
+#endif
+
+#if Q_LOG_LEVEL <= Q_LOG_LEVEL_WARN
+#define QLOG_WARN(...) QLOG_IMPL(Warn, __VA_ARGS__)
+#else
+#define QLOG_WARN(...) ((void)0)
+#endif
+
+#if Q_LOG_LEVEL <= Q_LOG_LEVEL_ERROR
+#define QLOG_ERROR(...) QLOG_IMPL(Error, __VA_ARGS__)
+#else
+#define QLOG_ERROR(...) ((void)0)
+#endif
+
+#if Q_LOG_LEVEL <= Q_LOG_LEVEL_FATAL
+#define QLOG_FATAL(...) QLOG_IMPL(Fatal, __VA_ARGS__)
+#else
+#define QLOG_FATAL(...) ((void)0)
+#endif
@@ -3,13 +3,14 @@
 #include <iostream>
 #include <exception>
 #include <functional>
+#include <new>
 #include <optional>
 #include <ostream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <utility>
-#include <variant>
 
 namespace compiler {
 
@@ -18,6 +19,9 @@ namespace core {
 template <typename T, typename E>
 class Result;
 
+/// Value of a Result that only says whether something succeeded
+struct Unit {};
+
 // For the Ok type of a result
 template <typename T>
 struct Ok {
@@ -29,12 +33,12 @@ struct Ok {
 
     template <typename E>
     constexpr operator Result<T, E>() const& {
-        return Restult<T, E>(Ok(m_value));
+        return Result<T, E>(Ok(m_value));
     }
     
     template <typename E>
     constexpr operator Result<T, E>() && {
-        return Restult<T, E>(Ok(std::move(m_value)));
+        return Result<T, E>(Ok(std::move(m_value)));
     }
 
 private:
@@ -54,110 +58,133 @@ private:
     E m_value;
 };
 
+/// Either a value or an error. The two share storage, so a Result is
+/// no bigger than the larger of them plus a flag, and when both are 
+/// trivially copyable so is the Result: it is returned in registers 
+/// and copied with a plain memcpy.
 template <typename T, typename E>
 class Result {
+    static constexpr bool TRIVIAL = 
+        std::is_trivially_copyable_v<T> && std::is_trivially_copyable_v<E>;
+
 public:
-    Result() 
-        : m_ok(false) {
-    }
-    
-    Result(Ok<T> value) : m_data(value.value()), m_ok(true) {}
-    Result(Err<E> value) : m_data(value.value()), m_ok(false) {}
+    Result(Ok<T> value) : m_value(std::move(value).value()), m_ok(true) {}
+    Result(Err<E> value) : m_error(std::move(value).value()), m_ok(false) {}
 
     // For types that are coercible like pointers to inherited classes
     template<typename U>
-    Result(Ok<U> value) : m_data(static_cast<U>(value.value())), m_ok(true) {}
-
-    ~Result() {
+    Result(Ok<U> value) : m_value(static_cast<T>(std::move(value).value())), m_ok(true) {}
 
+    Result(const Result&) requires TRIVIAL = default;
+    Result(const Result& other) requires (!TRIVIAL) 
+        : m_ok(other.m_ok) {
+        if (m_ok) {
+            new (&m_value) T(other.m_value);
+        } else {
+            new (&m_error) E(other.m_error);
+        }
     }
-    Result(const Result& other) {
-        m_data = other.m_data;
+
+    Result(Result&&) requires TRIVIAL = default;
+    Result(Result&& other) requires (!TRIVIAL) 
+        : m_ok(other.m_ok) {
+        if (m_ok) {
+            new (&m_value) T(std::move(other.m_value));
+        } else {
+            new (&m_error) E(std::move(other.m_error));
+        }
     }
-    Result(Result&& other) {
-        std::swap(other.m_ok, this->m_ok);
-        std::swap(other.m_data, this->m_data);
+
+    Result& operator=(const Result&) requires TRIVIAL = default;
+    Result& operator=(const Result& other) requires (!TRIVIAL) {
+        if (this != &other) {
+            this->~Result();
+            new (this) Result(other);
+        }
+        return *this;
     }
 
-    Result& operator=(Result other) {
-        m_data = other.m_data;
-        m_ok = other.m_ok;
+    Result& operator=(Result&&) requires TRIVIAL = default;
+    Result& operator=(Result&& other) requires (!TRIVIAL) {
+        if (this != &other) {
+            this->~Result();
+            new (this) Result(std::move(other));
+        }
         return *this;
     }
 
+    ~Result() requires TRIVIAL = default;
+    ~Result() requires (!TRIVIAL) {
+        if (m_ok) {
+            m_value.~T();
+        } else {
+            m_error.~E();
+        }
+    }
+
     // [[ Conversion operators ]] //
 
     /// @brief If Result is Ok(), return the value. 
     /// Otherwise, panic
     constexpr T&& unwrap() {
-        if (m_ok) {
-            return std::get<T>(std::move(m_data));
+        if (!m_ok) {
+            terminate("Panic: unwrap failed on Result");
         }
-
-        terminate("Panic: unwrap failed on Result");
-        std::exit(1);
+        return std::move(m_value);
     }
 
     constexpr E&& unwrap_err() {
-        if(!m_ok) {
-            this->terminate("Called `unwrap_err` on Err value");
+        if (m_ok) {
+            terminate("Called `unwrap_err` on Ok value");
         }
-        return std::get<E>(std::move(m_data));
+        return std::move(m_error);
     }
 
-    constexpr T&& unwrap_or(T&& val) {
+    constexpr T unwrap_or(T&& val) {
         if (m_ok) {
-            return std::get<T>(std::move(m_data));
+            return std::move(m_value);
         }
-        return val;
+        return std::move(val);
     }
 
-    constexpr T&& unwrap_or_default() {
+    constexpr T unwrap_or_default() {
         static_assert(
             std::is_default_constructible<T>::value,
             "`unwrap_or_default` requires <T> to be default construbtible"
         );
 
-        if(m_ok) {
-            return std::get<T>(std::move(m_data));
+        if (m_ok) {
+            return std::move(m_value);
         }
         return T();
     }
 
-    constexpr E&& unwrap_err_or(E && error) {
-        static_assert(
-            std::is_default_constructible<E>::value,
-            "`unwrap_or_default` requires <E> to be default construbtible"
-        );
-
-        if (!m_ok) {
-            return E();
+    constexpr E unwrap_err_or(E&& error) {
+        if (m_ok) {
+            return std::move(error);
         }
-        return std::get<E>(std::move(m_data));
+        return std::move(m_error);
     }
 
     constexpr E&& expect_err(const std::string_view& msg) {
-        if(m_ok) {
-            this->terminate(msg);
+        if (m_ok) {
+            terminate(msg);
         }
-
-        return std::get<E>(std::move(m_data));
+        return std::move(m_error);
     }
 
-
-
-
-
-
-    bool is_ok() const { return this->m_ok == true; }
-    bool is_err() const { return this->m_ok == false; }
+    bool is_ok() const { return m_ok; }
+    bool is_err() const { return !m_ok; }
 
 private:
-    std::variant<T, E> m_data;
+    union {
+        T m_value;
+        E m_error;
+    };
     bool m_ok;
 
     /// @brief Panic and termiante program if Result is invalid
-    void terminate(const std::string& msg) {
+    [[ noreturn ]] static void terminate(std::string_view msg) {
         std::cerr << msg << std::endl;
         std::terminate();
     }
@@ -0,0 +1,147 @@
+#include "symbol_table.h"
+#include <algorithm>
+#include <utility>
+
+namespace compiler {
+namespace core {
+
+constexpr usize INITIAL_SLOTS = 32;
+
+/// Symbols are dense, so a multiplicative hash spreads them well
+static inline usize
+hash_symbol(Symbol name) {
+    return static_cast<usize>(name * 0x9E3779B1u);
+}
+
+SymbolTable::SymbolTable(const SymbolTable* parent)
+    : m_parent(parent)
+      , m_scopes(1)
+      , m_depth(1)
+{}
+
+void SymbolTable::push_scope() {
+    if (m_depth == m_scopes.size()) {
+        m_scopes.emplace_back();
+    }
+
+    Scope& scope = m_scopes[m_depth++];
+    scope.begin = static_cast<u32>(m_entries.size());
+    scope.spilled = false;
+}
+
+void SymbolTable::pop_scope() {
+    if (m_depth <= 1) {
+        // The global scope is never popped
+        return;
+    }
+
+    Scope& scope = current();
+    if (scope.spilled) {
+        std::fill(scope.slots.begin(), scope.slots.end(), Slot{ INVALID_SYMBOL, 0 });
+    }
+    m_entries.resize(scope.begin);
+    m_depth--;
+}
+
+bool SymbolTable::declare(Symbol name, SymbolInfo info) {
+    Scope& scope = current();
+    if (find_in(scope, m_entries.size(), name) != nullptr) {
+        return false;
+    }
+
+    u32 entry = static_cast<u32>(m_entries.size());
+    m_entries.push_back(Entry{ name, info });
+
+    if (scope.spilled) {
+        insert_slot(scope, name, entry);
+    } else if (m_entries.size() - scope.begin > INLINE_ENTRIES) {
+        spill(scope);
+    }
+    return true;
+}
+
+SymbolInfo* SymbolTable::lookup_local(Symbol name) {
+    const Entry* entry = find_in(current(), m_entries.size(), name);
+    return entry ? &m_entries[entry - m_entries.data()].info : nullptr;
+}
+
+SymbolInfo* SymbolTable::lookup(Symbol name) {
+    return const_cast<SymbolInfo*>(std::as_const(*this).lookup(name));
+}
+
+const SymbolInfo* SymbolTable::lookup(Symbol name) const {
+    usize end = m_entries.size();
+    for (usize i = m_depth; i-- > 0;) {
+        const Scope& scope = m_scopes[i];
+        if (const Entry* entry = find_in(scope, end, name)) {
+            return &entry->info;
+        }
+        end = scope.begin;
+    }
+
+    return m_parent ? m_parent->lookup(name) : nullptr;
+}
+
+// Find `name` among the entries of `scope`, which end at `end`
+const SymbolTable::Entry* SymbolTable::find_in(const Scope& scope, usize end, Symbol name) const {
+    if (!scope.spilled) {
+        for (usize i = scope.begin; i < end; i++) {
+            if (m_entries[i].name == name) {
+                return &m_entries[i];
+            }
+        }
+        return nullptr;
+    }
+
+    usize mask = scope.slots.size() - 1;
+    for (usize i = hash_symbol(name) & mask;; i = (i + 1) & mask) {
+        const Slot& slot = scope.slots[i];
+        if (slot.name == name) {
+            return &m_entries[slot.entry];
+        }
+        if (slot.name == INVALID_SYMBOL) {
+            return nullptr;
+        }
+    }
+}
+
+void SymbolTable::insert_slot(Scope& scope, Symbol name, u32 entry) {
+    // Keep the load factor under a half so probe sequences stay short
+    if ((entry - scope.begin + 1) * 2 > scope.slots.size()) {
+        std::vector<Slot> slots(scope.slots.size() * 2, Slot{ INVALID_SYMBOL, 0 });
+        usize mask = slots.size() - 1;
+        for (const Slot& slot : scope.slots) {
+            if (slot.name == INVALID_SYMBOL) {
+                continue;
+            }
+            usize i = hash_symbol(slot.name) & mask;
+            while (slots[i].name != INVALID_SYMBOL) {
+                i = (i + 1) & mask;
+            }
+            slots[i] = slot;
+        }
+        scope.slots = std::move(slots);
+    }
+
+    usize mask = scope.slots.size() - 1;
+    usize i = hash_symbol(name) & mask;
+    while (scope.slots[i].name != INVALID_SYMBOL) {
+        i = (i + 1) & mask;
+    }
+    scope.slots[i] = Slot{ name, entry };
+}
+
+// Move a scope from its inline entries to a hash table
+void SymbolTable::spill(Scope& scope) {
+    if (scope.slots.size() < INITIAL_SLOTS) {
+        scope.slots.assign(INITIAL_SLOTS, Slot{ INVALID_SYMBOL, 0 });
+    }
+    scope.spilled = true;
+
+    for (usize i = scope.begin; i < m_entries.size(); i++) {
+        insert_slot(scope, m_entries[i].name, static_cast<u32>(i));
+    }
+}
+
+} // namespace core
+} // namespace compiler
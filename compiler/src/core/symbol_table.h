@@ -0,0 +1,85 @@
+#pragma once
+#include "defines.h"
+#include "interner.h"
+#include "type.h"
+#include <array>
+#include <vector>
+
+namespace compiler {
+namespace core {
+
+struct AstNode;
+
+/// What the symbol table knows about a declared name
+struct SymbolInfo {
+    const Type* type;   // null until the type of the declaration is known
+    AstNode* decl;      // the node that declared the name
+};
+
+/// Names visible at some point of a program, as a stack of scopes.
+/// Each scope keeps its first few names in a small inline array, which 
+/// is scanned linearly. Once a scope outgrows it, the scope gets a flat 
+/// open addressing table keyed by symbol, so scopes with many names 
+/// (like the globals of a large module) are still found in O(1).
+/// Popping a scope only truncates the entry stack; the tables of popped 
+/// scopes are kept and reused by the next scope at the same depth.
+class SymbolTable {
+public:
+    /// Names in a scope before it switches to a hash table
+    static constexpr usize INLINE_ENTRIES = 8;
+
+    /// A table for the global scope. `parent`, if given, is searched when
+    /// a name is not found in this table. It is only read, so several 
+    /// tables can share one parent from different threads
+    explicit SymbolTable(const SymbolTable* parent = nullptr);
+
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    void push_scope();
+    void pop_scope();
+
+    /// Number of open scopes. The global scope counts as one
+    usize depth() const { return m_depth; }
+
+    /// Declare `name` in the innermost scope. Returns false,
+    /// without changing anything, if it is already declared there
+    bool declare(Symbol name, SymbolInfo info);
+
+    /// Find the innermost declaration of `name`. Returns null if there is none
+    SymbolInfo* lookup(Symbol name);
+    const SymbolInfo* lookup(Symbol name) const;
+
+    /// Find `name` in the innermost scope only
+    SymbolInfo* lookup_local(Symbol name);
+
+private:
+    struct Entry {
+        Symbol name;
+        SymbolInfo info;
+    };
+
+    struct Slot {
+        Symbol name;  // INVALID_SYMBOL when empty
+        u32 entry;    // index into m_entries
+    };
+
+    struct Scope {
+        u32 begin = 0;             // first entry of this scope in m_entries
+        bool spilled = false;      // whether `slots` is in use
+        std::vector<Slot> slots;   // size is always a power of two
+    };
+
+    Scope& current() { return m_scopes[m_depth - 1]; }
+    const Entry* find_in(const Scope& scope, usize end, Symbol name) const;
+    void insert_slot(Scope& scope, Symbol name, u32 entry);
+    void spill(Scope& scope);
+
+    const SymbolTable* m_parent;
+    std::vector<Entry> m_entries;  // entries of every open scope, innermost last
+    std::vector<Scope> m_scopes;   // scopes past m_depth are kept for reuse
+    usize m_depth;
+};
+
+} // namespace core
+} // namespace compiler
@@ -0,0 +1,94 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+namespace compiler {
+namespace core {
+
+ThreadPool::ThreadPool(usize workers) {
+    if (workers == 0) {
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    m_threads.reserve(workers - 1);
+    for (usize i = 1; i < workers; i++) {
+        m_threads.emplace_back(&ThreadPool::worker_main, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::parallel_for(usize count, usize grain, const Task& task) {
+    if (count == 0) {
+        return;
+    }
+
+    grain = std::max<usize>(grain, 1);
+    if (m_threads.empty() || count <= grain) {
+        task(0, count, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_count = count;
+        m_grain = grain;
+        m_next.store(0, std::memory_order_relaxed);
+        m_active = m_threads.size();
+        m_generation++;
+    }
+    m_wake.notify_all();
+
+    run_chunks(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_active == 0; });
+    m_task = nullptr;
+}
+
+// Take chunks of the current loop until there are none left
+void ThreadPool::run_chunks(usize worker) {
+    for (;;) {
+        usize begin = m_next.fetch_add(m_grain, std::memory_order_relaxed);
+        if (begin >= m_count) {
+            return;
+        }
+        (*m_task)(begin, std::min(begin + m_grain, m_count), worker);
+    }
+}
+
+void ThreadPool::worker_main(usize worker) {
+    u64 seen = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stopping || m_generation != seen; });
+            if (m_stopping) {
+                return;
+            }
+            seen = m_generation;
+        }
+
+        run_chunks(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_active--;
+        }
+        m_done.notify_one();
+    }
+}
+
+} // namespace core
+} // namespace compiler
@@ -0,0 +1,59 @@
+#pragma once
+#include "defines.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace compiler {
+namespace core {
+
+/// Fixed set of worker threads that run one parallel loop at a time.
+/// The thread that calls `parallel_for` works on the loop as well,
+/// so a pool of one worker runs everything on the calling thread.
+class ThreadPool {
+public:
+    /// Function run for the items [begin, end). `worker` is in [0, size())
+    /// and is the same for everything that one thread runs in a loop
+    using Task = std::function<void(usize begin, usize end, usize worker)>;
+
+    /// Start a pool with `workers` threads, counting the calling thread.
+    /// Zero means one per hardware thread
+    explicit ThreadPool(usize workers = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// Number of threads that run loop bodies, including the caller
+    usize size() const { return m_threads.size() + 1; }
+
+    /// Run `task` over [0, count) in chunks of `grain` items, 
+    /// and return once every chunk is done
+    void parallel_for(usize count, usize grain, const Task& task);
+
+private:
+    void worker_main(usize worker);
+    void run_chunks(usize worker);
+
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;   // a loop started, or the pool is stopping
+    std::condition_variable m_done;   // a worker finished its part of the loop
+
+    // The loop being run
+    const Task* m_task = nullptr;
+    usize m_count = 0;
+    usize m_grain = 1;
+    std::atomic<usize> m_next { 0 };
+
+    u64 m_generation = 0;   // bumped for every loop so workers run each once
+    usize m_active = 0;     // workers still in the current loop
+    bool m_stopping = false;
+};
+
+} // namespace core
+} // namespace compiler
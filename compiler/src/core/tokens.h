@@ -1,6 +1,7 @@
 #pragma once
 #include "defines.h"
 #include "core/logger.h"
+#include "core/interner.h"
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
@@ -8,7 +9,7 @@
 #include <string>
 #include <string_view>
 #include <array>
-#include <variant>
+#include <type_traits>
 #include <iostream>
 
 namespace compiler {
@@ -17,6 +18,15 @@ namespace compiler {
 enum class ReservedToken : std::uint8_t {
     Unknown,
 
+    // Tokens that carry a value instead of being reserved words.
+    // These only serve as kind tags when tokens are stored 
+    // without their variant, see `TokenBuffer`
+    Identifier,
+    Integer,
+    Float,
+    String,
+    Eof,
+
     OpParenOpen,
     OpParenClose,
     OpSubscriptOpen,
@@ -140,6 +150,21 @@ reserved_to_str(ReservedToken token) {
         case ReservedToken::Unknown:
             str = "UNKNOWN";
             break;
+        case ReservedToken::Identifier:
+            str = "IDENTIFIER";
+            break;
+        case ReservedToken::Integer:
+            str = "INTEGER";
+            break;
+        case ReservedToken::Float:
+            str = "FLOAT";
+            break;
+        case ReservedToken::String:
+            str = "STRING";
+            break;
+        case ReservedToken::Eof:
+            str = "EOF";
+            break;
         case ReservedToken::OpParenOpen:
             str = "(";
             break;
@@ -394,55 +419,133 @@ reserved_to_str(ReservedToken token) {
     return str;
 }
 
+/// Location of a token's text in the source buffer. Tokens refer back 
+/// into the source instead of owning a copy of their text, so the 
+/// source must outlive every token that is lexed from it.
+struct SourceSpan {
+    u32 offset;
+    u32 length;
+
+    /// Get the text this span covers in the source
+    [[ nodiscard ]]
+    std::string_view view(std::string_view source) const noexcept {
+        return source.substr(offset, length);
+    }
+};
+
 struct Identifier {
-    ~Identifier() {}
-    Identifier(std::string name) : name(name) {}
-    std::string name;
+    SourceSpan span;
+    core::Symbol symbol; // interned name
+};
+
+/// The contents of a string literal, without the surrounding quotes
+struct String {
+    SourceSpan span;
 };
 
 struct Eof{};
 
 using Integer = u64;
 using Float = f64;
-using String = std::string;
 
+/// Whether tokens of this kind carry a value rather than being a reserved word
+constexpr bool is_value_token(ReservedToken kind) {
+    switch (kind) {
+        case ReservedToken::Identifier:
+        case ReservedToken::Integer:
+        case ReservedToken::Float:
+        case ReservedToken::String:
+        case ReservedToken::Eof:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/// A single token. This is a plain 16 byte tagged struct: the kind, 
+/// the span of source it was lexed from, and an inline number for 
+/// integer and float literals or the interned symbol of an identifier. Copying a token is just a register move.
 class Token {
 public:
-    using ValueType = 
-        std::variant<
-            ReservedToken, 
-            Identifier, 
-            Integer,
-            Float,
-            String, 
-            Eof
-        >;
-
-    Token() noexcept = default;
-    Token( ValueType value) : m_value{std::move(value)} {}
+    /// Tokens can not be longer than this. The lexer reports longer ones
+    static constexpr u32 MAX_LENGTH = (1u << 24) - 1;
+
+    Token() noexcept 
+        : m_kind(static_cast<u32>(ReservedToken::Unknown)), m_length(0), m_offset(0), m_payload{ .integer = 0 } {}
+    Token(ReservedToken token, SourceSpan span = {}) noexcept
+        : Token(token, span, Payload{ .integer = 0 }) {}
+    Token(Identifier identifier) noexcept
+        : Token(ReservedToken::Identifier, identifier.span, Payload{ .symbol = identifier.symbol }) {}
+    Token(String string) noexcept
+        : Token(ReservedToken::String, string.span, Payload{ .integer = 0 }) {}
+    Token(Integer value, SourceSpan span = {}) noexcept
+        : Token(ReservedToken::Integer, span, Payload{ .integer = value }) {}
+    Token(Float value, SourceSpan span = {}) noexcept
+        : Token(ReservedToken::Float, span, Payload{ .floating = value }) {}
+    Token(Eof, SourceSpan span = {}) noexcept
+        : Token(ReservedToken::Eof, span, Payload{ .integer = 0 }) {}
 
     /// Check if this token is of a certain type
     template <typename T>
     [[ nodiscard ]]
     bool is() const noexcept {
-        return std::holds_alternative<T>(m_value);
+        if constexpr (std::is_same_v<T, ReservedToken>) {
+            return !is_value_token(kind());
+        } else if constexpr (std::is_same_v<T, Identifier>) {
+            return kind() == ReservedToken::Identifier;
+        } else if constexpr (std::is_same_v<T, Integer>) {
+            return kind() == ReservedToken::Integer;
+        } else if constexpr (std::is_same_v<T, Float>) {
+            return kind() == ReservedToken::Float;
+        } else if constexpr (std::is_same_v<T, String>) {
+            return kind() == ReservedToken::String;
+        } else {
+            static_assert(std::is_same_v<T, Eof>, "Token::is. Not a token type");
+            return kind() == ReservedToken::Eof;
+        }
     }
 
-    /// Get the value from the variant being held
+    /// Get the value of this token as the type it holds
     template <typename T>
     [[ nodiscard ]]
-    T const& get() const noexcept {
+    T get() const noexcept {
         assert(is<T>());
-        return std::get<T>(m_value);
+        if constexpr (std::is_same_v<T, ReservedToken>) {
+            return kind();
+        } else if constexpr (std::is_same_v<T, Identifier>) {
+            return Identifier{ span(), m_payload.symbol };
+        } else if constexpr (std::is_same_v<T, Integer>) {
+            return m_payload.integer;
+        } else if constexpr (std::is_same_v<T, Float>) {
+            return m_payload.floating;
+        } else if constexpr (std::is_same_v<T, String>) {
+            return String{ span() };
+        } else {
+            static_assert(std::is_same_v<T, Eof>, "Token::get. Not a token type");
+            return Eof{};
+        }
+    }
+
+    /// Get the kind of this token. Reserved tokens are their own kind
+    [[ nodiscard ]]
+    ReservedToken kind() const noexcept {
+        return static_cast<ReservedToken>(m_kind);
     }
 
-    /// Get the value being held
+    /// Get the source this token was lexed from. For strings 
+    /// this is only the contents between the quotes
     [[ nodiscard ]]
-    ValueType const& value() const noexcept {
-        return m_value;
+    SourceSpan span() const noexcept {
+        return { m_offset, m_length };
+    }
+
+    void set_span(SourceSpan span) noexcept {
+        assert(span.length <= MAX_LENGTH);
+        m_offset = span.offset;
+        m_length = span.length;
     }
 
-    void print() {
+    void print(std::string_view source) const {
         if (this->is<ReservedToken>()) {
             core::logger::Debug("Token <[{}] : ReservedToken>", reserved_to_str(this->get<ReservedToken>()));
         } else if (this->is<Integer>()) {
@@ -450,15 +553,17 @@ public:
         } else if (this->is<Float>()) {
             core::logger::Debug("Token<[{}] : Float>", this->get<Float>());
         } else if (this->is<String>()) {
-            core::logger::Debug("Token<[{}] : String>", this->get<String>());
+            core::logger::Debug("Token<[{}] : String>", this->get<String>().span.view(source));
         } else if (this->is<Identifier>()) {
-            core::logger::Debug("Token<[{}] : Identifier>", this->get<Identifier>().name);
+            core::logger::Debug("Token<[{}] : Identifier>", this->get<Identifier>().span.view(source));
         }else if (this->is<Eof>()) {
             core::logger::Debug("Token <__EOF__>");
         }
     }
 
-    std::string to_str() {
+    /// Tokens do not own their text, so the source 
+    /// they were lexed from is needed to print them
+    std::string to_str(std::string_view source) const {
         if (this->is<ReservedToken>()) {
             return std::vformat("<[{}] : ReservedToken>", std::make_format_args(reserved_to_str(this->get<ReservedToken>())));
         } else if (this->is<Integer>()) {
@@ -466,9 +571,9 @@ public:
         } else if (this->is<Float>()) {
             return std::vformat("<[{}] : Float>", std::make_format_args(this->get<Float>()));
         } else if (this->is<String>()) {
-            return std::vformat("<[{}] : String>", std::make_format_args(this->get<String>()));
+            return std::vformat("<[{}] : String>", std::make_format_args(this->get<String>().span.view(source)));
         } else if (this->is<Identifier>()) {
-            return std::vformat("<[{}] : Identifier>", std::make_format_args(this->get<Identifier>().name));
+            return std::vformat("<[{}] : Identifier>", std::make_format_args(this->get<Identifier>().span.view(source)));
         }else if (this->is<Eof>()) {
             return "<__EOF__>";
         }
@@ -476,7 +581,28 @@ public:
         return "Invalid Token";
     }
 private:
-    ValueType m_value;
+    union Payload {
+        Integer integer;
+        Float floating;
+        core::Symbol symbol;
+    };
+
+    Token(ReservedToken kind, SourceSpan span, Payload payload) noexcept
+        : m_kind(static_cast<u32>(kind))
+          , m_length(span.length)
+          , m_offset(span.offset)
+          , m_payload(payload)
+        {
+            assert(span.length <= MAX_LENGTH);
+        }
+
+    u32 m_kind : 8;
+    u32 m_length : 24;
+    u32 m_offset;
+    Payload m_payload;
 };
 
+static_assert(sizeof(Token) == 16, "Token should stay 16 bytes");
+static_assert(std::is_trivially_copyable_v<Token>, "Token should be trivially copyable");
+
 }
@@ -3,6 +3,7 @@
 #include "result.h"
 #include "error.h"
 #include "tokens.h"
+#include "interner.h"
 #include <string>
 #include <vector>
 
@@ -13,36 +14,43 @@ namespace core {
 // Incomplete definitions...
 struct Type;
 
-using ResultType = Result<Type*, Error>;
+using ResultType = Result<const Type*, Error>;
+
+/// Tag of every concrete type, checked by `utils::isa<>` and friends
+enum class TypeKind : u8 {
+    Procedure,
+    Identifier,
+    Integer,
+    Float,
+    Boolean,
+    StringLiteral,
+    Pointer,
+    Array,
+};
 
-/* Abstract interface that should never be instantiated */
+/* Abstract interface that should never be instantiated.
+ * Types are created through the TypeContext, which makes each 
+ * distinct type exactly once. Two types are the same type exactly 
+ * when they are the same pointer, so types are compared with `==` 
+ * on pointers and are never modified after they are made. */
 struct Type {
+    explicit Type(TypeKind kind) : kind(kind) {}
     virtual ~Type() = 0;
-    virtual std::string to_str() = 0;
-    virtual Type* clone_ptr() const = 0;
-
-    // TODO: we might not need this?
-    // If we do not want to provide implicit type 
-    // conversions then we should not allow this 
-    // behavior.
-    static ResultType coalesce(const Type* t1, const Type* t2);
+    virtual std::string to_str() const = 0;
 
-    virtual const bool operator==(const Type* other) = 0;
-
-    Type* arg;
+    const TypeKind kind;
 };
 
 
 // TODO: finish representing proceudre types
 // Represents a procedure type
 struct TypeProcedure : public Type {
+    TypeProcedure() : Type(TypeKind::Procedure) {}
     ~TypeProcedure() override {}
-    Type* clone_ptr() const override;
-    std::string to_str() override;
-    const bool operator==(const Type* other) override;
+    std::string to_str() const override;
+    static bool classof(const Type* t) { return t->kind == TypeKind::Procedure; }
 };
 
-// TODO: Use symbols for this type
 // This is meant to be used for structs and enums
 // not variables. Variables will be BOUND
 // to a type that can be an identifier.
@@ -50,24 +58,24 @@ struct TypeProcedure : public Type {
 // `let x: MyEnum = ...`
 // MyEnum will be the type
 struct TypeIdentifier : public Type {
-    TypeIdentifier() {}
+    TypeIdentifier(Symbol name) : Type(TypeKind::Identifier), name(name) {}
     ~TypeIdentifier() override {}
-    Type* clone_ptr() const override;
-    std::string to_str() override;
-    const bool operator==(const Type* other) override;
+    std::string to_str() const override;
+    static bool classof(const Type* t) { return t->kind == TypeKind::Identifier; }
+
+    Symbol name; // name of the type
 };
 
 // Represents an integer type
 struct TypeInteger : public Type {
     ~TypeInteger() override {}
-    TypeInteger(const ReservedToken& token);
     TypeInteger(bool is_signed, i32 size)
-        : is_signed(is_signed)
+        : Type(TypeKind::Integer)
+          , is_signed(is_signed)
           , size(size)
         {}
-    Type* clone_ptr() const override;
-    std::string to_str() override;
-    const bool operator==(const Type* other) override;
+    std::string to_str() const override;
+    static bool classof(const Type* t) { return t->kind == TypeKind::Integer; }
 
     bool is_signed; // whether the integer is signed or not
     i32 size;       // size of the integer in BYTES
@@ -76,63 +84,54 @@ struct TypeInteger : public Type {
 // Represents a floating point value type
 struct TypeFloat : public Type {
     ~TypeFloat() override {}
-    TypeFloat(const ReservedToken& token);
-    TypeFloat(i32 size) : size(size) {}
-    Type* clone_ptr() const override;
+    TypeFloat(i32 size) : Type(TypeKind::Float), size(size) {}
+    std::string to_str() const override;
+    static bool classof(const Type* t) { return t->kind == TypeKind::Float; }
 
-    const bool operator==(const Type* other) override;
-    
-    std::string to_str() override;
-
-    i32 size;
+    i32 size; // size of the float in BYTES
 };
 
 // Represents a boolean value type
 struct TypeBoolean : public Type {
-    TypeBoolean() noexcept = default;
+    TypeBoolean() : Type(TypeKind::Boolean) {}
     ~TypeBoolean() override {}
-    Type* clone_ptr() const override;
-    std::string to_str() override;
-    const bool operator==(const Type* other) override;
+    std::string to_str() const override;
+    static bool classof(const Type* t) { return t->kind == TypeKind::Boolean; }
 };
 
 // Represents the type of a string literal value
 struct TypeStringLiteral : public Type {
+    TypeStringLiteral() : Type(TypeKind::StringLiteral) {}
     ~TypeStringLiteral() override {}
-    Type* clone_ptr() const override;
-    std::string to_str() override;
-    const bool operator==(const Type* other) override;
+    std::string to_str() const override;
+    static bool classof(const Type* t) { return t->kind == TypeKind::StringLiteral; }
 };
 
 // Represents the type of a pointer value
 struct TypePointer : public Type {
-    TypePointer(Type* target)
-        : target(target)
+    TypePointer(const Type* target)
+        : Type(TypeKind::Pointer)
+          , target(target)
         {}
-    ~TypePointer() override {
-        delete target;
-    }
-    Type* clone_ptr() const override;
-    std::string to_str() override;
-    const bool operator==(const Type* other) override;
-
-    Type* target; // the type that this is a pointer to
+    ~TypePointer() override {}
+    std::string to_str() const override;
+    static bool classof(const Type* t) { return t->kind == TypeKind::Pointer; }
+
+    const Type* target; // the type that this is a pointer to
 };
 
 // Represents the type of an array value
 struct TypeArray : public Type {
-    TypeArray(Type* target, i32 length)
-        : target(target)
+    TypeArray(const Type* target, i32 length)
+        : Type(TypeKind::Array)
+          , target(target)
           , length(length)
         {}
-    ~TypeArray() override {
-        delete target;
-    }
-    Type* clone_ptr() const override;
-    std::string to_str() override;
-    const bool operator==(const Type* other) override;
-
-    Type* target; // The data type that this is an array of
+    ~TypeArray() override {}
+    std::string to_str() const override;
+    static bool classof(const Type* t) { return t->kind == TypeKind::Array; }
+
+    const Type* target; // The data type that this is an array of
     i32 length;       // The amount of elements in this array
 };
 
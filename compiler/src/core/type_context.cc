@@ -0,0 +1,142 @@
+#include "type_context.h"
+#include "core/utils.h"
+#include "core/logger.h"
+#include <algorithm>
+#include <bit>
+#include <mutex>
+
+namespace compiler {
+namespace core {
+
+TypeContext::TypeContext()
+    : m_integers{{
+        { TypeInteger(false, 1), TypeInteger(false, 2), TypeInteger(false, 4), TypeInteger(false, 8) },
+        { TypeInteger(true, 1), TypeInteger(true, 2), TypeInteger(true, 4), TypeInteger(true, 8) },
+      }}
+      , m_floats{ TypeFloat(4), TypeFloat(8) }
+{}
+
+const TypeInteger* TypeContext::integer(bool is_signed, i32 size) const {
+    if (size <= 0 || size > 8 || !std::has_single_bit(static_cast<u32>(size))) {
+        core::logger::Fatal("Invalid integer size: {} bytes", size);
+        return nullptr;
+    }
+    return &m_integers[is_signed][std::countr_zero(static_cast<u32>(size))];
+}
+
+const TypeFloat* TypeContext::floating(i32 size) const {
+    if (size != 4 && size != 8) {
+        core::logger::Fatal("Invalid float size: {} bytes", size);
+        return nullptr;
+    }
+    return &m_floats[size == 8];
+}
+
+template <typename Map, typename Key, typename Make>
+auto TypeContext::intern(Map& table, const Key& key, Make make) {
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        auto it = table.find(key);
+        if (it != table.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    auto [it, inserted] = table.try_emplace(key, nullptr);
+    if (inserted) {
+        it->second = make();
+    }
+    return it->second;
+}
+
+const TypePointer* TypeContext::pointer(const Type* target) {
+    return intern(m_pointers, target, [&] { 
+        return m_arena.make<TypePointer>(target); 
+    });
+}
+
+const TypeArray* TypeContext::array(const Type* target, i32 length) {
+    return intern(m_arrays, ArrayKey{ target, length }, [&] { 
+        return m_arena.make<TypeArray>(target, length); 
+    });
+}
+
+const TypeIdentifier* TypeContext::identifier(Symbol name) {
+    return intern(m_identifiers, name, [&] { 
+        return m_arena.make<TypeIdentifier>(name); 
+    });
+}
+
+const Type* TypeContext::primitive(ReservedToken token) const {
+    switch (token) {
+        // Unsigned integers
+        case ReservedToken::KwU8: return integer(false, 1);
+        case ReservedToken::KwU16: return integer(false, 2);
+        case ReservedToken::KwU32: return integer(false, 4);
+        case ReservedToken::KwU64: return integer(false, 8);
+
+        // Signed integers
+        case ReservedToken::KwI8: return integer(true, 1);
+        case ReservedToken::KwI16: return integer(true, 2);
+        case ReservedToken::KwI32: return integer(true, 4);
+        case ReservedToken::KwI64: return integer(true, 8);
+
+        // Floating point numbers
+        case ReservedToken::KwF32: return floating(4);
+        case ReservedToken::KwF64: return floating(8);
+
+        default: return nullptr;
+    }
+}
+
+ResultType TypeContext::coalesce(const Type* t1, const Type* t2) {
+    if (t1 == t2 && t1 != nullptr) {
+        // Every type coalesces with itself
+        return Ok(t1);
+    }
+
+    const Type* coalesced = intern(m_coalesced, std::make_pair(t1, t2), [&] {
+        return compute_coalesce(t1, t2);
+    });
+
+    if (coalesced == nullptr) {
+        // TODO: Get better error handling here
+        return Err(Error(ErrorCode::InvalidCoalesce));
+    }
+    return Ok(coalesced);
+}
+
+const Type* TypeContext::compute_coalesce(const Type* t1, const Type* t2) const {
+    const TypeInteger* int_t1 = utils::dyn_cast<TypeInteger>(t1);
+    const TypeInteger* int_t2 = utils::dyn_cast<TypeInteger>(t2);
+    const TypeFloat* fp_t1 = utils::dyn_cast<TypeFloat>(t1);
+    const TypeFloat* fp_t2 = utils::dyn_cast<TypeFloat>(t2);
+
+    if (int_t1 && int_t2) {
+        // Integer to integer coalesce.
+        // If either t1 or t2 is signed, then the coalesced one needs to be as well.
+        // If neither are signed, then the result should stay unsigned
+        return integer(
+            int_t1->is_signed || int_t2->is_signed,
+            std::max(int_t1->size, int_t2->size)
+        );
+    } else if ((int_t1 && fp_t2) || (fp_t1 && int_t2)) {
+        // If either one of the two types is a float, then
+        // the coalesced type is a floating point as well.
+        // For now, we will just cast to a 64-bit floating
+        // point number to retain as much information as 
+        // possible
+        return floating(8);
+    } else if (fp_t1 && fp_t2) {
+        // Both types are floating point values.
+        // In this case, we take the size of the 
+        // larger one as the coalesced type size
+        return floating(std::max(fp_t1->size, fp_t2->size));
+    }
+
+    return nullptr;
+}
+
+} // namespace core
+} // namespace compiler
@@ -0,0 +1,94 @@
+#pragma once
+#include "defines.h"
+#include "type.h"
+#include "arena.h"
+#include "interner.h"
+#include "tokens.h"
+#include <array>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace compiler {
+namespace core {
+
+/// Owns every type in a program and makes each distinct type exactly once.
+/// Asking for the same type twice returns the same pointer, so types are 
+/// compared by pointer and never need to be copied or freed one by one.
+/// It is safe to use from several threads: primitive types are fixed,
+/// and the tables of the other types take a lock only to add new ones.
+class TypeContext {
+public:
+    TypeContext();
+
+    TypeContext(const TypeContext&) = delete;
+    TypeContext& operator=(const TypeContext&) = delete;
+
+    /// Integer type of `size` bytes. `size` must be 1, 2, 4 or 8
+    const TypeInteger* integer(bool is_signed, i32 size) const;
+
+    /// Floating point type of `size` bytes. `size` must be 4 or 8
+    const TypeFloat* floating(i32 size) const;
+
+    const TypeBoolean* boolean() const { return &m_boolean; }
+    const TypeStringLiteral* string_literal() const { return &m_string_literal; }
+
+    const TypePointer* pointer(const Type* target);
+    const TypeArray* array(const Type* target, i32 length);
+    const TypeIdentifier* identifier(Symbol name);
+
+    /// Type named by a primitive type keyword like `i32` or `f64`.
+    /// Returns nullptr for any other token
+    const Type* primitive(ReservedToken token) const;
+
+    /// Find the type that values of types `t1` and `t2` are
+    /// converted to when they are used together, like in `t1 + t2`.
+    /// Results are remembered, so each pair is only worked out once
+    ResultType coalesce(const Type* t1, const Type* t2);
+
+private:
+    struct PairHash {
+        usize operator()(const std::pair<const Type*, const Type*>& pair) const {
+            usize h1 = std::hash<const Type*>()(pair.first);
+            usize h2 = std::hash<const Type*>()(pair.second);
+            return h1 ^ (h2 + 0x9e3779b97f4a7c15ull + (h1 << 6) + (h1 >> 2));
+        }
+    };
+
+    struct ArrayKey {
+        const Type* target;
+        i32 length;
+        bool operator==(const ArrayKey& other) const = default;
+    };
+
+    struct ArrayKeyHash {
+        usize operator()(const ArrayKey& key) const {
+            return std::hash<const Type*>()(key.target) ^ (static_cast<usize>(key.length) * 0x9e3779b97f4a7c15ull);
+        }
+    };
+
+    const Type* compute_coalesce(const Type* t1, const Type* t2) const;
+
+    /// Find `key` in `table`, making its type with `make` if it is not there
+    template <typename Map, typename Key, typename Make>
+    auto intern(Map& table, const Key& key, Make make);
+
+    mutable std::shared_mutex m_mutex; // guards the tables and the arena
+    Arena m_arena;
+
+    // Primitive types live inline. Integers are indexed by
+    // [is_signed][log2(size)] and floats by [size == 8]
+    std::array<std::array<TypeInteger, 4>, 2> m_integers;
+    std::array<TypeFloat, 2> m_floats;
+    TypeBoolean m_boolean;
+    TypeStringLiteral m_string_literal;
+
+    std::unordered_map<const Type*, const TypePointer*> m_pointers;
+    std::unordered_map<ArrayKey, const TypeArray*, ArrayKeyHash> m_arrays;
+    std::unordered_map<Symbol, const TypeIdentifier*> m_identifiers;
+
+    // nullptr marks a pair that cannot be coalesced
+    std::unordered_map<std::pair<const Type*, const Type*>, const Type*, PairHash> m_coalesced;
+};
+
+} // namespace core
+} // namespace compiler
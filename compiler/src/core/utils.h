@@ -1,13 +1,37 @@
 #pragma once
+#include <cassert>
+#include <type_traits>
 
 namespace compiler {
 namespace core {
 
 namespace utils {
 
+/// Kind checks for the AST and Type hierarchies. Every class in them
+/// has a `static bool classof(const Base*)` that looks at the kind tag
+/// stored in the base, so these are a compare instead of a `dynamic_cast`.
+
+/// Is `src` a `DstT`? `src` must not be null
+template <typename DstT, typename SrcT>
+bool isa(const SrcT* src) {
+    assert(src != nullptr && "isa<> on a null pointer");
+    return DstT::classof(src);
+}
+
+/// Cast `src` to a `DstT`, which it must be
+template <typename DstT, typename SrcT>
+auto cast(SrcT* src) {
+    assert(isa<DstT>(src) && "cast<> to the wrong kind");
+    using Dst = std::conditional_t<std::is_const_v<SrcT>, const DstT, DstT>;
+    return static_cast<Dst*>(src);
+}
+
+/// Cast `src` to a `DstT` if it is one, otherwise return null. 
+/// A null `src` gives null
 template <typename DstT, typename SrcT>
-bool is_type(const SrcT* src) {
-    return dynamic_cast<const DstT*>(src) != nullptr;
+auto dyn_cast(SrcT* src) {
+    using Dst = std::conditional_t<std::is_const_v<SrcT>, const DstT, DstT>;
+    return (src != nullptr && DstT::classof(src)) ? static_cast<Dst*>(src) : nullptr;
 }
 
 } // namespace utils
@@ -0,0 +1,365 @@
+#include "const_eval.h"
+#include "core/utils.h"
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace compiler {
+namespace core {
+namespace const_eval {
+
+// Folded literals fit in the operator node they replace, so folding never allocates
+static_assert(sizeof(AstIntegerExpr) <= sizeof(AstPrefixExpr) && sizeof(AstIntegerExpr) <= sizeof(AstBinaryExpr));
+static_assert(sizeof(AstFloatExpr) <= sizeof(AstPrefixExpr) && sizeof(AstFloatExpr) <= sizeof(AstBinaryExpr));
+static_assert(sizeof(AstBoolExpr) <= sizeof(AstPrefixExpr) && sizeof(AstBoolExpr) <= sizeof(AstBinaryExpr));
+static_assert(alignof(AstIntegerExpr) <= alignof(AstBinaryExpr) && alignof(AstFloatExpr) <= alignof(AstBinaryExpr));
+
+/// Mask of the bits that an integer of `size` bytes uses
+static u64 
+width_mask(i32 size) {
+    return size >= 8 ? ~u64(0) : (u64(1) << (size * 8)) - 1;
+}
+
+/// Bring `bits` into the form integer constants of `type` are stored in:
+/// truncated to its width, and sign extended to 64 bits if it is signed
+static u64 
+normalize(u64 bits, const TypeInteger* type) {
+    if (type->size >= 8) {
+        return bits;
+    }
+
+    u64 mask = width_mask(type->size);
+    bits &= mask;
+    if (type->is_signed && (bits >> (type->size * 8 - 1)) & 1) {
+        bits |= ~mask;
+    }
+    return bits;
+}
+
+/// Can the constant `bits` of type `from` be represented in `to`?
+static bool 
+fits(u64 bits, const TypeInteger* from, const TypeInteger* to) {
+    if (from->is_signed && static_cast<i64>(bits) < 0) {
+        if (!to->is_signed) {
+            return false;
+        }
+        i64 min = to->size >= 8 
+            ? std::numeric_limits<i64>::min() 
+            : -(i64(1) << (to->size * 8 - 1));
+        return static_cast<i64>(bits) >= min;
+    }
+
+    u64 max = to->is_signed ? width_mask(to->size) >> 1 : width_mask(to->size);
+    return bits <= max;
+}
+
+/// Round `value` to the precision of `type`
+static f64 
+round_to(f64 value, const TypeFloat* type) {
+    return type->size == 4 ? static_cast<f64>(static_cast<f32>(value)) : value;
+}
+
+/// Value of a numeric constant as a double
+static f64 
+as_f64(const AstExpr* expr) {
+    if (const AstFloatExpr* floating = utils::dyn_cast<AstFloatExpr>(expr)) {
+        return floating->value;
+    }
+
+    const AstIntegerExpr* integer = utils::cast<AstIntegerExpr>(expr);
+    const TypeInteger* type = utils::cast<TypeInteger>(integer->type);
+    return type->is_signed 
+        ? static_cast<f64>(static_cast<i64>(integer->value)) 
+        : static_cast<f64>(integer->value);
+}
+
+/// Type of a numeric constant
+static const Type* 
+numeric_type(const AstExpr* expr) {
+    if (const AstFloatExpr* floating = utils::dyn_cast<AstFloatExpr>(expr)) {
+        return floating->type;
+    }
+    return utils::cast<AstIntegerExpr>(expr)->type;
+}
+
+static AnalyzeResult 
+replace_integer(ExprRef ref, AnalysisContext& ctx, u64 bits, const TypeInteger* type) {
+    ref.replace<AstIntegerExpr>(ctx.arena, normalize(bits, type), static_cast<const Type*>(type));
+    return Ok(Unit());
+}
+
+static AnalyzeResult 
+replace_float(ExprRef ref, AnalysisContext& ctx, f64 value, const TypeFloat* type) {
+    ref.replace<AstFloatExpr>(ctx.arena, round_to(value, type), static_cast<const Type*>(type));
+    return Ok(Unit());
+}
+
+static AnalyzeResult 
+replace_bool(ExprRef ref, AnalysisContext& ctx, bool value) {
+    ref.replace<AstBoolExpr>(ctx.arena, value, static_cast<const Type*>(ctx.types.boolean()));
+    return Ok(Unit());
+}
+
+bool is_constant(const AstExpr* expr) {
+    return expr != nullptr 
+        && (expr->kind == AstKind::IntegerExpr 
+            || expr->kind == AstKind::FloatExpr 
+            || expr->kind == AstKind::BoolExpr);
+}
+
+static AnalyzeResult 
+fold_integer(ExprRef ref, const AstBinaryExpr* expr, const AstIntegerExpr* lhs, const AstIntegerExpr* rhs, AnalysisContext& ctx) {
+    const TypeInteger* lhs_type = utils::cast<TypeInteger>(lhs->type);
+    const TypeInteger* rhs_type = utils::cast<TypeInteger>(rhs->type);
+
+    // Shifts keep the type of the value being shifted
+    if (expr->op == Operator::SHIFT_LEFT || expr->op == Operator::SHIFT_RIGHT) {
+        u64 amount = rhs->value;
+        if ((rhs_type->is_signed && static_cast<i64>(amount) < 0) || amount >= static_cast<u64>(lhs_type->size * 8)) {
+            return Err(Error(ErrorCode::ShiftOutOfRange, { DiagnosticArg::integer(static_cast<i64>(amount)) }));
+        }
+
+        u64 value = lhs->value;
+        if (expr->op == Operator::SHIFT_LEFT) {
+            return replace_integer(ref, ctx, value << amount, lhs_type);
+        }
+        // Signed values are stored sign extended, so this is an arithmetic shift for them
+        u64 shifted = lhs_type->is_signed 
+            ? static_cast<u64>(static_cast<i64>(value) >> amount) 
+            : value >> amount;
+        return replace_integer(ref, ctx, shifted, lhs_type);
+    }
+
+    ResultType coalesced = ctx.types.coalesce(lhs_type, rhs_type);
+    if (coalesced.is_err()) {
+        return Err(coalesced.unwrap_err());
+    }
+    const TypeInteger* type = utils::cast<TypeInteger>(coalesced.unwrap());
+
+    u64 a = normalize(lhs->value, type);
+    u64 b = normalize(rhs->value, type);
+    i64 sa = static_cast<i64>(a);
+    i64 sb = static_cast<i64>(b);
+
+    switch (expr->op) {
+        case Operator::PLUS: return replace_integer(ref, ctx, a + b, type);
+        case Operator::MINUS: return replace_integer(ref, ctx, a - b, type);
+        case Operator::MUL: return replace_integer(ref, ctx, a * b, type);
+        case Operator::BINARY_AND: return replace_integer(ref, ctx, a & b, type);
+        case Operator::BINARY_OR: return replace_integer(ref, ctx, a | b, type);
+        case Operator::BINARY_XOR: return replace_integer(ref, ctx, a ^ b, type);
+
+        case Operator::DIV:
+        case Operator::MOD: {
+            if (b == 0) {
+                return Err(Error(ErrorCode::DivisionByZero));
+            }
+
+            bool is_div = expr->op == Operator::DIV;
+            if (!type->is_signed) {
+                return replace_integer(ref, ctx, is_div ? a / b : a % b, type);
+            }
+            // The one signed division that overflows wraps around
+            if (sa == std::numeric_limits<i64>::min() && sb == -1) {
+                return replace_integer(ref, ctx, is_div ? a : 0, type);
+            }
+            return replace_integer(ref, ctx, static_cast<u64>(is_div ? sa / sb : sa % sb), type);
+        }
+
+        case Operator::EQUAL: return replace_bool(ref, ctx, a == b);
+        case Operator::NOT_EQUAL: return replace_bool(ref, ctx, a != b);
+        case Operator::LESS_THAN: return replace_bool(ref, ctx, type->is_signed ? sa < sb : a < b);
+        case Operator::GREATER_THAN: return replace_bool(ref, ctx, type->is_signed ? sa > sb : a > b);
+        case Operator::LESS_EQUAL: return replace_bool(ref, ctx, type->is_signed ? sa <= sb : a <= b);
+        case Operator::GREATER_EQUAL: return replace_bool(ref, ctx, type->is_signed ? sa >= sb : a >= b);
+
+        default:
+            return Ok(Unit());
+    }
+}
+
+static AnalyzeResult 
+fold_float(ExprRef ref, const AstBinaryExpr* expr, const AstExpr* lhs, const AstExpr* rhs, AnalysisContext& ctx) {
+    ResultType coalesced = ctx.types.coalesce(numeric_type(lhs), numeric_type(rhs));
+    if (coalesced.is_err()) {
+        return Err(coalesced.unwrap_err());
+    }
+    const TypeFloat* type = utils::cast<TypeFloat>(coalesced.unwrap());
+
+    f64 a = round_to(as_f64(lhs), type);
+    f64 b = round_to(as_f64(rhs), type);
+
+    switch (expr->op) {
+        case Operator::PLUS: return replace_float(ref, ctx, a + b, type);
+        case Operator::MINUS: return replace_float(ref, ctx, a - b, type);
+        case Operator::MUL: return replace_float(ref, ctx, a * b, type);
+        case Operator::DIV: return replace_float(ref, ctx, a / b, type);
+        case Operator::MOD: return replace_float(ref, ctx, std::fmod(a, b), type);
+
+        case Operator::EQUAL: return replace_bool(ref, ctx, a == b);
+        case Operator::NOT_EQUAL: return replace_bool(ref, ctx, a != b);
+        case Operator::LESS_THAN: return replace_bool(ref, ctx, a < b);
+        case Operator::GREATER_THAN: return replace_bool(ref, ctx, a > b);
+        case Operator::LESS_EQUAL: return replace_bool(ref, ctx, a <= b);
+        case Operator::GREATER_EQUAL: return replace_bool(ref, ctx, a >= b);
+
+        default:
+            return Ok(Unit());
+    }
+}
+
+static AnalyzeResult 
+fold_boolean(ExprRef ref, const AstBinaryExpr* expr, bool a, bool b, AnalysisContext& ctx) {
+    switch (expr->op) {
+        case Operator::LOGICAL_AND: return replace_bool(ref, ctx, a && b);
+        case Operator::LOGICAL_OR: return replace_bool(ref, ctx, a || b);
+        case Operator::EQUAL: return replace_bool(ref, ctx, a == b);
+        case Operator::NOT_EQUAL: return replace_bool(ref, ctx, a != b);
+        default: return Ok(Unit());
+    }
+}
+
+AnalyzeResult fold_binary(ExprRef ref, AnalysisContext& ctx) {
+    const AstBinaryExpr* expr = utils::cast<AstBinaryExpr>(ref.get());
+    const AstExpr* lhs = expr->lhs;
+    const AstExpr* rhs = expr->rhs;
+
+    if (lhs->kind == AstKind::IntegerExpr && rhs->kind == AstKind::IntegerExpr) {
+        return fold_integer(ref, expr, utils::cast<AstIntegerExpr>(lhs), utils::cast<AstIntegerExpr>(rhs), ctx);
+    }
+
+    if (lhs->kind == AstKind::BoolExpr && rhs->kind == AstKind::BoolExpr) {
+        return fold_boolean(ref, expr, utils::cast<AstBoolExpr>(lhs)->value, utils::cast<AstBoolExpr>(rhs)->value, ctx);
+    }
+
+    bool lhs_numeric = lhs->kind == AstKind::IntegerExpr || lhs->kind == AstKind::FloatExpr;
+    bool rhs_numeric = rhs->kind == AstKind::IntegerExpr || rhs->kind == AstKind::FloatExpr;
+    if (lhs_numeric && rhs_numeric) {
+        return fold_float(ref, expr, lhs, rhs, ctx);
+    }
+
+    return Ok(Unit());
+}
+
+AnalyzeResult fold_prefix(ExprRef ref, AnalysisContext& ctx) {
+    const AstPrefixExpr* expr = utils::cast<AstPrefixExpr>(ref.get());
+    const AstExpr* operand = expr->rhs;
+
+    switch (expr->op) {
+        case Operator::MINUS:
+            if (const AstIntegerExpr* integer = utils::dyn_cast<AstIntegerExpr>(operand)) {
+                const TypeInteger* type = utils::cast<TypeInteger>(integer->type);
+                if (type->is_signed) {
+                    return replace_integer(ref, ctx, u64(0) - integer->value, type);
+                }
+
+                // Negating an unsigned constant gives the signed type of
+                // the same width, so `-5` is an i64. A value that only 
+                // fits in the unsigned type, like a u8 of 200, is negated
+                // as an i64, so the result is never wrapped around
+                u64 magnitude = integer->value;
+                if (magnitude > (u64(1) << 63)) {
+                    return Err(Error(ErrorCode::NegationOutOfRange, { DiagnosticArg::text(std::to_string(magnitude)) }));
+                }
+                const TypeInteger* signed_type = magnitude <= (u64(1) << (type->size * 8 - 1))
+                    ? ctx.types.integer(true, type->size)
+                    : ctx.types.integer(true, 8);
+                return replace_integer(ref, ctx, u64(0) - magnitude, signed_type);
+            }
+            if (const AstFloatExpr* floating = utils::dyn_cast<AstFloatExpr>(operand)) {
+                return replace_float(ref, ctx, -floating->value, utils::cast<TypeFloat>(floating->type));
+            }
+            break;
+
+        case Operator::BINARY_NOT:
+            if (const AstIntegerExpr* integer = utils::dyn_cast<AstIntegerExpr>(operand)) {
+                return replace_integer(ref, ctx, ~integer->value, utils::cast<TypeInteger>(integer->type));
+            }
+            break;
+
+        case Operator::LOGICAL_NOT:
+            if (const AstBoolExpr* boolean = utils::dyn_cast<AstBoolExpr>(operand)) {
+                return replace_bool(ref, ctx, !boolean->value);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return Ok(Unit());
+}
+
+bool convert(AstExpr* expr, const Type* target) {
+    if (expr->get_type() == target) {
+        return true;
+    }
+
+    if (AstIntegerExpr* integer = utils::dyn_cast<AstIntegerExpr>(expr)) {
+        const TypeInteger* to = utils::dyn_cast<TypeInteger>(target);
+        if (to == nullptr || !fits(integer->value, utils::cast<TypeInteger>(integer->type), to)) {
+            return false;
+        }
+        integer->value = normalize(integer->value, to);
+        integer->type = to;
+        return true;
+    }
+
+    if (AstFloatExpr* floating = utils::dyn_cast<AstFloatExpr>(expr)) {
+        const TypeFloat* to = utils::dyn_cast<TypeFloat>(target);
+        if (to == nullptr) {
+            return false;
+        }
+        floating->value = round_to(floating->value, to);
+        floating->type = to;
+        return true;
+    }
+
+    return false;
+}
+
+void expect_type(AstExpr* expr, const Type* target) {
+    struct Frame {
+        AstExpr* expr;
+        bool typed;  // does its type become the type of the root?
+    };
+
+    // Nothing is converted until every operand whose type becomes the
+    // type of the root is known to be a literal. Others, like the 
+    // amount of a shift, do not matter
+    std::vector<AstExpr*> literals;
+    std::vector<Frame> stack = { Frame{ expr, true } };
+    while (!stack.empty()) {
+        Frame frame = stack.back();
+        stack.pop_back();
+
+        if (!frame.typed) {
+            continue;
+        }
+
+        if (is_constant(frame.expr)) {
+            literals.push_back(frame.expr);
+        } else if (AstBinaryExpr* binary = utils::dyn_cast<AstBinaryExpr>(frame.expr)) {
+            // Arithmetic, shifts and bitwise operators have the type of their
+            // operands, except for the amount of a shift
+            bool passes = binary->op <= Operator::BINARY_XOR;
+            bool is_shift = binary->op == Operator::SHIFT_LEFT || binary->op == Operator::SHIFT_RIGHT;
+            stack.push_back(Frame{ binary->lhs, passes });
+            stack.push_back(Frame{ binary->rhs, passes && !is_shift });
+        } else if (AstPrefixExpr* prefix = utils::dyn_cast<AstPrefixExpr>(frame.expr)) {
+            bool passes = prefix->op == Operator::MINUS || prefix->op == Operator::BINARY_NOT;
+            stack.push_back(Frame{ prefix->rhs, passes });
+        } else {
+            return;
+        }
+    }
+
+    for (AstExpr* literal : literals) {
+        convert(literal, target);
+    }
+}
+
+} // namespace const_eval
+} // namespace core
+} // namespace compiler
@@ -0,0 +1,43 @@
+#pragma once
+#include "defines.h"
+#include "core/ast.h"
+#include "core/type.h"
+#include "core/result.h"
+#include "core/error.h"
+
+namespace compiler {
+namespace core {
+
+/// Evaluation of constant expressions during semantic analysis.
+/// Operands that are literals are folded with the width and sign of 
+/// their TypeInteger, so `u8` arithmetic wraps at 256 and signed
+/// comparisons are signed. A folded node is replaced through its ExprRef 
+/// by a literal, which is built in the storage of the operator node it 
+/// replaces, so folding never allocates.
+namespace const_eval {
+
+/// Is `expr` an integer, float or boolean literal?
+bool is_constant(const AstExpr* expr);
+
+/// Fold the binary expression in `ref`, whose operands are both constants.
+/// It is replaced by the folded literal, or left alone if its 
+/// operator cannot be folded
+AnalyzeResult fold_binary(ExprRef ref, AnalysisContext& ctx);
+
+/// Fold the prefix expression in `ref`, whose operand is a constant
+AnalyzeResult fold_prefix(ExprRef ref, AnalysisContext& ctx);
+
+/// Give the literal `expr` the type `target` if its value can be 
+/// represented in it, like an integer literal used as an `i32`.
+/// Returns false, leaving `expr` unchanged, otherwise
+bool convert(AstExpr* expr, const Type* target);
+
+/// Give the literals of `expr` whose type becomes its type the type
+/// `target` before it is folded, where their values fit in it. So 
+/// `1 - 2` meant as an `i32` is folded as one, and `1 << s` shifts an
+/// `i32`. Nothing is converted if any other operand decides the type
+void expect_type(AstExpr* expr, const Type* target);
+
+} // namespace const_eval
+} // namespace core
+} // namespace compiler
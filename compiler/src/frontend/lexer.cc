@@ -2,8 +2,8 @@
 #include "core/tokens.h"
 #include "core/logger.h"
 #include "lexer.h"
+#include "scan.h"
 #include <algorithm>
-#include <cctype>
 #include <charconv>
 #include <cstdio>
 #include <cstdlib>
@@ -25,18 +25,16 @@ constexpr std::array<T, N> sort(std::array<T,N> arr) noexcept {
     return arr;
 }
 
-template <typename T, std::size_t N>
-std::optional<ReservedToken> find(std::array<T, N> arr, const std::string& value) {
-    for (usize i = 0; i < N; i++) {
-        if (arr[i].token_str == value) {
-            return arr[i].token;
-        }
-    }
 
-    return {};
+/// Stop with an error if a token is too long for its length to fit in a Token
+static void
+check_token_length(usize length) {
+    if (length > Token::MAX_LENGTH) {
+        core::logger::Fatal("Lexer. A token of {} bytes is longer than the limit of {} bytes", length, Token::MAX_LENGTH);
+        exit(1);
+    }
 }
 
-
 /// Our keyword token mappings
 constexpr std::array keywords {
     sort (
@@ -87,25 +85,101 @@ constexpr std::array keywords {
     )
 };
 
+/// Number of slots in the keyword hash table. Must be a power of two
+/// and comfortably larger than the number of keywords.
+constexpr usize KEYWORD_TABLE_SIZE = 128;
+
+/// Length of the longest keyword. Anything longer is an identifier.
+constexpr usize MAX_KEYWORD_LENGTH = std::max_element(
+    std::begin(keywords), std::end(keywords),
+    [](const StringifiedToken& a, const StringifiedToken& b) {
+        return a.token_str.length() < b.token_str.length();
+    }
+)->token_str.length();
+
+static_assert(keywords.size() < KEYWORD_TABLE_SIZE, "Keyword table is too small");
+static_assert((KEYWORD_TABLE_SIZE & (KEYWORD_TABLE_SIZE - 1)) == 0, "Keyword table size must be a power of two");
+
+/// Hash used to classify identifiers as keywords. It only looks at the 
+/// length and the first, second and last characters, so it costs the 
+/// same no matter how long the identifier is.
+constexpr u32 keyword_hash(std::string_view str, u32 seed) noexcept {
+    u32 hash = static_cast<u32>(str.length());
+    hash = hash * seed + static_cast<u8>(str.front());
+    hash = hash * seed + static_cast<u8>(str.length() > 1 ? str[1] : 0);
+    hash = hash * seed + static_cast<u8>(str.back());
+    hash ^= hash >> 15;
+    return hash & (KEYWORD_TABLE_SIZE - 1);
+}
+
+/// Perfect hash table of the keywords. Every keyword lands in its own slot
+/// and empty slots hold an empty string, so a lookup is one hash and 
+/// one string comparison.
+struct KeywordTable {
+    u32 seed;
+    std::array<StringifiedToken, KEYWORD_TABLE_SIZE> slots;
+};
+
+/// Search for a seed that gives us a collision free table. This runs 
+/// at compile time, so adding a keyword that breaks the hash is a 
+/// compile error rather than a silent slowdown.
+consteval KeywordTable build_keyword_table() {
+    for (u32 seed = 31; seed < 1 << 16; seed += 2) {
+        KeywordTable table = { seed, {} };
+        bool collision = false;
+
+        for (const StringifiedToken& keyword : keywords) {
+            StringifiedToken& slot = table.slots[keyword_hash(keyword.token_str, seed)];
+            if (slot.token != ReservedToken::Unknown) {
+                collision = true;
+                break;
+            }
+            slot = keyword;
+        }
+
+        if (!collision) {
+            return table;
+        }
+    }
+
+    throw "build_keyword_table: could not find a perfect hash for the keywords";
+}
+
+constexpr KeywordTable keyword_table = build_keyword_table();
+
+/// Look up a keyword from the identifier string
+std::optional<ReservedToken> find_keyword(std::string_view value) {
+    if (value.empty() || value.length() > MAX_KEYWORD_LENGTH) {
+        return {};
+    }
+
+    const StringifiedToken& slot = keyword_table.slots[keyword_hash(value, keyword_table.seed)];
+    if (slot.token_str == value) {
+        return slot.token;
+    }
+
+    return {};
+}
 
+
+/// Look at the character after the current one.
+/// m_position is already one past the current character
 char
 Lexer::peek_char() {
-    if (m_position+1 >= m_input.length()) {
+    if (m_position >= m_input.length()) {
         return '\0';
     } else {
-        return m_input[m_position+1];
+        return m_input[m_position];
     }
 }
 
 void
 Lexer::skip_whitespace() {
-    while (m_current_char == ' ' ||
-            m_current_char == '\t' ||
-            m_current_char == '\r' ||
-            m_current_char == '\n'
-    ) {
-        read_char();
+    if (!scan::is_whitespace(m_current_char)) {
+        return;
     }
+
+    jump_to(scan::skip_whitespace(m_input.data(), m_position - 1, m_input.length()));
 }
 
 void
@@ -119,22 +193,29 @@ Lexer::read_char() {
     m_position++;
 }
 
+/// Move the lexer so that the current character is the one at `index`
+void
+Lexer::jump_to(usize index) {
+    m_position = index;
+    read_char();
+}
+
 Token 
 Lexer::read_number() {
     usize pos = m_position - 1;
     bool floating_point = false;
     bool is_valid = true;
 
-    while (isdigit(m_current_char) != 0 || m_current_char == '.') {
-        if (m_current_char == '.') {
-            if (floating_point == true) {
-                is_valid = false;
-            }
-            floating_point = true;
+    usize end = scan::skip_digits(m_input.data(), pos, m_input.length());
+    while (end < m_input.length() && m_input[end] == '.') {
+        if (floating_point == true) {
+            is_valid = false;
         }
+        floating_point = true;
 
-        read_char();
+        end = scan::skip_digits(m_input.data(), end + 1, m_input.length());
     }
+    jump_to(end);
 
     if (!is_valid) {
         // Not a valid number
@@ -142,14 +223,14 @@ Lexer::read_number() {
     } else if (floating_point) {
         // Floating point number
         f64 value;
-        std::from_chars(m_input.data() + pos, m_input.data() + (m_position - pos), value);
+        std::from_chars(m_input.data() + pos, m_input.data() + end, value);
         return Token(
             value
         );
     } else {
         // Integer number
         u64 value;
-        std::from_chars(m_input.data() + pos, m_input.data() + (m_position - pos), value);
+        std::from_chars(m_input.data() + pos, m_input.data() + end, value);
         return Token(
             value
         );
@@ -159,27 +240,21 @@ Lexer::read_number() {
 Token
 Lexer::read_identifier() {
     usize pos = m_position -1;
-    while (
-        isalpha(m_current_char) != 0
-        || isdigit(m_current_char) != 0 
-        || m_current_char == '_'
-    ) {
-        read_char();
-    }
-    
-    char* buf = (char*)calloc(m_position-pos, sizeof(char));
-    std::strncpy(buf, m_input.data() + pos, m_position-pos-1);
-    std::string str = buf;
-    free(buf);
+    usize end = scan::skip_identifier(m_input.data(), pos, m_input.length());
+    jump_to(end);
+    check_token_length(end - pos);
 
-    auto value = find(keywords, str);
+    SourceSpan span = { static_cast<u32>(pos), static_cast<u32>(end - pos) };
+
+    std::string_view text = span.view(m_input);
+    auto value = find_keyword(text);
     if (value.has_value()) {
         return Token(
             value.value()
         );
     } else {
         return Token(
-            Identifier(str)
+            Identifier{ span, m_interner->intern(text) }
         );
     }
 }
@@ -339,7 +414,7 @@ Lexer::read_punctuator() {
                 // >=
                 read_char();
                 token = Token(ReservedToken::OpGreaterThanEqualTo);
-            } else if (peek_char() == '<') {
+            } else if (peek_char() == '>') {
                 read_char();
                 if (peek_char() == '=') {
                     // >>=
@@ -383,9 +458,9 @@ Token
 Lexer::read_alphanumeric() {
     Token token;
 
-    if (isalpha(m_current_char)) {
+    if (scan::is_alpha(m_current_char)) {
         token = read_identifier();
-    } if (isdigit(m_current_char) != 0) {
+    } else if (scan::is_digit(m_current_char)) {
         token = read_number();
     }
 
@@ -394,19 +469,16 @@ Lexer::read_alphanumeric() {
 
 Token
 Lexer::read_string_literal() {
-    usize pos = m_position - 1;
     read_char(); // eat first '"'
-    while (m_current_char != '"') {
+    usize pos = m_position - 1;
+    while (m_current_char != '"' && m_current_char != '\0') {
         read_char();
     }
+    check_token_length(m_position - pos - 1);
+    SourceSpan span = { static_cast<u32>(pos), static_cast<u32>(m_position - pos - 1) };
     read_char(); // eat second '"'
 
-    char* buf = (char*)calloc(m_position-pos, sizeof(char));
-    std::strncpy(buf, m_input.data() + pos, m_position-pos-1);
-    std::string str = buf;
-    free(buf);
-
-    return Token(str);
+    return Token(String{ span });
 }
 
 /// Get the next token found from the source code
@@ -414,7 +486,8 @@ Token Lexer::next_token() {
     Token token;
 
     skip_whitespace();
-    if (isalnum(m_current_char)) {
+    m_token_start = m_position - 1;
+    if (scan::is_alnum(m_current_char)) {
         token = read_alphanumeric();
     } else {
         if (m_current_char == '\0') {
@@ -426,7 +499,29 @@ Token Lexer::next_token() {
         }
     }
 
+    // Identifiers and strings already know their spans
+    if (!token.is<Identifier>() && !token.is<String>()) {
+        usize end = std::min<usize>(m_position - 1, m_input.length());
+        usize start = std::min<usize>(m_token_start, end);
+        check_token_length(end - start);
+        token.set_span(SourceSpan{ static_cast<u32>(start), static_cast<u32>(end - start) });
+    }
+
     return token;
 }
 
+/// Lex the whole input in one pass
+void Lexer::tokenize(TokenBuffer& buffer) {
+    buffer.reserve_for(m_input.length());
+
+    for (;;) {
+        Token token = next_token();
+        buffer.push(token);
+
+        if (token.is<Eof>()) {
+            break;
+        }
+    }
+}
+
 }
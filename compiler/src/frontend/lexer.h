@@ -1,6 +1,8 @@
 #pragma once
 #include "defines.h"
 #include "core/tokens.h"
+#include "core/interner.h"
+#include "token_buffer.h"
 #include <string_view>
 
 namespace compiler {
@@ -8,22 +10,30 @@ namespace compiler {
 class Lexer {
 public:
     Lexer() noexcept = default;
-    Lexer(std::string_view input) 
+    Lexer(std::string_view input, core::Interner& interner = core::Interner::global()) 
         : m_input(input), 
-        m_current_char(m_input[0]),
-        m_position(0)
+        m_interner(&interner),
+        m_current_char('\0'),
+        m_position(0),
+        m_token_start(0)
     {
         read_char();
     }
     
     Token next_token();
+
+    /// Lex the rest of the input into `buffer`, up to and including the Eof token
+    void tokenize(TokenBuffer& buffer);
 private:
     std::string_view m_input;
+    core::Interner* m_interner; // identifiers are interned here
     char m_current_char;
     u64 m_position;
+    u64 m_token_start; // offset of the token most recently returned
 
     void skip_whitespace();
     void read_char();
+    void jump_to(usize index);
     char peek_char();
     Token read_alphanumeric();
     Token read_punctuator();
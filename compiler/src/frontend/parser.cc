@@ -3,14 +3,101 @@
 #include "core/logger.h"
 #include "core/tokens.h"
 #include "core/type.h"
+#include <array>
+#include <optional>
 
 namespace compiler {
 
+/// Binary operators indexed by the token that introduces them.
+/// Tokens that are not binary operators have a precedence of LOWEST
+constexpr std::array<Parser::BinaryOperatorInfo, static_cast<usize>(ReservedToken::TOKEN_COUNT)> BINARY_OPERATORS = [] {
+    using core::Operator;
+    using core::operator_precedence;
+
+    std::array<Parser::BinaryOperatorInfo, static_cast<usize>(ReservedToken::TOKEN_COUNT)> table = {};
+    auto set = [&](ReservedToken token, Operator op, operator_precedence prec, bool right_assoc = false) {
+        table[static_cast<usize>(token)] = Parser::BinaryOperatorInfo{ op, prec, right_assoc };
+    };
+
+    set(ReservedToken::OpAssign, Operator::ASSIGN, operator_precedence::ASSIGNMENT, true);
+    set(ReservedToken::OpAssignAdd, Operator::ASSIGN_PLUS, operator_precedence::ASSIGNMENT, true);
+    set(ReservedToken::OpAssignSub, Operator::ASSIGN_MINUS, operator_precedence::ASSIGNMENT, true);
+    set(ReservedToken::OpAssignMul, Operator::ASSIGN_MUL, operator_precedence::ASSIGNMENT, true);
+    set(ReservedToken::OpAssignDiv, Operator::ASSIGN_DIV, operator_precedence::ASSIGNMENT, true);
+    set(ReservedToken::OpAssignMod, Operator::ASSIGN_MOD, operator_precedence::ASSIGNMENT, true);
+    set(ReservedToken::OpAssignBinaryAnd, Operator::ASSIGN_BINARY_AND, operator_precedence::ASSIGNMENT, true);
+    set(ReservedToken::OpAssignBinaryOr, Operator::ASSIGN_BINARY_OR, operator_precedence::ASSIGNMENT, true);
+    set(ReservedToken::OpAssignBinaryXor, Operator::ASSIGN_BINARY_XOR, operator_precedence::ASSIGNMENT, true);
+    set(ReservedToken::OpAssignBinaryLeftShift, Operator::ASSIGN_SHIFT_LEFT, operator_precedence::ASSIGNMENT, true);
+    set(ReservedToken::OpAssignBinaryRightShift, Operator::ASSIGN_SHIFT_RIGHT, operator_precedence::ASSIGNMENT, true);
+
+    set(ReservedToken::OpLogicalOr, Operator::LOGICAL_OR, operator_precedence::LOGICAL_OR);
+    set(ReservedToken::OpLogicalAnd, Operator::LOGICAL_AND, operator_precedence::LOGICAL_AND);
+    set(ReservedToken::OpBinaryOr, Operator::BINARY_OR, operator_precedence::BITWISE_OR);
+    set(ReservedToken::OpBinaryXor, Operator::BINARY_XOR, operator_precedence::BITWISE_XOR);
+    set(ReservedToken::OpBinaryAnd, Operator::BINARY_AND, operator_precedence::BITWISE_AND);
+
+    set(ReservedToken::OpEqualTo, Operator::EQUAL, operator_precedence::EQUALITY);
+    set(ReservedToken::OpNotEqual, Operator::NOT_EQUAL, operator_precedence::EQUALITY);
+    set(ReservedToken::OpLessThan, Operator::LESS_THAN, operator_precedence::COMPARISON);
+    set(ReservedToken::OpGreaterThan, Operator::GREATER_THAN, operator_precedence::COMPARISON);
+    set(ReservedToken::OpLessThanEqualTo, Operator::LESS_EQUAL, operator_precedence::COMPARISON);
+    set(ReservedToken::OpGreaterThanEqualTo, Operator::GREATER_EQUAL, operator_precedence::COMPARISON);
+
+    set(ReservedToken::OpBinaryLeftShift, Operator::SHIFT_LEFT, operator_precedence::SHIFT);
+    set(ReservedToken::OpBinaryRightShift, Operator::SHIFT_RIGHT, operator_precedence::SHIFT);
+
+    set(ReservedToken::OpAdd, Operator::PLUS, operator_precedence::ADDSUB);
+    set(ReservedToken::OpSub, Operator::MINUS, operator_precedence::ADDSUB);
+    set(ReservedToken::OpMul, Operator::MUL, operator_precedence::MULDIVMOD);
+    set(ReservedToken::OpDiv, Operator::DIV, operator_precedence::MULDIVMOD);
+    set(ReservedToken::OpMod, Operator::MOD, operator_precedence::MULDIVMOD);
+
+    return table;
+}();
+
+// Get the binary operator that a token stands for
+const Parser::BinaryOperatorInfo& Parser::binary_operator(ReservedToken token) {
+    return BINARY_OPERATORS[static_cast<usize>(token)];
+}
+
+// Get the prefix operator that a token stands for, if any
+std::optional<core::Operator> Parser::prefix_operator(ReservedToken token) {
+    switch (token) {
+        case ReservedToken::OpSub: return core::Operator::MINUS;
+        case ReservedToken::OpLogicalNot: return core::Operator::LOGICAL_NOT;
+        case ReservedToken::OpBinaryNot: return core::Operator::BINARY_NOT;
+        default: return {};
+    }
+}
+
 // Advance the token that the parser is currently looking at
 void Parser::advance() {
     m_current_token = m_peek_token;
-    m_peek_token = m_lexer->next_token();
-    core::logger::Debug("Current {}. Peek {}", m_current_token.to_str(), m_peek_token.to_str());
+    m_peek_token = next_token();
+    QLOG_TRACE("Current {}. Peek {}", m_current_token.to_str(m_source_code), m_peek_token.to_str(m_source_code));
+}
+
+u32 Parser::line_of(const Token& token) {
+    u32 offset = token.span().offset;
+    for (; m_line_offset < offset; m_line_offset++) {
+        if (m_source_code[m_line_offset] == '\n') {
+            m_line++;
+        }
+    }
+    return m_line;
+}
+
+// Get the next token from the lexer or the token buffer
+Token Parser::next_token() {
+    if (m_tokens == nullptr) {
+        return m_lexer->next_token();
+    }
+
+    // The buffer always ends with Eof, so keep handing that out once we reach it
+    usize index = std::min(m_cursor, m_tokens->size() - 1);
+    m_cursor = index + 1;
+    return m_tokens->token(index);
 }
 
 /* Return the next Ast Node from the source code */
@@ -29,6 +116,10 @@ core::AstNode* Parser::next_node() {
             expect(ReservedToken::OpSemicolon);
             break;
 
+        case ReservedToken::KwDefine:
+            node = define_stmt();
+            break;
+
         default:
             node = nullptr;
             break;
@@ -38,8 +129,8 @@ core::AstNode* Parser::next_node() {
 }
 
 /* Parse type annotations */
-core::Type* Parser::type() {
-    core::Type* type_ptr;
+const core::Type* Parser::type() {
+    const core::Type* type_ptr;
     Token type_token = m_current_token;
 
     if (type_token.is<ReservedToken>()) {
@@ -55,32 +146,33 @@ core::Type* Parser::type() {
             case ReservedToken::KwI32:
             case ReservedToken::KwI64: {
                 advance();
-                type_ptr = new core::TypeInteger(t);
+                type_ptr = m_types.primitive(t);
                 break;
             }
             
             case ReservedToken::KwF32:
             case ReservedToken::KwF64: {
                 advance();
-                type_ptr = new core::TypeFloat(t);
+                type_ptr = m_types.primitive(t);
                 break;
             }
 
             case ReservedToken::OpMul: {
                 expect(ReservedToken::OpMul);
-                core::Type* target = this->type();
-                type_ptr = new core::TypePointer(target);
+                const core::Type* target = this->type();
+                type_ptr = m_types.pointer(target);
                 break;
             }
             
             default: {
                 core::logger::Fatal("Illegal token when parsing type: {}.", reserved_to_str(type_token.get<ReservedToken>()));
-                return nullptr;
+                exit(1);
             }
         }
 
     } else if (type_token.is<Identifier>()) {
-        type_ptr = new core::TypeIdentifier();
+        advance();
+        type_ptr = m_types.identifier(type_token.get<Identifier>().symbol);
     } else {
         type_ptr =  nullptr;
     }
@@ -93,50 +185,127 @@ core::Type* Parser::type() {
         Integer length = m_current_token.get<Integer>();
         advance();
         expect(ReservedToken::OpSubscriptClose);
-        return new core::TypeArray(type_ptr, length);
+        return m_types.array(type_ptr, length);
     }
 
     return type_ptr;
 }
 
 // let i: i32 = 100;
+// let i = 100;
 core::AstNode* Parser::let_stmt() {
     expect(ReservedToken::KwLet);
 
-    core::AstNode* target = identifier();
+    core::AstNode* target = m_arena.make<core::AstIdentifierExpr>(expect_identifier());
 
-    expect(ReservedToken::OpColon);
-
-    core::Type* type = this->type();
+    // The annotation is optional. Without one the 
+    // variable takes the type of its value
+    std::optional<const core::Type*> type;
+    if (m_current_token.kind() == ReservedToken::OpColon) {
+        advance(); // eat the ':'
+        type = this->type();
+    }
 
     expect(ReservedToken::OpAssign);
 
     core::AstNode* value = expr();
 
-    return new core::AstVarDecl(target, type, value);
+    return m_arena.make<core::AstVarDecl>(target, type, value);
+}
+
+core::Symbol Parser::expect_identifier() {
+    if (!m_current_token.is<Identifier>()) {
+        core::logger::Fatal("Parser::expect_identifier. Illegal token: {}. Expected a name", m_current_token.to_str(m_source_code));
+        exit(1);
+    }
+
+    core::Symbol name = m_current_token.get<Identifier>().symbol;
+    advance(); // eat the name
+    return name;
+}
+
+// define add(a: i32, b: i32): i32 {
+//     let sum = a + b;
+//     return sum;
+// }
+core::AstNode* Parser::define_stmt() {
+    u32 line = line_of(m_current_token);
+    expect(ReservedToken::KwDefine);
+    core::Symbol name = expect_identifier();
+
+    std::vector<core::AstParamDecl*> params;
+    expect(ReservedToken::OpParenOpen);
+    while (m_current_token.kind() != ReservedToken::OpParenClose && !m_current_token.is<Eof>()) {
+        if (!params.empty()) {
+            expect(ReservedToken::OpComma);
+        }
+
+        core::Symbol param = expect_identifier();
+        expect(ReservedToken::OpColon);
+        params.push_back(m_arena.make<core::AstParamDecl>(param, this->type()));
+    }
+    expect(ReservedToken::OpParenClose);
+
+    expect(ReservedToken::OpColon);
+    const core::Type* return_type = this->type();
+
+    std::vector<core::AstNode*> body;
+    std::vector<u32> lines;
+    expect(ReservedToken::OpCurlyBracketOpen);
+    while (m_current_token.kind() != ReservedToken::OpCurlyBracketClose && !m_current_token.is<Eof>()) {
+        lines.push_back(line_of(m_current_token));
+        switch (m_current_token.kind()) {
+            case ReservedToken::KwLet:
+                body.push_back(let_stmt());
+                break;
+            case ReservedToken::KwReturn:
+                body.push_back(return_stmt());
+                break;
+            default:
+                core::logger::Fatal("Parser::define_stmt. Expected a statement. Got {}", m_current_token.to_str(m_source_code));
+                exit(1);
+        }
+        expect(ReservedToken::OpSemicolon);
+    }
+    expect(ReservedToken::OpCurlyBracketClose);
+
+    core::AstFunctionDecl* function = m_arena.make<core::AstFunctionDecl>(
+        name, m_arena.copy_array(params), return_type, m_arena.copy_array(body)
+    );
+    function->line = line;
+    function->lines = m_arena.copy_array(lines);
+    return function;
+}
+
+// return x + 1;
+core::AstNode* Parser::return_stmt() {
+    expect(ReservedToken::KwReturn);
+    return m_arena.make<core::AstReturnStmt>(expr());
 }
 
 // Parse an identifier expression
 core::AstNode* Parser::identifier() {
-    Identifier ident = m_current_token.get<Identifier>();
+    core::Symbol name = m_current_token.get<Identifier>().symbol;
     advance(); // eat the identifier
-    return new core::AstIdentifierExpr(ident);
+    return m_arena.make<core::AstIdentifierExpr>(name);
 }
 
+// Parse a full expression
 core::AstNode* Parser::expr() {
-    return primary_expr();
+    core::AstNode* lhs = prefix_expr();
+    return binary_expr(static_cast<core::AstExpr*>(lhs), core::operator_precedence::LOWEST);
 }
 
 // Parse a 'true' boolean literal
 core::AstNode* Parser::true_expr() {
     advance();
-    return new core::AstBoolExpr(true);
+    return m_arena.make<core::AstBoolExpr>(true, m_types.boolean());
 }
 
 // Parse a 'false' boolean literal
 core::AstNode* Parser::false_expr() {
     advance();
-    return new core::AstBoolExpr(false);
+    return m_arena.make<core::AstBoolExpr>(false, m_types.boolean());
 }
 
 // Parse an integer literal
@@ -144,7 +313,7 @@ core::AstNode* Parser::integer_expr() {
     Integer value = m_current_token.get<Integer>();
     advance(); // eat the number
 
-    return new core::AstIntegerExpr(value);
+    return m_arena.make<core::AstIntegerExpr>(value, m_types.integer(false, 8));
 }
 
 // Parse a floating point number literal
@@ -152,30 +321,51 @@ core::AstNode* Parser::float_expr() {
     Float value = m_current_token.get<Float>();
     advance(); // eat the number
 
-    return new core::AstFloatExpr(value);
+    return m_arena.make<core::AstFloatExpr>(value, m_types.floating(8));
 }
 
+// Parse a chain of prefix operators followed by a primary expression.
+// `- ~ !x` is parsed with a loop rather than by recursing per operator
 core::AstNode* Parser::prefix_expr() {
-    return nullptr;
+    usize base = m_prefix_stack.size();
+    for (;;) {
+        std::optional<core::Operator> op = prefix_operator(m_current_token.kind());
+        if (!op.has_value()) {
+            break;
+        }
+
+        m_prefix_stack.push_back(op.value());
+        advance(); // eat the operator
+    }
+
+    core::AstNode* node = primary_expr();
+
+    // The operator closest to the operand applies first
+    while (m_prefix_stack.size() > base) {
+        node = m_arena.make<core::AstPrefixExpr>(m_prefix_stack.back(), node);
+        m_prefix_stack.pop_back();
+    }
+
+    return node;
 }
 
 // Parse a primary expression
 core::AstNode* Parser::primary_expr() {
     if (m_current_token.is<ReservedToken>()) {
-        // Operators
         switch (m_current_token.get<ReservedToken>()) {
-            case ReservedToken::OpLogicalNot:
-            case ReservedToken::OpSub:
-            case ReservedToken::OpBinaryNot:
-                return prefix_expr();
-
             case ReservedToken::KwTrue:
                 return true_expr();
             case ReservedToken::KwFalse:
                 return false_expr();
 
+            case ReservedToken::OpParenOpen: {
+                expect(ReservedToken::OpParenOpen);
+                core::AstNode* inner = expr();
+                expect(ReservedToken::OpParenClose);
+                return inner;
+            }
+
             default:
-                return nullptr;
                 break;
         }
     } else if (m_current_token.is<Integer>()) {
@@ -183,21 +373,78 @@ core::AstNode* Parser::primary_expr() {
     } else if (m_current_token.is<Float>()) {
         return float_expr();
     } else if (m_current_token.is<Identifier>()) {
-        // TODO: parse identifier
+        if (m_peek_token.kind() == ReservedToken::OpParenOpen) {
+            return call_expr();
+        }
+        return identifier();
+    }
+
+    core::logger::Fatal("Parser::primary_expr. Expected an expression. Got {}", m_current_token.to_str(m_source_code));
+    exit(1);
+}
+
+// add(1, x)
+core::AstNode* Parser::call_expr() {
+    core::Symbol callee = m_current_token.get<Identifier>().symbol;
+    advance(); // eat the name
+
+    std::vector<core::AstExpr*> args;
+    expect(ReservedToken::OpParenOpen);
+    while (m_current_token.kind() != ReservedToken::OpParenClose && !m_current_token.is<Eof>()) {
+        if (!args.empty()) {
+            expect(ReservedToken::OpComma);
+        }
+        args.push_back(static_cast<core::AstExpr*>(expr()));
     }
+    expect(ReservedToken::OpParenClose);
 
-    return nullptr;
+    return m_arena.make<core::AstCallExpr>(callee, m_arena.copy_array(args));
 }
 
-// Parse a binary expression
+// Parse the binary operators following `lhs` with precedence climbing.
+// Instead of recursing for every operator, operands waiting for their
+// right hand side are kept on m_operator_stack and are reduced as soon
+// as an operator that binds less tightly shows up. This keeps parsing 
+// linear, and the stack depth does not depend on the length of the expression.
 core::AstNode* Parser::binary_expr(core::AstExpr* lhs, core::operator_precedence min_prec) {
-    Token op = m_current_token;
+    usize base = m_operator_stack.size();
+    core::AstNode* operand = lhs;
+
+    // Combine the top of the stack with the operand that follows it
+    auto reduce = [&]() {
+        PendingOperator pending = m_operator_stack.back();
+        m_operator_stack.pop_back();
+        operand = m_arena.make<core::AstBinaryExpr>(pending.lhs, pending.info.op, operand);
+    };
+
+    for (;;) {
+        const BinaryOperatorInfo& info = binary_operator(m_current_token.kind());
+        if (info.prec == core::operator_precedence::LOWEST || info.prec < min_prec) {
+            break;
+        }
 
-    advance();
+        // Everything on the stack that binds at least as tightly as this
+        // operator is complete. Right associative operators leave 
+        // operators of the same precedence for later.
+        while (m_operator_stack.size() > base) {
+            const BinaryOperatorInfo& top = m_operator_stack.back().info;
+            if (top.prec < info.prec || (top.prec == info.prec && info.right_assoc)) {
+                break;
+            }
+            reduce();
+        }
+
+        m_operator_stack.push_back(PendingOperator{ operand, info });
+        advance(); // eat the operator
 
+        operand = prefix_expr();
+    }
 
+    while (m_operator_stack.size() > base) {
+        reduce();
+    }
 
-    return nullptr;
+    return operand;
 }
 
 }
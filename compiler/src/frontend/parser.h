@@ -6,68 +6,130 @@
 #include "lexer.h"
 
 #include <cstdlib>
+#include <optional>
 #include <variant>
 #include <vector>
 namespace compiler {
 
 class Parser {
 public:
-    Parser(const std::string& source_code)
+    /// Parse tokens as they are lexed from the source code. 
+    /// Nodes are allocated in the arena of `program` and types come
+    /// from its type context
+    Parser(std::string_view source_code, core::Program& program)
         : m_source_code(source_code),
+          m_arena(program.arena()),
+          m_types(program.types()),
           m_lexer(new Lexer(m_source_code)),
+          m_tokens(nullptr),
+          m_cursor(0),
           m_peek_token(m_lexer->next_token()),
           m_current_token(Token())
         {
             this->advance();
         }
 
+    /// Parse a token stream that was already lexed from the source code
+    Parser(std::string_view source_code, const TokenBuffer& tokens, core::Program& program)
+        : m_source_code(source_code),
+          m_arena(program.arena()),
+          m_types(program.types()),
+          m_lexer(nullptr),
+          m_tokens(&tokens),
+          m_cursor(0),
+          m_peek_token(next_token()),
+          m_current_token(Token())
+        {
+            this->advance();
+        }
+
     ~Parser() {
         delete m_lexer;
     }
    
     /// Return the next node from the input source code
     core::AstNode* next_node();
+
+    /// How a token behaves as a binary operator
+    struct BinaryOperatorInfo {
+        core::Operator op;
+        core::operator_precedence prec; // LOWEST if the token is not a binary operator
+        bool right_assoc;
+    };
 private:
+    /// Left hand side of a binary operator whose right hand side is still being parsed
+    struct PendingOperator {
+        core::AstNode* lhs;
+        BinaryOperatorInfo info;
+    };
+
+    static const BinaryOperatorInfo& binary_operator(ReservedToken token);
+    static std::optional<core::Operator> prefix_operator(ReservedToken token);
+
     Integer INTEGER_TOKEN = 1;
     Float FLOAT_TOKEN = 1.0F;
-    String STRING_TOKEN = "STRING";
 
     void advance();
+    Token next_token();
+
+    /// Line of the source that `token` starts on, counting from 1.
+    /// Tokens have to be asked about in source order
+    u32 line_of(const Token& token);
 
     template <typename T>
     void expect(T expected) {
         if (m_current_token.is<ReservedToken>()) {
             if (m_current_token.get<T>() != expected) {
-                core::logger::Fatal("Parser::expect. Illegal token: {}. Expected {}", m_current_token.to_str(), reserved_to_str(expected));
+                core::logger::Fatal("Parser::expect. Illegal token: {}. Expected {}", m_current_token.to_str(m_source_code), reserved_to_str(expected));
                 exit(1);
             }
         } else {
             if (!m_current_token.is<T>()) {
-                core::logger::Fatal("Parser::expect. Illegal token: {}. Expected {}", m_current_token.to_str(), reserved_to_str(expected));
+                core::logger::Fatal("Parser::expect. Illegal token: {}. Expected {}", m_current_token.to_str(m_source_code), reserved_to_str(expected));
+                exit(1);
             }
         }
 
         this->advance();
     }
 
+    /// Eat a name, like `expect` eats a reserved token
+    core::Symbol expect_identifier();
+
 
     core::AstNode* let_stmt();
+    core::AstNode* define_stmt();
+    core::AstNode* return_stmt();
     core::AstNode* identifier();
-    core::Type* type();
+    const core::Type* type();
 
     core::AstNode* expr();
     core::AstNode* primary_expr();
     core::AstNode* prefix_expr();
     core::AstNode* binary_expr(core::AstExpr* lhs, core::operator_precedence prec);
+    core::AstNode* call_expr();
     core::AstNode* true_expr();
     core::AstNode* false_expr();
     core::AstNode* integer_expr();
     core::AstNode* float_expr();
 
-    const std::string& m_source_code;
-    Lexer* m_lexer; // owned
+    std::string_view m_source_code; // must outlive the parser and its tokens
+    core::Arena& m_arena;       // nodes are allocated here
+    core::TypeContext& m_types; // canonical types
+    Lexer* m_lexer; // owned. Null when parsing from a token buffer
+    const TokenBuffer* m_tokens; // not owned
+    usize m_cursor; // index of the next token in m_tokens
     Token m_peek_token;
     Token m_current_token;
+
+    // Newlines before m_line_offset have been counted into m_line
+    u32 m_line_offset = 0;
+    u32 m_line = 1;
+
+    // Scratch stacks for expression parsing. They are shared by nested
+    // expressions, which only use the part above where they started
+    std::vector<PendingOperator> m_operator_stack;
+    std::vector<core::Operator> m_prefix_stack;
 };
 
 }
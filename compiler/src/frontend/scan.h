@@ -0,0 +1,170 @@
+#pragma once
+#include "defines.h"
+#include <array>
+#include <bit>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define Q_SCAN_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define Q_SCAN_SSE2 1
+#endif
+
+namespace compiler {
+
+/// Helpers for the lexer to skip over runs of characters of the same class.
+/// On x86 these classify 16 (SSE2) or 32 (AVX2, when built with -mavx2)
+/// bytes at a time, and fall back to a lookup table everywhere else
+/// and for the tail of the input.
+namespace scan {
+
+enum CharClass : u8 {
+    WHITESPACE = 1 << 0,
+    ALPHA      = 1 << 1,
+    DIGIT      = 1 << 2,
+    UNDERSCORE = 1 << 3,
+};
+
+/// Character class of every byte. Only ASCII is classified,
+/// which matches what `isalpha` and friends do in the "C" locale
+constexpr std::array<u8, 256> CHAR_CLASSES = [] {
+    std::array<u8, 256> classes = {};
+    classes[' '] = classes['\t'] = classes['\r'] = classes['\n'] = WHITESPACE;
+    for (usize c = 'a'; c <= 'z'; c++) {
+        classes[c] = ALPHA;
+    }
+    for (usize c = 'A'; c <= 'Z'; c++) {
+        classes[c] = ALPHA;
+    }
+    for (usize c = '0'; c <= '9'; c++) {
+        classes[c] = DIGIT;
+    }
+    classes['_'] = UNDERSCORE;
+    return classes;
+}();
+
+constexpr bool is_class(char c, u8 mask) {
+    return (CHAR_CLASSES[static_cast<u8>(c)] & mask) != 0;
+}
+
+constexpr bool is_whitespace(char c) { return is_class(c, WHITESPACE); }
+constexpr bool is_alpha(char c) { return is_class(c, ALPHA); }
+constexpr bool is_digit(char c) { return is_class(c, DIGIT); }
+constexpr bool is_alnum(char c) { return is_class(c, ALPHA | DIGIT); }
+constexpr bool is_identifier(char c) { return is_class(c, ALPHA | DIGIT | UNDERSCORE); }
+
+#if defined(Q_SCAN_AVX2)
+using Vector = __m256i;
+constexpr usize VECTOR_WIDTH = 32;
+
+inline Vector load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+inline Vector splat(char c) { return _mm256_set1_epi8(c); }
+inline Vector eq(Vector a, Vector b) { return _mm256_cmpeq_epi8(a, b); }
+inline Vector gt(Vector a, Vector b) { return _mm256_cmpgt_epi8(a, b); }
+inline Vector lor(Vector a, Vector b) { return _mm256_or_si256(a, b); }
+inline Vector land(Vector a, Vector b) { return _mm256_and_si256(a, b); }
+inline u32 movemask(Vector v) { return static_cast<u32>(_mm256_movemask_epi8(v)); }
+#elif defined(Q_SCAN_SSE2)
+using Vector = __m128i;
+constexpr usize VECTOR_WIDTH = 16;
+
+inline Vector load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+inline Vector splat(char c) { return _mm_set1_epi8(c); }
+inline Vector eq(Vector a, Vector b) { return _mm_cmpeq_epi8(a, b); }
+inline Vector gt(Vector a, Vector b) { return _mm_cmpgt_epi8(a, b); }
+inline Vector lor(Vector a, Vector b) { return _mm_or_si128(a, b); }
+inline Vector land(Vector a, Vector b) { return _mm_and_si128(a, b); }
+inline u32 movemask(Vector v) { return static_cast<u32>(_mm_movemask_epi8(v)); }
+#endif
+
+#if defined(Q_SCAN_AVX2) || defined(Q_SCAN_SSE2)
+/// Mask of the lanes that are between `lo` and `hi` inclusive.
+/// The compares are signed, so bytes >= 0x80 never match,
+/// which is what we want for ASCII ranges.
+inline Vector in_range(Vector v, char lo, char hi) {
+    return land(gt(v, splat(lo - 1)), gt(splat(hi + 1), v));
+}
+
+struct WhitespaceRun {
+    static bool scalar(char c) { return is_whitespace(c); }
+    static Vector vector(Vector v) {
+        return lor(
+            lor(eq(v, splat(' ')), eq(v, splat('\t'))),
+            lor(eq(v, splat('\r')), eq(v, splat('\n')))
+        );
+    }
+};
+
+struct IdentifierRun {
+    static bool scalar(char c) { return is_identifier(c); }
+    static Vector vector(Vector v) {
+        // Setting bit 5 folds upper case letters into lower case ones
+        Vector lower = lor(v, splat(0x20));
+        return lor(
+            lor(in_range(lower, 'a', 'z'), in_range(v, '0', '9')),
+            eq(v, splat('_'))
+        );
+    }
+};
+
+struct DigitRun {
+    static bool scalar(char c) { return is_digit(c); }
+    static Vector vector(Vector v) { return in_range(v, '0', '9'); }
+};
+
+/// Return the index of the first byte at or after `pos` that is not in the run
+template <typename Run>
+inline usize skip_run(const char* data, usize pos, usize end) {
+    constexpr u32 FULL = VECTOR_WIDTH == 32 ? 0xFFFFFFFFu : 0xFFFFu;
+
+    while (pos + VECTOR_WIDTH <= end) {
+        u32 mask = movemask(Run::vector(load(data + pos))) ^ FULL;
+        if (mask != 0) {
+            return pos + std::countr_zero(mask);
+        }
+        pos += VECTOR_WIDTH;
+    }
+
+    while (pos < end && Run::scalar(data[pos])) {
+        pos++;
+    }
+    return pos;
+}
+#else
+struct WhitespaceRun {
+    static bool scalar(char c) { return is_whitespace(c); }
+};
+
+struct IdentifierRun {
+    static bool scalar(char c) { return is_identifier(c); }
+};
+
+struct DigitRun {
+    static bool scalar(char c) { return is_digit(c); }
+};
+
+/// Return the index of the first byte at or after `pos` that is not in the run
+template <typename Run>
+inline usize skip_run(const char* data, usize pos, usize end) {
+    while (pos < end && Run::scalar(data[pos])) {
+        pos++;
+    }
+    return pos;
+}
+#endif
+
+inline usize skip_whitespace(const char* data, usize pos, usize end) {
+    return skip_run<WhitespaceRun>(data, pos, end);
+}
+
+inline usize skip_identifier(const char* data, usize pos, usize end) {
+    return skip_run<IdentifierRun>(data, pos, end);
+}
+
+inline usize skip_digits(const char* data, usize pos, usize end) {
+    return skip_run<DigitRun>(data, pos, end);
+}
+
+} // namespace scan
+} // namespace compiler
@@ -4,116 +4,567 @@
 #include "core/utils.h"
 #include "core/result.h"
 #include "core/error.h"
+#include "core/symbol_table.h"
+#include "frontend/const_eval.h"
+#include "core/thread_pool.h"
+#include <memory>
+#include <optional>
 
 namespace compiler {
 namespace core {
 
-AnalyzeResult AstExpr::analyze() {
-    return Err(Error(Error::Type::Semantic, "AstExpr should never be instantiated"));
+AnalyzeResult AstExpr::analyze(AnalysisContext& ctx) {
+    AstExpr* root = this;
+    AnalyzeResult result = analyze_tree(ExprRef(&root), ctx);
+
+    // Rewrites of the root have to stay in place, 
+    // since nothing would see it move
+    if (result.is_ok() && root != this) {
+        return Err(Error(ErrorCode::RootMoved));
+    }
+    return result;
 }
 
-/// Semantic analysis of Boolean expression
-/// Nothing to analyze so return itself
-AnalyzeResult AstBoolExpr::analyze() {
-    return Ok(this);
+AnalyzeResult AstExpr::analyze_tree(ExprRef root, AnalysisContext& ctx) {
+    if (root->state == TypeState::Resolved) {
+        return Ok(Unit());
+    }
+
+    // Each frame is the slot that points at an expression, so a check 
+    // that replaces its node does so in the parent
+    struct Frame {
+        ExprRef slot;
+        bool expanded;
+    };
+
+    std::vector<Frame> stack;
+    stack.push_back(Frame{ root, false });
+
+    while (!stack.empty()) {
+        Frame frame = stack.back();
+        AstExpr* expr = frame.slot.get();
+
+        if (!frame.expanded) {
+            if (expr->state == TypeState::Resolved) {
+                stack.pop_back();
+                continue;
+            }
+            if (expr->state == TypeState::InProgress) {
+                return Err(Error(ErrorCode::CyclicType));
+            }
+
+            expr->state = TypeState::InProgress;
+            stack.back().expanded = true;
+
+            // Operands are pushed in reverse so the lhs is checked first
+            if (AstBinaryExpr* binary = utils::dyn_cast<AstBinaryExpr>(expr)) {
+                stack.push_back(Frame{ ExprRef(&binary->rhs), false });
+                stack.push_back(Frame{ ExprRef(&binary->lhs), false });
+            } else if (AstPrefixExpr* prefix = utils::dyn_cast<AstPrefixExpr>(expr)) {
+                stack.push_back(Frame{ ExprRef(&prefix->rhs), false });
+            } else if (AstCallExpr* call = utils::dyn_cast<AstCallExpr>(expr)) {
+                for (usize i = call->args.size(); i > 0; i--) {
+                    stack.push_back(Frame{ ExprRef(&call->args[i - 1]), false });
+                }
+            }
+            continue;
+        }
+        stack.pop_back();
+
+        AnalyzeResult result = expr->check(frame.slot, ctx);
+        // The slot may hold a different node now
+        frame.slot->state = TypeState::Resolved;
+        if (result.is_err()) {
+            return result;
+        }
+    }
+
+    return Ok(Unit());
 }
 
-/// Semantic analysis of Integer expression
-/// Nothing to analyze so return itself
-AnalyzeResult AstIntegerExpr::analyze() {
+/// Literals are typed when they are made
+AnalyzeResult AstBoolExpr::check(ExprRef self, AnalysisContext& ctx) {
+    return Ok(Unit());
+}
+
+AnalyzeResult AstIntegerExpr::check(ExprRef self, AnalysisContext& ctx) {
+    return Ok(Unit());
+}
+
+AnalyzeResult AstFloatExpr::check(ExprRef self, AnalysisContext& ctx) {
+    return Ok(Unit());
+}
+
+/// Resolve the identifier to its declaration and take its type
+AnalyzeResult AstIdentifierExpr::check(ExprRef self, AnalysisContext& ctx) {
+    const SymbolInfo* info = ctx.symbols.lookup(name);
+    if (info == nullptr) {
+        return Err(Error(ErrorCode::UndeclaredIdentifier, { DiagnosticArg::symbol(name) }));
+    }
+
+    if (info->decl == ctx.declaring) {
+        return Err(Error(ErrorCode::SelfReference, { DiagnosticArg::symbol(name) }));
+    }
+
+    if (utils::isa<AstFunctionDecl>(info->decl)) {
+        return Err(Error(ErrorCode::NotAValue, { DiagnosticArg::symbol(name) }));
+    }
+
+    // Declarations without an annotation are typed in source order
+    if (info->type == nullptr) {
+        return Err(Error(ErrorCode::UnknownType, { DiagnosticArg::symbol(name) }));
+    }
+
+    type = info->type;
+    decl = info->decl;
+    return Ok(Unit());
+}
+
+/// Resolve the function being called and check the arguments against
+/// its parameters. Constant arguments take the type of their parameter
+AnalyzeResult AstCallExpr::check(ExprRef self, AnalysisContext& ctx) {
+    const SymbolInfo* info = ctx.symbols.lookup(callee);
+    if (info == nullptr) {
+        return Err(Error(ErrorCode::UndeclaredIdentifier, { DiagnosticArg::symbol(callee) }));
+    }
+
+    AstFunctionDecl* function = utils::dyn_cast<AstFunctionDecl>(info->decl);
+    if (function == nullptr) {
+        return Err(Error(ErrorCode::NotAFunction, { DiagnosticArg::symbol(callee) }));
+    }
+
+    if (args.size() != function->params.size()) {
+        return Err(Error(ErrorCode::ArgumentCount, { 
+            DiagnosticArg::symbol(callee), 
+            DiagnosticArg::integer(static_cast<i64>(function->params.size())), 
+            DiagnosticArg::integer(static_cast<i64>(args.size())) 
+        }));
+    }
+
+    for (usize i = 0; i < args.size(); i++) {
+        const Type* param_type = function->params[i]->type;
+        if (const_eval::is_constant(args[i])) {
+            const_eval::convert(args[i], param_type);
+        }
+        if (args[i]->get_type() != param_type) {
+            return Err(Error(ErrorCode::ArgumentMismatch, { 
+                DiagnosticArg::integer(static_cast<i64>(i + 1)), DiagnosticArg::symbol(callee) 
+            }));
+        }
+    }
+
+    target = function;
+    type = function->return_type;
+    return Ok(Unit());
+}
+
+/// Declare the name of a variable in the innermost scope
+Result<AstVarDecl*, Error> AstVarDecl::declare(AnalysisContext& ctx) {
+    const AstIdentifierExpr* name = utils::cast<AstIdentifierExpr>(target);
+    SymbolInfo info = { type.value_or(nullptr), this };
+    if (!ctx.symbols.declare(name->name, info)) {
+        return Err(Error(ErrorCode::Redeclaration, { DiagnosticArg::symbol(name->name) }));
+    }
     return Ok(this);
 }
 
-/// Semantic analysis of Float expression
-/// Nothing to analyze so return itself
-AnalyzeResult AstFloatExpr::analyze() {
+/// Declare the name of a function in the innermost scope
+Result<AstFunctionDecl*, Error> AstFunctionDecl::declare(AnalysisContext& ctx) {
+    if (!ctx.symbols.declare(name, SymbolInfo{ nullptr, this })) {
+        return Err(Error(ErrorCode::Redeclaration, { DiagnosticArg::symbol(name) }));
+    }
     return Ok(this);
 }
 
-AnalyzeResult AstIdentifierExpr::analyze() {
-    return Err(Error(Error::Type::Semantic, "NOT DONE"));
+/// Analyze the body of a function in a scope of its own, 
+/// which starts out with the parameters
+AnalyzeResult AstFunctionDecl::analyze(AnalysisContext& ctx) {
+    AstFunctionDecl* outer = ctx.function;
+    ctx.function = this;
+    ctx.symbols.push_scope();
+
+    AnalyzeResult result = Ok(Unit());
+    for (AstParamDecl* param : params) {
+        if (!ctx.symbols.declare(param->name, SymbolInfo{ param->type, param })) {
+            result = Err(Error(ErrorCode::Redeclaration, { DiagnosticArg::symbol(param->name) }));
+            break;
+        }
+    }
+
+    for (usize i = 0; i < body.size() && result.is_ok(); i++) {
+        result = body[i]->analyze(ctx);
+    }
+
+    ctx.symbols.pop_scope();
+    ctx.function = outer;
+
+    // Bodies have no branches yet, so the last statement is the only
+    // one that can make sure every call returns
+    if (result.is_ok() && (body.empty() || !utils::isa<AstReturnStmt>(body.back()))) {
+        return Err(Error(ErrorCode::MissingReturn, { DiagnosticArg::symbol(name) }));
+    }
+    return result;
+}
+
+/// The value of a return takes the return type of its function
+AnalyzeResult AstReturnStmt::analyze(AnalysisContext& ctx) {
+    const_eval::expect_type(value, ctx.function->return_type);
+    AnalyzeResult value_res = AstExpr::analyze_tree(ExprRef(&value), ctx);
+    if (value_res.is_err()) {
+        return value_res;
+    }
+
+    const Type* expected = ctx.function->return_type;
+    if (const_eval::is_constant(value)) {
+        const_eval::convert(value, expected);
+    }
+    if (value->get_type() != expected) {
+        return Err(Error(ErrorCode::ReturnMismatch, { DiagnosticArg::symbol(ctx.function->name) }));
+    }
+    return Ok(Unit());
 }
 
 /// Semantic analysis of Variable Declaration node
-AnalyzeResult AstVarDecl::analyze() {
-    AnalyzeResult value_res = this->value->analyze();
+AnalyzeResult AstVarDecl::analyze(AnalysisContext& ctx) {
+    const AstIdentifierExpr* name = utils::cast<AstIdentifierExpr>(target);
+
+    // Globals with an annotation are declared before any value is 
+    // analyzed. Anything else is declared once its value is known
+    SymbolInfo* declared = ctx.symbols.lookup(name->name);
+    bool predeclared = declared != nullptr && declared->decl == this;
+
+    // A constant value is folded in the annotated type, and only
+    // rejected if what it folds to does not fit in it
+    if (type.has_value()) {
+        const_eval::expect_type(value, type.value());
+    }
+
+    AstNode* outer = ctx.declaring;
+    ctx.declaring = this;
+    AnalyzeResult value_res = AstExpr::analyze_tree(ExprRef(&value), ctx);
+    ctx.declaring = outer;
 
     if (value_res.is_ok()) {
-        AstExpr* new_value = dynamic_cast<AstExpr*>(value_res.unwrap());
-        if (!new_value) {
-            // The value returned was not an expression. This is not allowed.
-            return Err(Error(Error::Type::Semantic, "Cannot set value of variable to a non-expression!"));
+        // The value may have been rewritten, so it is read again
+        AstExpr* new_value = value;
+
+        // A constant value takes the annotated type if it fits in it
+        if (type.has_value() && const_eval::is_constant(value)) {
+            const_eval::convert(value, type.value());
+        }
+
+        // The name is declared even if the value has the wrong type,
+        // so later uses of it do not report more errors
+        if (!predeclared) {
+            Result<AstVarDecl*, Error> declare_res = declare(ctx);
+            if (declare_res.is_err()) {
+                return Err(declare_res.unwrap_err());
+            }
+            if (!type.has_value()) {
+                ctx.symbols.lookup_local(name->name)->type = new_value->get_type();
+            }
         }
 
         // We do not provide implicit type conversion,
         // so the type of the value must match the one 
         // specified through the annotation
-
-        if (type != new_value->get_type()) {
-            return Err(Error(Error::Type::Semantic, "AstVarDecl::analyze. Assigned expression type is not the same as specified"));
+        if (type.has_value() && type.value() != new_value->get_type()) {
+            return Err(Error(ErrorCode::TypeMismatch));
         }
 
-        return Ok(this);
+        return Ok(Unit());
     } else {
-        return Err(value_res.unwrap_err());
+        return value_res;
     }
 }
 
-/// Analyze prefix expressions
-/// TODO: this is not done lol
-AnalyzeResult AstPrefixExpr::analyze() {
-    AnalyzeResult rhs_res = rhs->analyze();
+/// Check prefix expressions. Constant operands are folded
+AnalyzeResult AstPrefixExpr::check(ExprRef self, AnalysisContext& ctx) {
+    const Type* rhs_type = rhs->get_type();
+    switch (op) {
+        case Operator::MINUS:
+            // This operator only allows for numerical types 
+            // to be negated
+            if (!utils::dyn_cast<TypeInteger>(rhs_type) && !utils::dyn_cast<TypeFloat>(rhs_type)) {
+                return Err(Error(ErrorCode::NegateNonNumber));
+            }
+            break;
 
-    if (rhs_res.is_ok()) {
-        // AstExpr* new_rhs = dynamic_cast<AstExpr*>(rhs_res.unwrap());
-        switch (op) {
-            case Operator::MINUS:
-                if (utils::is_type<TypeInteger>(rhs->get_type())
-                    || 
-                    utils::is_type<TypeFloat>(rhs->get_type())
-                ) {
-                    // This operator only allows for numerical types 
-                    // to be negated
-                }
-                break;
+        case Operator::BINARY_NOT:
+            if (!utils::dyn_cast<TypeInteger>(rhs_type)) {
+                return Err(Error(ErrorCode::ComplementNonInteger));
+            }
+            break;
+
+        case Operator::LOGICAL_NOT:
+            if (!utils::dyn_cast<TypeBoolean>(rhs_type)) {
+                return Err(Error(ErrorCode::NotNonBoolean));
+            }
+            break;
+
+        default:
+            return Err(Error(ErrorCode::InvalidPrefixOperator));
+    }
+
+    if (const_eval::is_constant(rhs)) {
+        // Replaces this node, so nothing of it can be used after
+        return const_eval::fold_prefix(self, ctx);
+    }
+
+    type = rhs_type;
+    return Ok(Unit());
+}
+
+static bool 
+is_number(const Type* type) {
+    return utils::dyn_cast<TypeInteger>(type) || utils::dyn_cast<TypeFloat>(type);
+}
+
+/// The operator that a compound assignment like `+=` applies
+static Operator 
+assigned_operator(Operator op) {
+    switch (op) {
+        case Operator::ASSIGN_PLUS: return Operator::PLUS;
+        case Operator::ASSIGN_MINUS: return Operator::MINUS;
+        case Operator::ASSIGN_MUL: return Operator::MUL;
+        case Operator::ASSIGN_DIV: return Operator::DIV;
+        case Operator::ASSIGN_MOD: return Operator::MOD;
+        case Operator::ASSIGN_BINARY_AND: return Operator::BINARY_AND;
+        case Operator::ASSIGN_BINARY_OR: return Operator::BINARY_OR;
+        case Operator::ASSIGN_BINARY_XOR: return Operator::BINARY_XOR;
+        case Operator::ASSIGN_SHIFT_LEFT: return Operator::SHIFT_LEFT;
+        case Operator::ASSIGN_SHIFT_RIGHT: return Operator::SHIFT_RIGHT;
+        default: return op;
+    }
+}
 
-            default:
-                return Err(Error(Error::Type::Semantic, "Invalid operator for prefix expression."));
-            
+/// Type of `lhs op rhs`, or why the operands do not fit the operator
+static ResultType 
+binary_type(Operator op, const Type* lhs, const Type* rhs, TypeContext& types) {
+    DiagnosticArg name = DiagnosticArg::text(operator_to_cstr(op));
+    const Type* boolean = types.boolean();
+
+    switch (op) {
+        // Arithmetic and bitwise operators take the 
+        // coalesced type of their operands
+        case Operator::PLUS:
+        case Operator::MINUS:
+        case Operator::MUL:
+        case Operator::DIV:
+        case Operator::MOD:
+            if (!is_number(lhs) || !is_number(rhs)) {
+                return Err(Error(ErrorCode::ArithmeticNonNumber, { name }));
+            }
+            return types.coalesce(lhs, rhs);
+
+        case Operator::BINARY_AND:
+        case Operator::BINARY_OR:
+        case Operator::BINARY_XOR:
+            if (!utils::dyn_cast<TypeInteger>(lhs) || !utils::dyn_cast<TypeInteger>(rhs)) {
+                return Err(Error(ErrorCode::BitwiseNonInteger, { name }));
+            }
+            return types.coalesce(lhs, rhs);
+
+        // Shifts keep the type of the value being shifted
+        case Operator::SHIFT_LEFT:
+        case Operator::SHIFT_RIGHT:
+            if (!utils::dyn_cast<TypeInteger>(lhs) || !utils::dyn_cast<TypeInteger>(rhs)) {
+                return Err(Error(ErrorCode::BitwiseNonInteger, { name }));
+            }
+            return Ok(lhs);
+
+        case Operator::LOGICAL_AND:
+        case Operator::LOGICAL_OR:
+            if (!utils::dyn_cast<TypeBoolean>(lhs) || !utils::dyn_cast<TypeBoolean>(rhs)) {
+                return Err(Error(ErrorCode::LogicalNonBoolean, { name }));
+            }
+            return Ok(boolean);
+
+        // Numbers of different types can be equal, 
+        // as long as they have a common type
+        case Operator::EQUAL:
+        case Operator::NOT_EQUAL: {
+            ResultType coalesced = types.coalesce(lhs, rhs);
+            if (coalesced.is_err()) {
+                return coalesced;
+            }
+            return Ok(boolean);
         }
-        
-        return Ok(this);
-    } else {
-        return Err(rhs_res.unwrap_err());
+
+        case Operator::LESS_THAN:
+        case Operator::GREATER_THAN:
+        case Operator::LESS_EQUAL:
+        case Operator::GREATER_EQUAL:
+            if (!is_number(lhs) || lhs != rhs) {
+                return Err(Error(ErrorCode::ComparisonMismatch, { name }));
+            }
+            return Ok(boolean);
+
+        default:
+            return Err(Error(ErrorCode::InvalidBinaryOperator));
     }
 }
 
-AnalyzeResult AstBinaryExpr::analyze() {
-    AnalyzeResult rhs_res = rhs->analyze();
-    AnalyzeResult lhs_res = lhs->analyze();
+AnalyzeResult AstBinaryExpr::check(ExprRef self, AnalysisContext& ctx) {
+    Operator applied = assigned_operator(op);
+    bool is_shift = applied == Operator::SHIFT_LEFT || applied == Operator::SHIFT_RIGHT;
 
-    if (!rhs_res.is_ok()) {
-        logger::Error("Failed to analyze rhs of BinaryExpr");
-        return Err(rhs_res.unwrap_err());
+    // A constant next to a typed operand takes the type of that operand
+    // when its value fits, so `x + 1` with `x: i32` stays an i32
+    if (!is_shift) {
+        if (const_eval::is_constant(lhs) && !const_eval::is_constant(rhs) && rhs->get_type()) {
+            const_eval::convert(lhs, rhs->get_type());
+        } else if (const_eval::is_constant(rhs) && !const_eval::is_constant(lhs) && lhs->get_type()) {
+            const_eval::convert(rhs, lhs->get_type());
+        }
     }
 
-    if (!lhs_res.is_ok()) {
-        logger::Error("Failed to analyze lhs of BinaryExpr");
-        return Err(lhs_res.unwrap_err());
+    if (lhs->get_type() == nullptr || rhs->get_type() == nullptr) {
+        return Ok(Unit());
     }
 
-    delete rhs;
-    delete lhs;
+    // Assignments give their variable a value of its own type, 
+    // which is also the type of the assignment
+    if (op >= Operator::ASSIGN) {
+        if (!utils::dyn_cast<AstIdentifierExpr>(lhs)) {
+            return Err(Error(ErrorCode::AssignToNonVariable));
+        }
+
+        const Type* assigned = rhs->get_type();
+        if (op != Operator::ASSIGN) {
+            ResultType applied_type = binary_type(applied, lhs->get_type(), rhs->get_type(), ctx.types);
+            if (applied_type.is_err()) {
+                return Err(applied_type.unwrap_err());
+            }
+            assigned = applied_type.unwrap();
+        }
+        if (assigned != lhs->get_type()) {
+            return Err(Error(ErrorCode::AssignMismatch, { DiagnosticArg::text(operator_to_cstr(op)) }));
+        }
 
-    rhs = dynamic_cast<AstExpr*>(rhs_res.unwrap());
-    lhs = dynamic_cast<AstExpr*>(lhs_res.unwrap());
+        type = lhs->get_type();
+        return Ok(Unit());
+    }
 
-    /// TODO: 
-    /// Perform transformations on binary nodes here
-    /// like consolidating operations on constants
+    ResultType result_type = binary_type(op, lhs->get_type(), rhs->get_type(), ctx.types);
+    if (result_type.is_err()) {
+        return Err(result_type.unwrap_err());
+    }
 
-    return Ok(this);
-    /* return Err(Error(Error::Type::Semantic, "NOT DONE")); */
+    // Operations on constants are folded into a literal,
+    // which takes the place of this node
+    if (const_eval::is_constant(lhs) && const_eval::is_constant(rhs)) {
+        AnalyzeResult folded = const_eval::fold_binary(self, ctx);
+        if (folded.is_err()) {
+            return folded;
+        }
+
+        // Unless the operator could not be folded, this node is gone
+        if (self.get() != this || self->kind != AstKind::BinaryExpr) {
+            return Ok(Unit());
+        }
+    }
+
+    type = result_type.unwrap();
+    return Ok(Unit());
+}
+
+/// Number of top level declarations a thread takes at a time
+constexpr usize ANALYSIS_GRAIN = 16;
+
+usize Program::analyze(usize jobs) {
+    SymbolTable globals;
+    AnalysisContext global_ctx = { globals, m_types, m_arena };
+    std::vector<std::optional<Error>> errors(m_nodes.size());
+
+    // A declaration with a type annotation does not depend on any other 
+    // declaration for its type. These are all declared first, so they can
+    // then be analyzed in any order and on any thread. Functions always 
+    // have their types spelled out, so they are among them
+    std::vector<usize> independent;
+    std::vector<usize> dependent;
+    for (usize i = 0; i < m_nodes.size(); i++) {
+        if (AstFunctionDecl* function = utils::dyn_cast<AstFunctionDecl>(m_nodes[i])) {
+            Result<AstFunctionDecl*, Error> declared = function->declare(global_ctx);
+            if (declared.is_err()) {
+                errors[i] = declared.unwrap_err();
+            } else {
+                independent.push_back(i);
+            }
+            continue;
+        }
+
+        AstVarDecl* decl = utils::dyn_cast<AstVarDecl>(m_nodes[i]);
+        if (decl == nullptr || !decl->type.has_value()) {
+            dependent.push_back(i);
+            continue;
+        }
+
+        Result<AstVarDecl*, Error> declared = decl->declare(global_ctx);
+        if (declared.is_err()) {
+            errors[i] = declared.unwrap_err();
+        } else {
+            independent.push_back(i);
+        }
+    }
+
+    // The rest need the types of what they use, so they 
+    // are analyzed in source order on this thread
+    for (usize i : dependent) {
+        AnalyzeResult result = m_nodes[i]->analyze(global_ctx);
+        if (result.is_err()) {
+            errors[i] = result.unwrap_err();
+        }
+    }
+
+    // The globals are only read from here on. Each worker declares
+    // anything else in its own table on top of them, and puts nodes
+    // made by rewrites in its own arena
+    ThreadPool pool(jobs);
+    std::vector<std::unique_ptr<SymbolTable>> locals;
+    for (usize i = 0; i < pool.size(); i++) {
+        locals.push_back(std::make_unique<SymbolTable>(&globals));
+    }
+    while (m_worker_arenas.size() < pool.size()) {
+        m_worker_arenas.push_back(std::make_unique<Arena>());
+    }
+
+    pool.parallel_for(independent.size(), ANALYSIS_GRAIN, [&](usize begin, usize end, usize worker) {
+        AnalysisContext ctx = { *locals[worker], m_types, *m_worker_arenas[worker] };
+        for (usize k = begin; k < end; k++) {
+            usize i = independent[k];
+            AnalyzeResult result = m_nodes[i]->analyze(ctx);
+            if (result.is_err()) {
+                errors[i] = result.unwrap_err();
+            }
+        }
+    });
+
+    usize error_count = 0;
+    for (const std::optional<Error>& error : errors) {
+        if (error.has_value()) {
+            error->emit();
+            error_count++;
+        }
+    }
+    return error_count;
+}
+
+Result<const AstFunctionDecl*, Error> Program::entry_point() const {
+    Symbol main_name = Interner::global().intern("main");
+    for (const AstNode* node : m_nodes) {
+        const AstFunctionDecl* function = utils::dyn_cast<AstFunctionDecl>(node);
+        if (function == nullptr || function->name != main_name) {
+            continue;
+        }
+
+        const TypeInteger* result = utils::dyn_cast<TypeInteger>(function->return_type);
+        if (!function->params.empty() || result == nullptr || !result->is_signed || result->size != 4) {
+            return Err(Error(ErrorCode::InvalidMain));
+        }
+        return Ok(function);
+    }
+    return Err(Error(ErrorCode::MissingMain));
 }
 
 }
@@ -0,0 +1,76 @@
+#pragma once
+#include "defines.h"
+#include "core/tokens.h"
+#include <vector>
+
+namespace compiler {
+
+/// The tokens of a whole source file, lexed in one pass and stored
+/// as parallel arrays. Token `i` is described by `kind(i)`, `span(i)`
+/// and a payload: an index into the literal tables for numbers, 
+/// or the interned symbol for identifiers.
+/// The parser walks this by index, so lookahead is just an offset.
+class TokenBuffer {
+public:
+    TokenBuffer() noexcept = default;
+
+    /// Make room for roughly as many tokens as `source_size` bytes
+    /// of source code would produce
+    void reserve_for(usize source_size) {
+        usize estimate = source_size / 4 + 1;
+        m_kinds.reserve(estimate);
+        m_offsets.reserve(estimate);
+        m_lengths.reserve(estimate);
+        m_payloads.reserve(estimate);
+    }
+
+    /// Append a token
+    void push(Token token) {
+        ReservedToken kind = token.kind();
+        SourceSpan span = token.span();
+        u32 payload = 0;
+
+        if (kind == ReservedToken::Integer) {
+            payload = static_cast<u32>(m_integers.size());
+            m_integers.push_back(token.get<Integer>());
+        } else if (kind == ReservedToken::Float) {
+            payload = static_cast<u32>(m_floats.size());
+            m_floats.push_back(token.get<Float>());
+        } else if (kind == ReservedToken::Identifier) {
+            payload = token.get<Identifier>().symbol;
+        }
+
+        m_kinds.push_back(kind);
+        m_offsets.push_back(span.offset);
+        m_lengths.push_back(span.length);
+        m_payloads.push_back(payload);
+    }
+
+    [[ nodiscard ]] usize size() const noexcept { return m_kinds.size(); }
+    [[ nodiscard ]] ReservedToken kind(usize i) const noexcept { return m_kinds[i]; }
+    [[ nodiscard ]] SourceSpan span(usize i) const noexcept { return { m_offsets[i], m_lengths[i] }; }
+
+    /// Rebuild the token at index `i`
+    [[ nodiscard ]]
+    Token token(usize i) const {
+        switch (m_kinds[i]) {
+            case ReservedToken::Identifier: return Token(Identifier{ span(i), m_payloads[i] });
+            case ReservedToken::String: return Token(String{ span(i) });
+            case ReservedToken::Integer: return Token(m_integers[m_payloads[i]], span(i));
+            case ReservedToken::Float: return Token(m_floats[m_payloads[i]], span(i));
+            case ReservedToken::Eof: return Token(Eof(), span(i));
+            default: return Token(m_kinds[i], span(i));
+        }
+    }
+
+private:
+    std::vector<ReservedToken> m_kinds;
+    std::vector<u32> m_offsets;
+    std::vector<u32> m_lengths;
+    std::vector<u32> m_payloads;  // literal table index or symbol, depending on the kind
+
+    std::vector<Integer> m_integers;
+    std::vector<Float> m_floats;
+};
+
+}
@@ -0,0 +1,182 @@
+#include "builder.h"
+
+namespace compiler {
+namespace ir {
+
+Builder::Builder(Module& module, Function& function)
+    : m_module(module)
+      , m_function(function)
+    {
+        // The entry block
+        create_block();
+    }
+
+BlockId Builder::create_block() {
+    m_blocks.emplace_back();
+    m_phi_counts.push_back(0);
+    return static_cast<BlockId>(m_blocks.size() - 1);
+}
+
+bool Builder::is_terminated() const {
+    const std::vector<ValueId>& insts = m_blocks[m_block];
+    return !insts.empty() && is_terminator(m_insts[insts.back()].op);
+}
+
+ValueId Builder::add(Op op, ValueType type, std::span<const ValueId> operands, u64 imm) {
+    ValueId id = static_cast<ValueId>(m_insts.size());
+    m_insts.push_back(Inst{
+        op, type,
+        static_cast<u16>(operands.size()),
+        static_cast<u32>(m_operands.size()),
+        imm,
+    });
+    m_operands.insert(m_operands.end(), operands.begin(), operands.end());
+    m_blocks[m_block].push_back(id);
+    return id;
+}
+
+ValueId Builder::constant(ValueType type, u64 bits) {
+    if (type == ValueType::Bool) {
+        bits = bits != 0;
+    } else if (is_integer(type) && integer_size(type) < 8) {
+        u32 width = integer_size(type) * 8;
+        bits &= (u64(1) << width) - 1;
+        if (is_signed(type) && (bits >> (width - 1)) != 0) {
+            bits |= ~u64(0) << width;
+        }
+    }
+    return add(Op::Const, type, {}, bits);
+}
+
+ValueId Builder::param(u32 index) {
+    return add(Op::Param, m_function.params[index], {}, index);
+}
+
+ValueId Builder::load_global(u32 global) {
+    return add(Op::LoadGlobal, m_module.globals[global].type, {}, global);
+}
+
+void Builder::store_global(u32 global, ValueId value) {
+    add(Op::StoreGlobal, ValueType::None, { &value, 1 }, global);
+}
+
+ValueId Builder::call(u32 callee, std::span<const ValueId> args) {
+    return add(Op::Call, m_module.functions[callee]->return_type, args, callee);
+}
+
+ValueId Builder::binary(Op op, ValueId lhs, ValueId rhs) {
+    ValueId operands[] = { lhs, rhs };
+    return add(op, is_comparison(op) ? ValueType::Bool : type_of(lhs), operands, 0);
+}
+
+ValueId Builder::unary(Op op, ValueId value) {
+    return add(op, type_of(value), { &value, 1 }, 0);
+}
+
+ValueId Builder::convert(ValueId value, ValueType type) {
+    return add(Op::Convert, type, { &value, 1 }, 0);
+}
+
+ValueId Builder::phi(ValueType type) {
+    ValueId id = static_cast<ValueId>(m_insts.size());
+    m_insts.push_back(Inst{ Op::Phi, type, 0, 0, m_phis.size() });
+    m_phis.emplace_back();
+
+    std::vector<ValueId>& insts = m_blocks[m_block];
+    insts.insert(insts.begin() + m_phi_counts[m_block], id);
+    m_phi_counts[m_block]++;
+    return id;
+}
+
+void Builder::add_incoming(ValueId phi, ValueId value, BlockId from) {
+    PendingPhi& pending = m_phis[m_insts[phi].imm];
+    pending.values.push_back(value);
+    pending.blocks.push_back(from);
+}
+
+void Builder::jump(BlockId target) {
+    add(Op::Jump, ValueType::None, {}, target);
+}
+
+void Builder::branch(ValueId condition, BlockId then_block, BlockId else_block) {
+    add(Op::Branch, ValueType::None, { &condition, 1 }, u64(then_block) | (u64(else_block) << 32));
+}
+
+void Builder::ret(ValueId value) {
+    add(Op::Return, ValueType::None, { &value, 1 }, 0);
+}
+
+void Builder::ret() {
+    add(Op::Return, ValueType::None, {}, 0);
+}
+
+void Builder::finish() {
+    // Values are numbered in the order the blocks are laid out in
+    std::vector<ValueId> numbers(m_insts.size());
+    ValueId next = 0;
+    for (const std::vector<ValueId>& insts : m_blocks) {
+        for (ValueId id : insts) {
+            numbers[id] = next++;
+        }
+    }
+
+    std::vector<Inst> insts;
+    std::vector<ValueId> operands;
+    std::vector<BlockId> incoming;
+    std::vector<Block> blocks;
+    std::vector<std::vector<BlockId>> preds(m_blocks.size());
+    insts.reserve(m_insts.size());
+    operands.reserve(m_operands.size());
+
+    for (BlockId block = 0; block < m_blocks.size(); block++) {
+        blocks.push_back(Block{ static_cast<u32>(insts.size()), static_cast<u32>(m_blocks[block].size()), 0, 0 });
+
+        for (ValueId id : m_blocks[block]) {
+            Inst inst = m_insts[id];
+            u32 first = static_cast<u32>(operands.size());
+
+            if (inst.op == Op::Phi) {
+                const PendingPhi& pending = m_phis[inst.imm];
+                for (ValueId value : pending.values) {
+                    operands.push_back(numbers[value]);
+                }
+                inst.operand_count = static_cast<u16>(pending.values.size());
+                inst.imm = incoming.size();
+                incoming.insert(incoming.end(), pending.blocks.begin(), pending.blocks.end());
+            } else {
+                for (ValueId value : std::span(m_operands).subspan(inst.first_operand, inst.operand_count)) {
+                    operands.push_back(numbers[value]);
+                }
+            }
+            inst.first_operand = first;
+            insts.push_back(inst);
+
+            // Targets that do not exist are left for the verifier to report
+            if (inst.op == Op::Jump || inst.op == Op::Branch) {
+                BlockId targets[] = { inst.then_target(), inst.else_target() };
+                for (usize i = 0; i < (inst.op == Op::Branch ? 2u : 1u); i++) {
+                    if (targets[i] < m_blocks.size()) {
+                        preds[targets[i]].push_back(block);
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<BlockId> flat_preds;
+    for (BlockId block = 0; block < m_blocks.size(); block++) {
+        blocks[block].first_pred = static_cast<u32>(flat_preds.size());
+        blocks[block].pred_count = static_cast<u32>(preds[block].size());
+        flat_preds.insert(flat_preds.end(), preds[block].begin(), preds[block].end());
+    }
+
+    core::Arena& arena = m_module.arena;
+    m_function.blocks = arena.copy_array(blocks);
+    m_function.insts = arena.copy_array(insts);
+    m_function.operands = arena.copy_array(operands);
+    m_function.incoming = arena.copy_array(incoming);
+    m_function.preds = arena.copy_array(flat_preds);
+}
+
+} // namespace ir
+} // namespace compiler
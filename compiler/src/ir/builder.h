@@ -0,0 +1,81 @@
+#pragma once
+#include "defines.h"
+#include "ir.h"
+#include <span>
+#include <vector>
+
+namespace compiler {
+namespace ir {
+
+/// Builds the body of one function of a module. Instructions are added
+/// to the end of the current block, and blocks can be filled in any
+/// order. Values are numbered in the order they are made until `finish`
+/// lays the function out in the arena of the module, block by block,
+/// and renumbers them to match.
+/// The builder only checks what it needs to know the type of a result.
+/// Everything else is left to the verifier
+class Builder {
+public:
+    /// Build the body of `function`, whose signature is already set
+    Builder(Module& module, Function& function);
+
+    BlockId create_block();
+    void set_block(BlockId block) { m_block = block; }
+    BlockId block() const { return m_block; }
+
+    /// Whether the current block already ends with a terminator
+    bool is_terminated() const;
+
+    ValueType type_of(ValueId value) const { return m_insts[value].type; }
+
+    /// Integers are truncated to their type and sign or zero extended
+    /// again, so equal constants always have equal bits
+    ValueId constant(ValueType type, u64 bits);
+    ValueId param(u32 index);
+    ValueId load_global(u32 global);
+    void store_global(u32 global, ValueId value);
+    ValueId call(u32 callee, std::span<const ValueId> args);
+
+    /// Arithmetic, bitwise and comparison ops. Comparisons make a Bool,
+    /// everything else a value of the type of the operands
+    ValueId binary(Op op, ValueId lhs, ValueId rhs);
+    /// Neg, Complement and Not
+    ValueId unary(Op op, ValueId value);
+    ValueId convert(ValueId value, ValueType type);
+
+    /// Add a phi to the current block, after any phis it already has.
+    /// Its values are added with `add_incoming`, one per predecessor
+    ValueId phi(ValueType type);
+    void add_incoming(ValueId phi, ValueId value, BlockId from);
+
+    void jump(BlockId target);
+    void branch(ValueId condition, BlockId then_block, BlockId else_block);
+    void ret(ValueId value);
+    void ret();
+
+    /// Lay the function out. The builder cannot be used afterwards
+    void finish();
+
+private:
+    /// Incoming values of a phi. They can be added after the phi is made,
+    /// so they are kept apart from the operands of other instructions
+    struct PendingPhi {
+        std::vector<ValueId> values;
+        std::vector<BlockId> blocks;
+    };
+
+    ValueId add(Op op, ValueType type, std::span<const ValueId> operands, u64 imm);
+
+    Module& m_module;
+    Function& m_function;
+    BlockId m_block = 0;
+
+    std::vector<Inst> m_insts;          // in the order they were made
+    std::vector<ValueId> m_operands;
+    std::vector<PendingPhi> m_phis;     // indexed by the `imm` of phis
+    std::vector<std::vector<ValueId>> m_blocks; // instructions of each block, in order
+    std::vector<u32> m_phi_counts;     // phis at the start of each block
+};
+
+} // namespace ir
+} // namespace compiler
@@ -0,0 +1,92 @@
+#include "dominators.h"
+#include <algorithm>
+
+namespace compiler {
+namespace ir {
+
+DominatorTree::DominatorTree(const Function& function)
+    : m_idom(function.blocks.size(), UNREACHABLE)
+      , m_position(function.blocks.size(), UNREACHABLE)
+    {
+        if (function.blocks.empty()) {
+            return;
+        }
+
+        // Post order with an explicit stack, since functions can have
+        // far more blocks than the native stack has frames
+        struct Frame {
+            BlockId block;
+            u32 next;  // successor to visit next
+        };
+        std::vector<bool> visited(function.blocks.size(), false);
+        std::vector<Frame> stack = { Frame{ 0, 0 } };
+        visited[0] = true;
+        while (!stack.empty()) {
+            Frame& frame = stack.back();
+            Successors successors = function.successors(frame.block);
+            if (frame.next < successors.count) {
+                BlockId next = successors.blocks[frame.next++];
+                if (next < function.blocks.size() && !visited[next]) {
+                    visited[next] = true;
+                    stack.push_back(Frame{ next, 0 });
+                }
+                continue;
+            }
+            m_order.push_back(frame.block);
+            stack.pop_back();
+        }
+
+        std::reverse(m_order.begin(), m_order.end());
+        for (u32 i = 0; i < m_order.size(); i++) {
+            m_position[m_order[i]] = i;
+        }
+
+        // Walk up from both blocks until they meet. Blocks earlier in
+        // the order are closer to the entry
+        auto intersect = [&](BlockId a, BlockId b) {
+            while (a != b) {
+                while (m_position[a] > m_position[b]) {
+                    a = m_idom[a];
+                }
+                while (m_position[b] > m_position[a]) {
+                    b = m_idom[b];
+                }
+            }
+            return a;
+        };
+
+        m_idom[0] = 0;
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (usize i = 1; i < m_order.size(); i++) {
+                BlockId block = m_order[i];
+                BlockId idom = UNREACHABLE;
+                for (BlockId pred : function.preds_of(block)) {
+                    if (m_idom[pred] == UNREACHABLE) {
+                        continue;
+                    }
+                    idom = idom == UNREACHABLE ? pred : intersect(pred, idom);
+                }
+                if (idom != m_idom[block]) {
+                    m_idom[block] = idom;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+bool DominatorTree::dominates(BlockId a, BlockId b) const {
+    if (!is_reachable(a) || !is_reachable(b)) {
+        return false;
+    }
+
+    // Dominators of a block are all earlier in the order
+    while (m_position[b] > m_position[a]) {
+        b = m_idom[b];
+    }
+    return a == b;
+}
+
+} // namespace ir
+} // namespace compiler
@@ -0,0 +1,39 @@
+#pragma once
+#include "defines.h"
+#include "ir.h"
+#include <span>
+#include <vector>
+
+namespace compiler {
+namespace ir {
+
+/// Immediate dominators of the blocks of a function, found with the
+/// iterative algorithm of Cooper, Harvey and Kennedy over the reverse
+/// post order. Blocks the entry cannot reach have no dominator
+class DominatorTree {
+public:
+    static constexpr BlockId UNREACHABLE = ~0u;
+
+    explicit DominatorTree(const Function& function);
+
+    bool is_reachable(BlockId block) const { return m_idom[block] != UNREACHABLE; }
+
+    /// Closest block that every path from the entry to `block` goes
+    /// through. The entry is its own
+    BlockId idom(BlockId block) const { return m_idom[block]; }
+
+    /// Whether every path from the entry to `b` goes through `a`.
+    /// A block dominates itself
+    bool dominates(BlockId a, BlockId b) const;
+
+    /// The reachable blocks, each before the blocks it dominates
+    std::span<const BlockId> reverse_post_order() const { return m_order; }
+
+private:
+    std::vector<BlockId> m_idom;
+    std::vector<BlockId> m_order;
+    std::vector<u32> m_position;  // of each block in `m_order`
+};
+
+} // namespace ir
+} // namespace compiler
@@ -0,0 +1,159 @@
+#include "ir.h"
+#include <bit>
+#include <cstdio>
+
+namespace compiler {
+namespace ir {
+
+const char* type_name(ValueType type) {
+    switch (type) {
+        case ValueType::None: return "none";
+        case ValueType::Bool: return "bool";
+        case ValueType::I8: return "i8";
+        case ValueType::I16: return "i16";
+        case ValueType::I32: return "i32";
+        case ValueType::I64: return "i64";
+        case ValueType::U8: return "u8";
+        case ValueType::U16: return "u16";
+        case ValueType::U32: return "u32";
+        case ValueType::U64: return "u64";
+        case ValueType::F32: return "f32";
+        case ValueType::F64: return "f64";
+    }
+    return "__illegal_type__";
+}
+
+const char* op_name(Op op) {
+    switch (op) {
+#define X(name, text) case Op::name: return text;
+        IR_OPCODES(X)
+#undef X
+    }
+    return "__illegal_op__";
+}
+
+Successors Function::successors(BlockId block) const {
+    const Block& info = blocks[block];
+    if (info.inst_count == 0) {
+        return Successors{ {}, 0 };
+    }
+
+    const Inst& last = insts[info.first_inst + info.inst_count - 1];
+    switch (last.op) {
+        case Op::Jump: return Successors{ { last.target(), 0 }, 1 };
+        case Op::Branch: return Successors{ { last.then_target(), last.else_target() }, 2 };
+        default: return Successors{ {}, 0 };
+    }
+}
+
+static void
+print_constant(const Inst& inst) {
+    switch (inst.type) {
+        case ValueType::Bool:
+            printf("%s", inst.imm != 0 ? "true" : "false");
+            break;
+        case ValueType::F32:
+            printf("%lf", static_cast<f64>(std::bit_cast<f32>(static_cast<u32>(inst.imm))));
+            break;
+        case ValueType::F64:
+            printf("%lf", std::bit_cast<f64>(inst.imm));
+            break;
+        default:
+            if (is_signed(inst.type)) {
+                printf("%ld", static_cast<i64>(inst.imm));
+            } else {
+                printf("%lu", inst.imm);
+            }
+            break;
+    }
+}
+
+void Module::print() const {
+    for (usize i = 0; i < globals.size(); i++) {
+        printf("global @%.*s: %s\n", static_cast<int>(globals[i].name.length()), globals[i].name.data(), type_name(globals[i].type));
+    }
+    for (const Function* function : functions) {
+        printf("\n");
+        print(*function);
+    }
+}
+
+void Module::print(const Function& function) const {
+    printf("define %.*s(", static_cast<int>(function.name.length()), function.name.data());
+    for (usize i = 0; i < function.params.size(); i++) {
+        printf("%s%s", i == 0 ? "" : ", ", type_name(function.params[i]));
+    }
+    printf("): %s {\n", type_name(function.return_type));
+
+    for (BlockId block = 0; block < function.blocks.size(); block++) {
+        printf("b%u:", block);
+        std::span<BlockId> preds = function.preds_of(block);
+        for (usize i = 0; i < preds.size(); i++) {
+            printf("%s b%u", i == 0 ? "  ; preds" : ",", preds[i]);
+        }
+        printf("\n");
+
+        u32 id = function.blocks[block].first_inst;
+        for (const Inst& inst : function.insts_of(block)) {
+            std::span<ValueId> operands = function.operands_of(inst);
+            printf("    ");
+            if (inst.type != ValueType::None) {
+                printf("%%%u = %s.%s", id, op_name(inst.op), type_name(inst.type));
+            } else {
+                printf("%s", op_name(inst.op));
+            }
+
+            switch (inst.op) {
+                case Op::Const:
+                    printf(" ");
+                    print_constant(inst);
+                    break;
+                case Op::Param:
+                    printf(" %lu", inst.imm);
+                    break;
+                case Op::LoadGlobal:
+                case Op::StoreGlobal: {
+                    std::string_view name = globals[inst.imm].name;
+                    printf(" @%.*s", static_cast<int>(name.length()), name.data());
+                    for (ValueId operand : operands) {
+                        printf(", %%%u", operand);
+                    }
+                    break;
+                }
+                case Op::Call: {
+                    std::string_view name = functions[inst.imm]->name;
+                    printf(" %.*s(", static_cast<int>(name.length()), name.data());
+                    for (usize i = 0; i < operands.size(); i++) {
+                        printf("%s%%%u", i == 0 ? "" : ", ", operands[i]);
+                    }
+                    printf(")");
+                    break;
+                }
+                case Op::Phi: {
+                    std::span<BlockId> incoming = function.incoming_of(inst);
+                    for (usize i = 0; i < operands.size(); i++) {
+                        printf("%s [%%%u, b%u]", i == 0 ? "" : ",", operands[i], incoming[i]);
+                    }
+                    break;
+                }
+                case Op::Jump:
+                    printf(" b%u", inst.target());
+                    break;
+                case Op::Branch:
+                    printf(" %%%u, b%u, b%u", operands[0], inst.then_target(), inst.else_target());
+                    break;
+                default:
+                    for (usize i = 0; i < operands.size(); i++) {
+                        printf("%s %%%u", i == 0 ? "" : ",", operands[i]);
+                    }
+                    break;
+            }
+            printf("\n");
+            id++;
+        }
+    }
+    printf("}\n");
+}
+
+} // namespace ir
+} // namespace compiler
@@ -0,0 +1,197 @@
+#pragma once
+#include "defines.h"
+#include "core/arena.h"
+#include <array>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace compiler {
+namespace ir {
+
+/// Index of an instruction in its function. It is also the id of the
+/// value the instruction defines
+using ValueId = u32;
+
+/// Index of a basic block in its function
+using BlockId = u32;
+
+/// Type of an SSA value. Integers carry their signedness, so operations
+/// like division and comparison take it from their operands
+enum class ValueType : u8 {
+    None,  // of instructions that define no value
+    Bool,
+    I8,
+    I16,
+    I32,
+    I64,
+    U8,
+    U16,
+    U32,
+    U64,
+    F32,
+    F64,
+};
+
+constexpr bool is_integer(ValueType type) { return type >= ValueType::I8 && type <= ValueType::U64; }
+constexpr bool is_signed(ValueType type) { return type >= ValueType::I8 && type <= ValueType::I64; }
+constexpr bool is_float(ValueType type) { return type == ValueType::F32 || type == ValueType::F64; }
+constexpr bool is_number(ValueType type) { return is_integer(type) || is_float(type); }
+
+/// Size of an integer type in bytes
+constexpr u32 integer_size(ValueType type) {
+    switch (type) {
+        case ValueType::I8: case ValueType::U8: return 1;
+        case ValueType::I16: case ValueType::U16: return 2;
+        case ValueType::I32: case ValueType::U32: return 4;
+        case ValueType::I64: case ValueType::U64: return 8;
+        default: return 0;
+    }
+}
+
+const char* type_name(ValueType type);
+
+/// Every opcode with the name it is printed with
+#define IR_OPCODES(X)             \
+    X(Const, "const")             \
+    X(Param, "param")             \
+    X(LoadGlobal, "load_global")  \
+    X(StoreGlobal, "store_global")\
+    X(Call, "call")               \
+    X(Add, "add")                 \
+    X(Sub, "sub")                 \
+    X(Mul, "mul")                 \
+    X(Div, "div")                 \
+    X(Rem, "rem")                 \
+    X(Shl, "shl")                 \
+    X(Shr, "shr")                 \
+    X(And, "and")                 \
+    X(Or, "or")                   \
+    X(Xor, "xor")                 \
+    X(Neg, "neg")                 \
+    X(Complement, "complement")   \
+    X(Not, "not")                 \
+    X(Eq, "eq")                   \
+    X(Ne, "ne")                   \
+    X(Lt, "lt")                   \
+    X(Le, "le")                   \
+    X(Gt, "gt")                   \
+    X(Ge, "ge")                   \
+    X(Convert, "convert")         \
+    X(Phi, "phi")                 \
+    X(Jump, "jump")               \
+    X(Branch, "branch")           \
+    X(Return, "return")
+
+enum class Op : u8 {
+#define X(name, text) name,
+    IR_OPCODES(X)
+#undef X
+};
+
+const char* op_name(Op op);
+
+constexpr bool is_terminator(Op op) { return op == Op::Jump || op == Op::Branch || op == Op::Return; }
+constexpr bool is_comparison(Op op) { return op >= Op::Eq && op <= Op::Ge; }
+
+/// One instruction. Its value operands are in `Function::operands`,
+/// and what `imm` holds depends on the op:
+///  - Const: the bits of the value. Integers are sign or zero extended
+///    to 64 bits, f32 holds the bits of a float and f64 of a double
+///  - Param: the index of the parameter
+///  - LoadGlobal and StoreGlobal: the index of the global
+///  - Call: the index of the callee in the module
+///  - Phi: where its blocks start in `Function::incoming`. The value of
+///    operand i comes in from block i
+///  - Jump: the target
+///  - Branch: the block taken when the condition holds in the low half,
+///    and the other one in the high half
+struct Inst {
+    Op op;
+    ValueType type;      // of the value it defines
+    u16 operand_count;
+    u32 first_operand;
+    u64 imm;
+
+    BlockId target() const { return static_cast<BlockId>(imm); }
+    BlockId then_target() const { return static_cast<BlockId>(imm); }
+    BlockId else_target() const { return static_cast<BlockId>(imm >> 32); }
+};
+
+static_assert(sizeof(Inst) == 16, "Instructions are scanned linearly, so they should stay small");
+
+/// A run of instructions that ends with the only terminator in it.
+/// Phis come before anything else
+struct Block {
+    u32 first_inst;
+    u32 inst_count;
+    u32 first_pred;  // in `Function::preds`
+    u32 pred_count;
+};
+
+/// The blocks a terminator can go to
+struct Successors {
+    std::array<BlockId, 2> blocks;
+    u32 count;
+
+    const BlockId* begin() const { return blocks.data(); }
+    const BlockId* end() const { return blocks.data() + count; }
+};
+
+/// A function in SSA form. All of its arrays live in the arena of its
+/// module. Instructions are stored block by block, so the instructions
+/// of a block are next to each other and a value is always defined at
+/// a lower index than its uses in the same block
+struct Function {
+    std::string_view name;
+    std::span<ValueType> params;
+    ValueType return_type = ValueType::None;
+
+    std::span<Block> blocks;      // the entry block is first
+    std::span<Inst> insts;
+    std::span<ValueId> operands;
+    std::span<BlockId> incoming;  // blocks of phi operands
+    std::span<BlockId> preds;     // predecessors of each block, in block order
+
+    std::span<Inst> insts_of(BlockId block) const {
+        return insts.subspan(blocks[block].first_inst, blocks[block].inst_count);
+    }
+    std::span<ValueId> operands_of(const Inst& inst) const {
+        return operands.subspan(inst.first_operand, inst.operand_count);
+    }
+    std::span<BlockId> incoming_of(const Inst& phi) const {
+        return incoming.subspan(static_cast<usize>(phi.imm), phi.operand_count);
+    }
+    std::span<BlockId> preds_of(BlockId block) const {
+        return preds.subspan(blocks[block].first_pred, blocks[block].pred_count);
+    }
+
+    /// Successors of a block. A block without a terminator has none
+    Successors successors(BlockId block) const;
+};
+
+/// A global of the program
+struct Global {
+    std::string_view name;
+    ValueType type;
+};
+
+/// A whole program. Functions and everything in them live in `arena`
+/// and are freed with the module
+struct Module {
+    Module() noexcept = default;
+
+    Module(const Module&) = delete;
+    Module& operator=(const Module&) = delete;
+
+    core::Arena arena;
+    std::vector<Function*> functions;
+    std::vector<Global> globals;
+    u32 init = 0;  // function that computes the globals in source order
+
+    void print() const;
+    void print(const Function& function) const;
+};
+
+} // namespace ir
+} // namespace compiler
@@ -0,0 +1,470 @@
+#include "ir_gen.h"
+#include "core/interner.h"
+#include "core/utils.h"
+#include <bit>
+#include <optional>
+#include <vector>
+
+namespace compiler {
+namespace ir {
+
+using namespace core;
+
+/// The IR type of values of `type`, if it has one
+static std::optional<ValueType>
+value_type_of(const Type* type) {
+    if (const TypeInteger* integer = utils::dyn_cast<TypeInteger>(type)) {
+        switch (integer->size) {
+            case 1: return integer->is_signed ? ValueType::I8 : ValueType::U8;
+            case 2: return integer->is_signed ? ValueType::I16 : ValueType::U16;
+            case 4: return integer->is_signed ? ValueType::I32 : ValueType::U32;
+            case 8: return integer->is_signed ? ValueType::I64 : ValueType::U64;
+            default: return {};
+        }
+    }
+    if (const TypeFloat* floating = utils::dyn_cast<TypeFloat>(type)) {
+        return floating->size == 4 ? ValueType::F32 : ValueType::F64;
+    }
+    if (utils::isa<TypeBoolean>(type)) {
+        return ValueType::Bool;
+    }
+    return {};
+}
+
+static Error
+unsupported_type(const Type* type) {
+    return Error(ErrorCode::UnsupportedType, { DiagnosticArg::text(type->to_str()) });
+}
+
+static Error
+unsupported_operator(Operator op) {
+    return Error(ErrorCode::UnsupportedOperator, { DiagnosticArg::text(operator_to_cstr(op)) });
+}
+
+IrGen::IrGen(Program& program)
+    : m_program(program)
+    {}
+
+Result<std::unique_ptr<Module>, Error> IrGen::generate() {
+    m_module = std::make_unique<Module>();
+    Arena& arena = m_module->arena;
+
+    // Every signature is known before any body is lowered, so calls
+    // can go to functions further down
+    std::vector<const AstFunctionDecl*> decls;
+    for (const AstNode* node : m_program.nodes()) {
+        const AstFunctionDecl* decl = utils::dyn_cast<AstFunctionDecl>(node);
+        if (decl == nullptr) {
+            continue;
+        }
+
+        std::vector<ValueType> params;
+        for (const AstParamDecl* param : decl->params) {
+            std::optional<ValueType> type = value_type_of(param->type);
+            if (!type.has_value()) {
+                return Err(unsupported_type(param->type));
+            }
+            params.push_back(type.value());
+        }
+        std::optional<ValueType> return_type = value_type_of(decl->return_type);
+        if (!return_type.has_value()) {
+            return Err(unsupported_type(decl->return_type));
+        }
+
+        Function* function = arena.make<Function>();
+        function->name = arena.copy_string(Interner::global().lookup(decl->name));
+        function->params = arena.copy_array(params);
+        function->return_type = return_type.value();
+
+        m_functions[decl] = static_cast<u32>(m_module->functions.size());
+        m_module->functions.push_back(function);
+        decls.push_back(decl);
+    }
+
+    Function* init = arena.make<Function>();
+    init->name = "craft.init";
+    m_module->init = static_cast<u32>(m_module->functions.size());
+    m_module->functions.push_back(init);
+
+    Result<Unit, Error> lowered_init = lower_init(*init);
+    if (lowered_init.is_err()) {
+        return Err(lowered_init.unwrap_err());
+    }
+
+    for (usize i = 0; i < decls.size(); i++) {
+        Result<Unit, Error> lowered = lower_function(decls[i], *m_module->functions[i]);
+        if (lowered.is_err()) {
+            return Err(lowered.unwrap_err());
+        }
+    }
+    return Ok(std::move(m_module));
+}
+
+Result<Unit, Error> IrGen::lower_init(Function& function) {
+    Builder builder(*m_module, function);
+    m_builder = &builder;
+
+    for (const AstNode* node : m_program.nodes()) {
+        const AstVarDecl* decl = utils::dyn_cast<AstVarDecl>(node);
+        if (decl == nullptr) {
+            continue;
+        }
+
+        const Type* type = decl->type.value_or(decl->value->get_type());
+        if (type == nullptr) {
+            return Err(Error(ErrorCode::UntypedExpression));
+        }
+        std::optional<ValueType> value_type = value_type_of(type);
+        if (!value_type.has_value()) {
+            return Err(unsupported_type(type));
+        }
+
+        Result<ValueId, Error> value = lower_expr(decl->value);
+        if (value.is_err()) {
+            return Err(value.unwrap_err());
+        }
+        Result<ValueId, Error> converted = convert(value.unwrap(), decl->value->get_type(), type);
+        if (converted.is_err()) {
+            return Err(converted.unwrap_err());
+        }
+
+        std::string_view name;
+        if (const AstIdentifierExpr* target = utils::dyn_cast<AstIdentifierExpr>(decl->target)) {
+            name = m_module->arena.copy_string(Interner::global().lookup(target->name));
+        }
+        u32 global = static_cast<u32>(m_module->globals.size());
+        m_module->globals.push_back(Global{ name, value_type.value() });
+        builder.store_global(global, converted.unwrap());
+
+        // Added after its value is lowered, so it cannot refer to itself
+        m_slots[decl] = Slot{ global, true };
+    }
+
+    builder.ret();
+    builder.finish();
+    return Ok(Unit());
+}
+
+Result<Unit, Error> IrGen::lower_function(const AstFunctionDecl* decl, Function& function) {
+    Builder builder(*m_module, function);
+    m_builder = &builder;
+
+    for (usize i = 0; i < decl->params.size(); i++) {
+        m_slots[decl->params[i]] = Slot{ builder.param(static_cast<u32>(i)), false };
+    }
+
+    for (const AstNode* stmt : decl->body) {
+        if (const AstReturnStmt* ret = utils::dyn_cast<AstReturnStmt>(stmt)) {
+            Result<ValueId, Error> value = lower_expr(ret->value);
+            if (value.is_err()) {
+                return Err(value.unwrap_err());
+            }
+            Result<ValueId, Error> converted = convert(value.unwrap(), ret->value->get_type(), decl->return_type);
+            if (converted.is_err()) {
+                return Err(converted.unwrap_err());
+            }
+            builder.ret(converted.unwrap());
+
+            // Nothing after a return is ever run
+            break;
+        }
+
+        const AstVarDecl* local = utils::cast<AstVarDecl>(stmt);
+        const Type* type = local->type.value_or(local->value->get_type());
+        if (!value_type_of(type).has_value()) {
+            return Err(unsupported_type(type));
+        }
+
+        Result<ValueId, Error> value = lower_expr(local->value);
+        if (value.is_err()) {
+            return Err(value.unwrap_err());
+        }
+        Result<ValueId, Error> converted = convert(value.unwrap(), local->value->get_type(), type);
+        if (converted.is_err()) {
+            return Err(converted.unwrap_err());
+        }
+        m_slots[local] = Slot{ converted.unwrap(), false };
+    }
+
+    builder.finish();
+    return Ok(Unit());
+}
+
+Result<ValueId, Error> IrGen::lower_expr(const AstExpr* root) {
+    // Walked with an explicit stack like CodeGen does, since
+    // expressions can be far too deep to recurse over
+    struct Frame {
+        const AstExpr* expr;
+        u32 stage;        // operands lowered so far
+        BlockId lhs_end;  // for `&&` and `||`, the block the lhs ends in
+        BlockId merge;    // and the block they join in
+    };
+
+    std::vector<Frame> stack;
+    std::vector<ValueId> values;
+    stack.push_back(Frame{ root, 0, 0, 0 });
+
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        const AstExpr* expr = frame.expr;
+
+        if (expr->get_type() == nullptr) {
+            if (const AstBinaryExpr* binary = utils::dyn_cast<AstBinaryExpr>(expr)) {
+                return Err(Error(ErrorCode::UnsupportedOperator, { DiagnosticArg::text(operator_to_cstr(binary->op)) }));
+            }
+            return Err(Error(ErrorCode::UntypedExpression));
+        }
+
+        if (const AstIdentifierExpr* identifier = utils::dyn_cast<AstIdentifierExpr>(expr)) {
+            const Slot& slot = m_slots.at(identifier->decl);
+            values.push_back(slot.is_global ? m_builder->load_global(slot.index) : slot.index);
+            stack.pop_back();
+            continue;
+        }
+
+        if (const AstCallExpr* call = utils::dyn_cast<AstCallExpr>(expr)) {
+            if (frame.stage < call->args.size()) {
+                AstExpr* arg = call->args[frame.stage++];
+                stack.push_back(Frame{ arg, 0, 0, 0 });
+                continue;
+            }
+
+            // The arguments were lowered in order, so they are on top of the stack
+            std::span<const ValueId> args(values.data() + values.size() - call->args.size(), call->args.size());
+            ValueId result = m_builder->call(m_functions.at(call->target), args);
+            values.resize(values.size() - call->args.size());
+            values.push_back(result);
+            stack.pop_back();
+            continue;
+        }
+
+        if (const AstPrefixExpr* prefix = utils::dyn_cast<AstPrefixExpr>(expr)) {
+            if (frame.stage == 0) {
+                frame.stage = 1;
+                stack.push_back(Frame{ prefix->rhs, 0, 0, 0 });
+                continue;
+            }
+
+            ValueId rhs = values.back();
+            values.pop_back();
+            Result<ValueId, Error> value = lower_prefix(prefix, rhs);
+            if (value.is_err()) {
+                return value;
+            }
+            values.push_back(value.unwrap());
+            stack.pop_back();
+            continue;
+        }
+
+        if (const AstBinaryExpr* binary = utils::dyn_cast<AstBinaryExpr>(expr)) {
+            bool is_and = binary->op == Operator::LOGICAL_AND;
+            bool is_logical = is_and || binary->op == Operator::LOGICAL_OR;
+
+            if (frame.stage == 0) {
+                frame.stage = 1;
+                stack.push_back(Frame{ binary->lhs, 0, 0, 0 });
+                continue;
+            }
+
+            // The rhs of `&&` and `||` is only evaluated if the lhs
+            // does not decide the result already
+            if (frame.stage == 1) {
+                frame.stage = 2;
+                if (is_logical) {
+                    frame.lhs_end = m_builder->block();
+                    BlockId rhs_block = m_builder->create_block();
+                    frame.merge = m_builder->create_block();
+                    if (is_and) {
+                        m_builder->branch(values.back(), rhs_block, frame.merge);
+                    } else {
+                        m_builder->branch(values.back(), frame.merge, rhs_block);
+                    }
+                    m_builder->set_block(rhs_block);
+                }
+                stack.push_back(Frame{ binary->rhs, 0, 0, 0 });
+                continue;
+            }
+
+            ValueId rhs = values.back();
+            values.pop_back();
+            ValueId lhs = values.back();
+            values.pop_back();
+
+            if (is_logical) {
+                // Coming straight from the lhs means it decided the
+                // result, so the lhs is the result
+                BlockId rhs_end = m_builder->block();
+                m_builder->jump(frame.merge);
+                m_builder->set_block(frame.merge);
+
+                ValueId phi = m_builder->phi(ValueType::Bool);
+                m_builder->add_incoming(phi, lhs, frame.lhs_end);
+                m_builder->add_incoming(phi, rhs, rhs_end);
+                values.push_back(phi);
+            } else {
+                Result<ValueId, Error> value = lower_binary(binary, lhs, rhs);
+                if (value.is_err()) {
+                    return value;
+                }
+                values.push_back(value.unwrap());
+            }
+            stack.pop_back();
+            continue;
+        }
+
+        Result<ValueId, Error> literal = lower_literal(expr);
+        if (literal.is_err()) {
+            return literal;
+        }
+        values.push_back(literal.unwrap());
+        stack.pop_back();
+    }
+
+    return Ok(values.back());
+}
+
+Result<ValueId, Error> IrGen::lower_literal(const AstExpr* expr) {
+    std::optional<ValueType> type = value_type_of(expr->get_type());
+    if (!type.has_value()) {
+        return Err(unsupported_type(expr->get_type()));
+    }
+
+    switch (expr->kind) {
+        case AstKind::IntegerExpr:
+            return Ok(m_builder->constant(type.value(), utils::cast<AstIntegerExpr>(expr)->value));
+        case AstKind::FloatExpr: {
+            f64 value = utils::cast<AstFloatExpr>(expr)->value;
+            u64 bits = type == ValueType::F32
+                ? std::bit_cast<u32>(static_cast<f32>(value))
+                : std::bit_cast<u64>(value);
+            return Ok(m_builder->constant(type.value(), bits));
+        }
+        case AstKind::BoolExpr:
+            return Ok(m_builder->constant(type.value(), utils::cast<AstBoolExpr>(expr)->value ? 1 : 0));
+        default:
+            return Err(Error(ErrorCode::UntypedExpression));
+    }
+}
+
+Result<ValueId, Error> IrGen::convert(ValueId value, const Type* from, const Type* to) {
+    if (from == to) {
+        return Ok(value);
+    }
+
+    std::optional<ValueType> source = value_type_of(from);
+    std::optional<ValueType> target = value_type_of(to);
+    if (!source.has_value()) {
+        return Err(unsupported_type(from));
+    }
+    if (!target.has_value()) {
+        return Err(unsupported_type(to));
+    }
+    if (source == target) {
+        return Ok(value);
+    }
+    if (!is_number(source.value()) || !is_number(target.value())) {
+        return Err(unsupported_type(to));
+    }
+    return Ok(m_builder->convert(value, target.value()));
+}
+
+Result<ValueId, Error> IrGen::lower_prefix(const AstPrefixExpr* expr, ValueId rhs) {
+    ValueType type = m_builder->type_of(rhs);
+
+    bool valid;
+    Op op;
+    switch (expr->op) {
+        case Operator::MINUS:
+            valid = is_number(type);
+            op = Op::Neg;
+            break;
+        case Operator::BINARY_NOT:
+            valid = is_integer(type);
+            op = Op::Complement;
+            break;
+        case Operator::LOGICAL_NOT:
+            valid = type == ValueType::Bool;
+            op = Op::Not;
+            break;
+        default:
+            return Err(unsupported_operator(expr->op));
+    }
+
+    if (!valid) {
+        return Err(unsupported_operator(expr->op));
+    }
+    return Ok(m_builder->unary(op, rhs));
+}
+
+Result<ValueId, Error> IrGen::lower_binary(const AstBinaryExpr* expr, ValueId lhs, ValueId rhs) {
+    const Type* lhs_type = expr->lhs->get_type();
+    const Type* rhs_type = expr->rhs->get_type();
+
+    // Shifts keep the type of the value, so the amount is converted to it
+    if (expr->op == Operator::SHIFT_LEFT || expr->op == Operator::SHIFT_RIGHT) {
+        if (!utils::isa<TypeInteger>(lhs_type) || !utils::isa<TypeInteger>(rhs_type)) {
+            return Err(unsupported_operator(expr->op));
+        }
+
+        Result<ValueId, Error> amount = convert(rhs, rhs_type, lhs_type);
+        if (amount.is_err()) {
+            return amount;
+        }
+        return Ok(m_builder->binary(expr->op == Operator::SHIFT_LEFT ? Op::Shl : Op::Shr, lhs, amount.unwrap()));
+    }
+
+    // Both operands are brought to their coalesced type first. For
+    // arithmetic that is the type of the result, and for comparisons
+    // it is the type they are compared in
+    if (lhs_type != rhs_type) {
+        ResultType coalesced = m_program.types().coalesce(lhs_type, rhs_type);
+        if (coalesced.is_err()) {
+            return Err(coalesced.unwrap_err());
+        }
+        const Type* common = coalesced.unwrap();
+
+        Result<ValueId, Error> lhs_converted = convert(lhs, lhs_type, common);
+        if (lhs_converted.is_err()) {
+            return lhs_converted;
+        }
+        Result<ValueId, Error> rhs_converted = convert(rhs, rhs_type, common);
+        if (rhs_converted.is_err()) {
+            return rhs_converted;
+        }
+        lhs = lhs_converted.unwrap();
+        rhs = rhs_converted.unwrap();
+    }
+
+    Op op;
+    switch (expr->op) {
+        case Operator::PLUS: op = Op::Add; break;
+        case Operator::MINUS: op = Op::Sub; break;
+        case Operator::MUL: op = Op::Mul; break;
+        case Operator::DIV: op = Op::Div; break;
+        case Operator::MOD: op = Op::Rem; break;
+        case Operator::BINARY_AND: op = Op::And; break;
+        case Operator::BINARY_OR: op = Op::Or; break;
+        case Operator::BINARY_XOR: op = Op::Xor; break;
+        case Operator::EQUAL: op = Op::Eq; break;
+        case Operator::NOT_EQUAL: op = Op::Ne; break;
+        case Operator::LESS_THAN: op = Op::Lt; break;
+        case Operator::GREATER_THAN: op = Op::Gt; break;
+        case Operator::LESS_EQUAL: op = Op::Le; break;
+        case Operator::GREATER_EQUAL: op = Op::Ge; break;
+        default: return Err(unsupported_operator(expr->op));
+    }
+
+    // Floats have no bitwise ops, and booleans only have those and equality
+    ValueType type = m_builder->type_of(lhs);
+    bool is_bitwise = op == Op::And || op == Op::Or || op == Op::Xor;
+    if (is_float(type) && is_bitwise) {
+        return Err(unsupported_operator(expr->op));
+    }
+    if (type == ValueType::Bool && !is_bitwise && op != Op::Eq && op != Op::Ne) {
+        return Err(unsupported_operator(expr->op));
+    }
+    return Ok(m_builder->binary(op, lhs, rhs));
+}
+
+} // namespace ir
+} // namespace compiler
@@ -0,0 +1,58 @@
+#pragma once
+#include "defines.h"
+#include "builder.h"
+#include "ir.h"
+#include "core/ast.h"
+#include "core/error.h"
+#include "core/result.h"
+#include "core/type.h"
+#include <memory>
+#include <unordered_map>
+
+namespace compiler {
+namespace ir {
+
+using core::Error;
+using core::Result;
+using core::Unit;
+
+/// Lowers an analyzed program to SSA IR, the way CodeGen lowers it to
+/// LLVM IR. Every top level `let` becomes a global, which the `init`
+/// function computes in source order, and every `define` becomes a
+/// function. Locals are never assigned again, so each one is just the
+/// value it was declared with. The operands of every instruction are
+/// converted to the types it takes first, so no conversion is implicit
+class IrGen {
+public:
+    explicit IrGen(core::Program& program);
+
+    Result<std::unique_ptr<Module>, Error> generate();
+
+private:
+    /// Where the value of a declaration is
+    struct Slot {
+        u32 index;       // of the global, or of the value of a local
+        bool is_global;
+    };
+
+    Result<Unit, Error> lower_function(const core::AstFunctionDecl* decl, Function& function);
+    Result<Unit, Error> lower_init(Function& function);
+
+    Result<ValueId, Error> lower_expr(const core::AstExpr* root);
+    Result<ValueId, Error> lower_binary(const core::AstBinaryExpr* expr, ValueId lhs, ValueId rhs);
+    Result<ValueId, Error> lower_prefix(const core::AstPrefixExpr* expr, ValueId rhs);
+    Result<ValueId, Error> lower_literal(const core::AstExpr* expr);
+
+    /// Convert a value between Craft types
+    Result<ValueId, Error> convert(ValueId value, const core::Type* from, const core::Type* to);
+
+    core::Program& m_program;
+    std::unique_ptr<Module> m_module;
+    Builder* m_builder = nullptr;  // of the function being lowered
+
+    std::unordered_map<const core::AstNode*, Slot> m_slots;
+    std::unordered_map<const core::AstFunctionDecl*, u32> m_functions;
+};
+
+} // namespace ir
+} // namespace compiler
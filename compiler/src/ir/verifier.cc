@@ -0,0 +1,304 @@
+#include "verifier.h"
+#include "dominators.h"
+#include <algorithm>
+#include <format>
+#include <string>
+#include <vector>
+
+namespace compiler {
+namespace ir {
+
+using namespace core;
+
+static Error
+invalid(const Function& function, const std::string& problem) {
+    return Error(ErrorCode::InvalidIr, { DiagnosticArg::text(function.name), DiagnosticArg::text(problem) });
+}
+
+/// What is wrong with the types of an instruction, or an empty string.
+/// Operands are known to be values already
+static std::string
+check_types(const Module& module, const Function& function, const Inst& inst, BlockId block) {
+    std::span<ValueId> operands = function.operands_of(inst);
+    auto operand_type = [&](usize i) { return function.insts[operands[i]].type; };
+    auto expect_operands = [&](usize count) -> std::string {
+        if (operands.size() != count) {
+            return std::format("{} takes {} operands but has {}", op_name(inst.op), count, operands.size());
+        }
+        return "";
+    };
+
+    bool defines_value = inst.op != Op::StoreGlobal && !is_terminator(inst.op);
+    if (defines_value && inst.type == ValueType::None) {
+        return std::format("{} has to define a value", op_name(inst.op));
+    }
+    if (!defines_value && inst.type != ValueType::None) {
+        return std::format("{} cannot define a value", op_name(inst.op));
+    }
+
+    switch (inst.op) {
+        case Op::Const:
+            return expect_operands(0);
+
+        case Op::Param:
+            if (block != 0) {
+                return "parameters have to be read in the entry block";
+            }
+            if (inst.imm >= function.params.size()) {
+                return std::format("there is no parameter {}", inst.imm);
+            }
+            if (inst.type != function.params[inst.imm]) {
+                return std::format("parameter {} is read with the wrong type", inst.imm);
+            }
+            return expect_operands(0);
+
+        case Op::LoadGlobal:
+        case Op::StoreGlobal: {
+            if (inst.imm >= module.globals.size()) {
+                return std::format("there is no global {}", inst.imm);
+            }
+            ValueType type = module.globals[inst.imm].type;
+            if (inst.op == Op::LoadGlobal) {
+                return inst.type != type ? "a global is loaded with the wrong type" : expect_operands(0);
+            }
+            std::string count = expect_operands(1);
+            if (!count.empty()) {
+                return count;
+            }
+            return operand_type(0) != type ? "a global is stored with the wrong type" : "";
+        }
+
+        case Op::Call: {
+            if (inst.imm >= module.functions.size()) {
+                return std::format("there is no function {}", inst.imm);
+            }
+            const Function& callee = *module.functions[inst.imm];
+            std::string count = expect_operands(callee.params.size());
+            if (!count.empty()) {
+                return count;
+            }
+            for (usize i = 0; i < operands.size(); i++) {
+                if (operand_type(i) != callee.params[i]) {
+                    return std::format("argument {} of {} has the wrong type", i, callee.name);
+                }
+            }
+            return inst.type != callee.return_type ? "a call has the wrong type" : "";
+        }
+
+        case Op::Add:
+        case Op::Sub:
+        case Op::Mul:
+        case Op::Div:
+        case Op::Rem:
+        case Op::Shl:
+        case Op::Shr:
+        case Op::And:
+        case Op::Or:
+        case Op::Xor: {
+            std::string count = expect_operands(2);
+            if (!count.empty()) {
+                return count;
+            }
+            if (operand_type(0) != inst.type || operand_type(1) != inst.type) {
+                return std::format("the operands of {} need the type of its result", op_name(inst.op));
+            }
+            bool valid = inst.op >= Op::And
+                ? is_integer(inst.type) || inst.type == ValueType::Bool
+                : inst.op >= Op::Shl ? is_integer(inst.type) : is_number(inst.type);
+            return valid ? "" : std::format("{} cannot take {}", op_name(inst.op), type_name(inst.type));
+        }
+
+        case Op::Neg:
+        case Op::Complement:
+        case Op::Not: {
+            std::string count = expect_operands(1);
+            if (!count.empty()) {
+                return count;
+            }
+            if (operand_type(0) != inst.type) {
+                return std::format("the operand of {} needs the type of its result", op_name(inst.op));
+            }
+            bool valid = inst.op == Op::Neg
+                ? is_number(inst.type)
+                : inst.op == Op::Complement ? is_integer(inst.type) : inst.type == ValueType::Bool;
+            return valid ? "" : std::format("{} cannot take {}", op_name(inst.op), type_name(inst.type));
+        }
+
+        case Op::Eq:
+        case Op::Ne:
+        case Op::Lt:
+        case Op::Le:
+        case Op::Gt:
+        case Op::Ge: {
+            std::string count = expect_operands(2);
+            if (!count.empty()) {
+                return count;
+            }
+            if (inst.type != ValueType::Bool) {
+                return "comparisons make a bool";
+            }
+            if (operand_type(0) != operand_type(1)) {
+                return std::format("the operands of {} need the same type", op_name(inst.op));
+            }
+            bool valid = inst.op <= Op::Ne ? true : is_number(operand_type(0));
+            return valid ? "" : std::format("{} cannot take {}", op_name(inst.op), type_name(operand_type(0)));
+        }
+
+        case Op::Convert: {
+            std::string count = expect_operands(1);
+            if (!count.empty()) {
+                return count;
+            }
+            if (!is_number(operand_type(0)) || !is_number(inst.type)) {
+                return "only numbers can be converted";
+            }
+            return operand_type(0) == inst.type ? "a value is converted to its own type" : "";
+        }
+
+        case Op::Phi: {
+            std::span<BlockId> incoming = function.incoming_of(inst);
+            for (usize i = 0; i < operands.size(); i++) {
+                if (operand_type(i) != inst.type) {
+                    return std::format("value {} of a phi has the wrong type", i);
+                }
+            }
+
+            // Each predecessor has to come in once for every edge it has to the block
+            std::vector<BlockId> expected(function.preds_of(block).begin(), function.preds_of(block).end());
+            std::vector<BlockId> actual(incoming.begin(), incoming.end());
+            std::sort(expected.begin(), expected.end());
+            std::sort(actual.begin(), actual.end());
+            return expected != actual ? "the blocks of a phi are not the predecessors of its block" : "";
+        }
+
+        case Op::Jump:
+            return expect_operands(0);
+
+        case Op::Branch: {
+            std::string count = expect_operands(1);
+            if (!count.empty()) {
+                return count;
+            }
+            return operand_type(0) != ValueType::Bool ? "branches need a bool condition" : "";
+        }
+
+        case Op::Return:
+            if (function.return_type == ValueType::None) {
+                return expect_operands(0);
+            } else {
+                std::string count = expect_operands(1);
+                if (!count.empty()) {
+                    return count;
+                }
+                return operand_type(0) != function.return_type ? "the returned value has the wrong type" : "";
+            }
+    }
+    return std::format("unknown op {}", static_cast<u32>(inst.op));
+}
+
+Result<Unit, Error> verify(const Module& module, const Function& function) {
+    if (function.blocks.empty()) {
+        return Err(invalid(function, "it has no entry block"));
+    }
+    if (function.blocks[0].pred_count != 0) {
+        return Err(invalid(function, "the entry block has predecessors"));
+    }
+
+    // Structure, and which block defines each value
+    std::vector<BlockId> defined_in(function.insts.size());
+    for (BlockId block = 0; block < function.blocks.size(); block++) {
+        std::span<Inst> insts = function.insts_of(block);
+        if (insts.empty() || !is_terminator(insts.back().op)) {
+            return Err(invalid(function, std::format("b{} does not end with a terminator", block)));
+        }
+
+        bool past_phis = false;
+        for (usize i = 0; i < insts.size(); i++) {
+            ValueId id = static_cast<ValueId>(function.blocks[block].first_inst + i);
+            defined_in[id] = block;
+
+            if (is_terminator(insts[i].op) && i + 1 != insts.size()) {
+                return Err(invalid(function, std::format("%{} ends b{} before its last instruction", id, block)));
+            }
+            if (insts[i].op == Op::Phi && past_phis) {
+                return Err(invalid(function, std::format("phi %{} comes after other instructions in b{}", id, block)));
+            }
+            past_phis = past_phis || insts[i].op != Op::Phi;
+        }
+
+        for (BlockId target : function.successors(block)) {
+            if (target >= function.blocks.size()) {
+                return Err(invalid(function, std::format("b{} goes to b{}, which does not exist", block, target)));
+            }
+            if (target == 0) {
+                return Err(invalid(function, std::format("b{} goes back to the entry block", block)));
+            }
+        }
+    }
+
+    for (BlockId block = 0; block < function.blocks.size(); block++) {
+        for (usize i = 0; i < function.blocks[block].inst_count; i++) {
+            ValueId id = static_cast<ValueId>(function.blocks[block].first_inst + i);
+            const Inst& inst = function.insts[id];
+            for (ValueId operand : function.operands_of(inst)) {
+                if (operand >= function.insts.size() || function.insts[operand].type == ValueType::None) {
+                    return Err(invalid(function, std::format("%{} uses %{}, which is not a value", id, operand)));
+                }
+            }
+
+            std::string problem = check_types(module, function, inst, block);
+            if (!problem.empty()) {
+                return Err(invalid(function, std::format("%{}: {}", id, problem)));
+            }
+        }
+    }
+
+    // Every use has to be dominated by its definition. A phi uses its
+    // values at the end of the block each one comes in from
+    DominatorTree dominators(function);
+    for (BlockId block = 0; block < function.blocks.size(); block++) {
+        if (!dominators.is_reachable(block)) {
+            continue;
+        }
+
+        for (usize i = 0; i < function.blocks[block].inst_count; i++) {
+            ValueId id = static_cast<ValueId>(function.blocks[block].first_inst + i);
+            const Inst& inst = function.insts[id];
+            std::span<ValueId> operands = function.operands_of(inst);
+
+            for (usize j = 0; j < operands.size(); j++) {
+                ValueId operand = operands[j];
+                bool dominated;
+                if (inst.op == Op::Phi) {
+                    // Nothing comes in from a block that is never run
+                    BlockId from = function.incoming_of(inst)[j];
+                    dominated = !dominators.is_reachable(from) || dominators.dominates(defined_in[operand], from);
+                } else if (defined_in[operand] == block) {
+                    dominated = operand < id;
+                } else {
+                    dominated = dominators.dominates(defined_in[operand], block);
+                }
+                if (!dominated) {
+                    return Err(invalid(function, std::format("%{} uses %{}, which is not defined on every path to it", id, operand)));
+                }
+            }
+        }
+    }
+    return Ok(Unit());
+}
+
+Result<Unit, Error> verify(const Module& module) {
+    if (module.init >= module.functions.size()) {
+        return Err(Error(ErrorCode::InvalidIr, { DiagnosticArg::text("craft.init"), DiagnosticArg::text("the module has no init function") }));
+    }
+    for (const Function* function : module.functions) {
+        Result<Unit, Error> verified = verify(module, *function);
+        if (verified.is_err()) {
+            return verified;
+        }
+    }
+    return Ok(Unit());
+}
+
+} // namespace ir
+} // namespace compiler
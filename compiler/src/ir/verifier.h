@@ -0,0 +1,25 @@
+#pragma once
+#include "defines.h"
+#include "ir.h"
+#include "core/error.h"
+#include "core/result.h"
+
+namespace compiler {
+namespace ir {
+
+using core::Error;
+using core::Result;
+using core::Unit;
+
+/// Check that a function is well formed. Every block has to end with its
+/// only terminator, phis have to lead their blocks with one value per
+/// predecessor, operands have to have the types their op takes, and
+/// every value has to be defined on every path to its uses.
+/// Returns the first problem found as an InvalidIr error
+Result<Unit, Error> verify(const Module& module, const Function& function);
+
+/// Verify every function of a module
+Result<Unit, Error> verify(const Module& module);
+
+} // namespace ir
+} // namespace compiler
@@ -1,24 +1,14 @@
 #include <string>
+#include <vector>
 #include "defines.h"
-#include "frontend/parser.h"
-#include "core/ast.h"
+#include "core/driver.h"
 
 int
 main(i32 argc, char** argv) {
-    /* std::string input = "let x: i32[4] = 5;"; */
-    std::string input = "let x: i32[4] = 5 + 1;";
-    compiler::Parser parser = compiler::Parser(input);
-
-    compiler::core::Program program = compiler::core::Program();
-    compiler::core::AstNode* node = parser.next_node();
-    while (node != nullptr) {
-        program.add_node(node);
-        node = parser.next_node();
+    compiler::core::Driver driver(std::vector<std::string>(argv, argv + argc));
+    if (!driver.process_args()) {
+        return EXIT_FAILURE;
     }
 
-    program.print();
-    program.analyze();
-    
-
-    return EXIT_SUCCESS;
+    return driver.run();
 }
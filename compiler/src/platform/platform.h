@@ -1,10 +1,60 @@
-
+#pragma once
 #include "defines.h"
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace platform {
 
 void console_write(const std::string& msg);
 void console_error(const std::string& msg);
 
+/// Write a whole buffer to stdout/stderr, bypassing stdio buffering.
+/// On Linux this is a single write syscall unless the write is partial
+void console_write_raw(const char* data, usize size);
+void console_error_raw(const char* data, usize size);
+
+/// Run a program, searched for on the PATH, and wait for it to finish.
+/// `args[0]` is the program. Returns its exit code, or -1 if it 
+/// could not be started or did not exit normally
+i32 run_process(const std::vector<std::string>& args);
+
+/// ID of the running process
+u32 process_id();
+
+/// A source file opened for reading. Regular files are mapped 
+/// read-only into memory so the lexer works straight off the 
+/// page cache. Pipes and stdin cannot be mapped, so those 
+/// are read into a buffer instead.
+class SourceFile {
+public:
+    SourceFile() noexcept = default;
+    ~SourceFile();
+
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    /// Tokens store their offset as a u32, so bigger files are refused
+    static constexpr usize MAX_SIZE = 0xFFFFFFFF;
+
+    /// Open the file at `path`. A path of "-" reads standard input.
+    /// Returns false if the file could not be read or is bigger 
+    /// than MAX_SIZE, in which case `too_large()` is set.
+    bool open(const std::string& path);
+    void close();
+
+    bool too_large() const { return m_too_large; }
+
+    /// View over the file contents. Only valid while the file is open
+    std::string_view contents() const { return m_contents; }
+    bool is_mapped() const { return m_mapped != nullptr; }
+
+private:
+    void* m_mapped = nullptr;
+    usize m_mapped_size = 0;
+    std::string m_buffer;
+    std::string_view m_contents;
+    bool m_too_large = false;
+};
+
 }
@@ -1,6 +1,14 @@
 #include "platform.h"
 
 #ifdef Q_PLATFORM_LINUX
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 namespace platform {
 
@@ -16,6 +24,164 @@ console_error(const std::string& msg) {
     fprintf(stderr, "%s", msg.c_str());
 }
 
+// Write all of `data` to a file descriptor
+static void
+write_all(int fd, const char* data, usize size) {
+    while (size > 0) {
+        ssize_t count = ::write(fd, data, size);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        data += count;
+        size -= static_cast<usize>(count);
+    }
+}
+
+// Write a buffer to stdout in one go
+void
+console_write_raw(const char* data, usize size) {
+    fflush(stdout);
+    write_all(STDOUT_FILENO, data, size);
+}
+
+// Write a buffer to stderr in one go
+void
+console_error_raw(const char* data, usize size) {
+    write_all(STDERR_FILENO, data, size);
+}
+
+// Read everything from a file descriptor that cannot be mapped
+static bool
+read_stream(int fd, std::string& buffer) {
+    constexpr usize CHUNK_SIZE = 64 * 1024;
+    usize size = 0;
+
+    for (;;) {
+        buffer.resize(size + CHUNK_SIZE);
+        ssize_t count = ::read(fd, buffer.data() + size, CHUNK_SIZE);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            buffer.clear();
+            return false;
+        }
+        if (count == 0) {
+            break;
+        }
+        size += static_cast<usize>(count);
+    }
+
+    buffer.resize(size);
+    return true;
+}
+
+// Spawn a program and wait for it
+i32
+run_process(const std::vector<std::string>& args) {
+    std::vector<char*> argv;
+    for (const std::string& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    pid_t pid;
+    if (posix_spawnp(&pid, argv[0], nullptr, nullptr, argv.data(), environ) != 0) {
+        return -1;
+    }
+
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+u32
+process_id() {
+    return static_cast<u32>(getpid());
+}
+
+SourceFile::~SourceFile() {
+    close();
+}
+
+bool
+SourceFile::open(const std::string& path) {
+    close();
+
+    if (path == "-") {
+        if (!read_stream(STDIN_FILENO, m_buffer)) {
+            return false;
+        }
+        if (m_buffer.size() > MAX_SIZE) {
+            m_too_large = true;
+            m_buffer.clear();
+            return false;
+        }
+        m_contents = m_buffer;
+        return true;
+    }
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    // Only regular files can be mapped. Empty files are left to the 
+    // buffered path since mmap refuses a length of 0
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        usize size = static_cast<usize>(info.st_size);
+        if (size > MAX_SIZE) {
+            ::close(fd);
+            m_too_large = true;
+            return false;
+        }
+
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            ::close(fd);
+            madvise(mapped, size, MADV_SEQUENTIAL);
+
+            m_mapped = mapped;
+            m_mapped_size = size;
+            m_contents = std::string_view(static_cast<const char*>(mapped), size);
+            return true;
+        }
+    }
+
+    bool ok = read_stream(fd, m_buffer);
+    ::close(fd);
+    if (ok && m_buffer.size() > MAX_SIZE) {
+        m_too_large = true;
+        m_buffer.clear();
+        ok = false;
+    }
+    if (ok) {
+        m_contents = m_buffer;
+    }
+    return ok;
+}
+
+void
+SourceFile::close() {
+    if (m_mapped) {
+        munmap(m_mapped, m_mapped_size);
+        m_mapped = nullptr;
+        m_mapped_size = 0;
+    }
+
+    m_buffer.clear();
+    m_contents = {};
+    m_too_large = false;
+}
+
 }
 
 #endif /* Q_PLATFORM_LINUX */
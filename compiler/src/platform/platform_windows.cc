@@ -1,6 +1,8 @@
 #include "platform.h"
 
 #ifdef Q_PLATFORM_WINDOWS
+#include <cstdio>
+#include <windows.h>
 
 namespace platform {
 
@@ -14,6 +16,121 @@ void
 console_error(const std::string& msg) {
 }
 
+// Write a buffer to stdout in one go
+void
+console_write_raw(const char* data, usize size) {
+}
+
+// Write a buffer to stderr in one go
+void
+console_error_raw(const char* data, usize size) {
+}
+
+// Quote an argument so CommandLineToArgvW and the C runtime split 
+// it back out unchanged. Backslashes only need doubling in front 
+// of a quote.
+static void
+append_quoted(std::string& line, const std::string& arg) {
+    if (!arg.empty() && arg.find_first_of(" \t\n\v\"") == std::string::npos) {
+        line += arg;
+        return;
+    }
+
+    line += '"';
+    usize backslashes = 0;
+    for (char c : arg) {
+        if (c == '\\') {
+            backslashes++;
+            continue;
+        }
+        if (c == '"') {
+            line.append(backslashes * 2 + 1, '\\');
+        } else {
+            line.append(backslashes, '\\');
+        }
+        backslashes = 0;
+        line += c;
+    }
+    line.append(backslashes * 2, '\\');
+    line += '"';
+}
+
+// Spawn a program and wait for it
+i32
+run_process(const std::vector<std::string>& args) {
+    std::string line;
+    for (const std::string& arg : args) {
+        if (!line.empty()) {
+            line += ' ';
+        }
+        append_quoted(line, arg);
+    }
+
+    STARTUPINFOA startup = {};
+    startup.cb = sizeof(startup);
+    PROCESS_INFORMATION process = {};
+
+    // A null application name makes CreateProcess search the PATH
+    if (!CreateProcessA(nullptr, line.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startup, &process)) {
+        return -1;
+    }
+    CloseHandle(process.hThread);
+
+    DWORD code = 0;
+    bool ok = WaitForSingleObject(process.hProcess, INFINITE) == WAIT_OBJECT_0 
+        && GetExitCodeProcess(process.hProcess, &code);
+    CloseHandle(process.hProcess);
+    return ok ? static_cast<i32>(code) : -1;
+}
+
+u32
+process_id() {
+    return static_cast<u32>(GetCurrentProcessId());
+}
+
+SourceFile::~SourceFile() {
+    close();
+}
+
+// Windows always reads the file into a buffer. Only the Linux 
+// build maps sources, so `is_mapped()` is always false here.
+bool
+SourceFile::open(const std::string& path) {
+    close();
+
+    FILE* file = path == "-" ? stdin : std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    char chunk[64 * 1024];
+    usize count;
+    while ((count = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        m_buffer.append(chunk, count);
+    }
+
+    bool ok = std::ferror(file) == 0;
+    if (file != stdin) {
+        std::fclose(file);
+    }
+
+    if (ok && m_buffer.size() > MAX_SIZE) {
+        m_too_large = true;
+        m_buffer.clear();
+        ok = false;
+    }
+
+    m_contents = m_buffer;
+    return ok;
+}
+
+void
+SourceFile::close() {
+    m_buffer.clear();
+    m_contents = {};
+    m_too_large = false;
+}
+
 }
 
 #endif /* Q_PLATFORM_WINDOWS */
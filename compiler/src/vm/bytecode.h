@@ -0,0 +1,179 @@
+#pragma once
+#include "defines.h"
+#include <bit>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace compiler {
+namespace vm {
+
+/// Opcodes that exist once for every integer or float type, in the order
+/// `TypedOp` lists them. Each works on values of exactly that type
+#define VM_NUMBER_OPCODES(X, T) \
+    X(Add##T) X(Sub##T) X(Mul##T) X(Div##T) X(Rem##T) X(Neg##T) \
+    X(Eq##T) X(Ne##T) X(Lt##T) X(Le##T) X(Gt##T) X(Ge##T)
+
+/// Opcodes that only exist for integer types. `Narrow` converts
+/// any integer to the type
+#define VM_INTEGER_OPCODES(X, T) \
+    VM_NUMBER_OPCODES(X, T) \
+    X(Shl##T) X(Shr##T) X(And##T) X(Or##T) X(Xor##T) X(Complement##T) X(Narrow##T)
+
+/// Every opcode, in the order of `Op`
+#define VM_OPCODES(X) \
+    X(Move) X(LoadConst) X(LoadGlobal) X(StoreGlobal) \
+    X(Jump) X(JumpIfFalse) X(JumpIfTrue) X(Call) X(Return) X(Not) \
+    VM_INTEGER_OPCODES(X, I8) VM_INTEGER_OPCODES(X, I16) \
+    VM_INTEGER_OPCODES(X, I32) VM_INTEGER_OPCODES(X, I64) \
+    VM_INTEGER_OPCODES(X, U8) VM_INTEGER_OPCODES(X, U16) \
+    VM_INTEGER_OPCODES(X, U32) VM_INTEGER_OPCODES(X, U64) \
+    VM_NUMBER_OPCODES(X, F32) VM_NUMBER_OPCODES(X, F64) \
+    X(SignedToF32) X(SignedToF64) X(UnsignedToF32) X(UnsignedToF64) \
+    X(F32ToF64) X(F64ToF32)
+
+/// Operations of the register machine. `a`, `b` and `c` are the fields
+/// of the instruction, and `r[n]` is register n of the running function.
+///   Move          r[a] = r[b]
+///   LoadConst     r[a] = constants[bx]
+///   LoadGlobal    r[a] = globals[bx]
+///   StoreGlobal   globals[bx] = r[a]
+///   Jump          skip sbx instructions after this one
+///   JumpIfFalse   skip sbx instructions if r[a] is false
+///   JumpIfTrue    skip sbx instructions if r[a] is true
+///   Call          call functions[bx] with the arguments in r[a], r[a + 1], ...
+///                 and put the result in r[a]
+///   Return        return r[a]
+///   Not           r[a] = !r[b]
+///   <op><type>    r[a] = r[b] <op> r[c], or r[a] = <op> r[b] for one operand
+///   <type>To<type> r[a] = r[b] converted between those types
+enum class Op : u8 {
+#define VM_ENUM(name) name,
+    VM_OPCODES(VM_ENUM)
+#undef VM_ENUM
+};
+
+/// Operations that have one opcode per type. The opcodes of one type are
+/// laid out in this order, so `typed_op` can find them by adding
+enum class TypedOp : u8 {
+    Add, Sub, Mul, Div, Rem, Neg,
+    Eq, Ne, Lt, Le, Gt, Ge,
+    // Integers only
+    Shl, Shr, And, Or, Xor, Complement, Narrow,
+};
+
+/// Type of a value in a register. Booleans are U8 values of 0 or 1
+enum class Scalar : u8 {
+    I8, I16, I32, I64,
+    U8, U16, U32, U64,
+    F32, F64,
+};
+
+constexpr bool is_float(Scalar scalar) { return scalar == Scalar::F32 || scalar == Scalar::F64; }
+constexpr bool is_signed(Scalar scalar) { return scalar <= Scalar::I64; }
+
+/// The opcode of `op` for values of type `scalar`.
+/// Only integers have opcodes after `Ge`
+constexpr Op typed_op(Scalar scalar, TypedOp op) {
+    constexpr Op FIRST[] = {
+        Op::AddI8, Op::AddI16, Op::AddI32, Op::AddI64,
+        Op::AddU8, Op::AddU16, Op::AddU32, Op::AddU64,
+        Op::AddF32, Op::AddF64,
+    };
+    return static_cast<Op>(static_cast<u8>(FIRST[static_cast<u8>(scalar)]) + static_cast<u8>(op));
+}
+
+static_assert(typed_op(Scalar::I8, TypedOp::Narrow) == Op::NarrowI8);
+static_assert(typed_op(Scalar::U64, TypedOp::Narrow) == Op::NarrowU64);
+static_assert(typed_op(Scalar::F64, TypedOp::Ge) == Op::GeF64);
+
+/// One instruction. Operands that do not fit in 16 bits use `b` and `c`
+/// together as `bx`, or as the signed jump distance `sbx`
+struct Instruction {
+    Op op;
+    u16 a;
+    u16 b;
+    u16 c;
+
+    u32 bx() const { return static_cast<u32>(b) | (static_cast<u32>(c) << 16); }
+    i32 sbx() const { return static_cast<i32>(bx()); }
+
+    static Instruction abc(Op op, u16 a, u16 b, u16 c = 0) { return Instruction{ op, a, b, c }; }
+    static Instruction abx(Op op, u16 a, u32 bx) {
+        return Instruction{ op, a, static_cast<u16>(bx), static_cast<u16>(bx >> 16) };
+    }
+};
+
+static_assert(sizeof(Instruction) == 8);
+
+/// Registers, globals and constants are untyped 64 bit slots. Integers
+/// are kept widened to 64 bits by their sign, so an integer can be read
+/// as any type that is at least as wide. Floats are kept as their bits
+using Value = u64;
+
+template <typename T>
+constexpr Value encode(T value) {
+    if constexpr (std::is_same_v<T, f32>) {
+        return std::bit_cast<u32>(value);
+    } else if constexpr (std::is_same_v<T, f64>) {
+        return std::bit_cast<u64>(value);
+    } else if constexpr (std::is_signed_v<T>) {
+        return static_cast<Value>(static_cast<i64>(value));
+    } else {
+        return static_cast<Value>(value);
+    }
+}
+
+template <typename T>
+constexpr T decode(Value value) {
+    if constexpr (std::is_same_v<T, f32>) {
+        return std::bit_cast<f32>(static_cast<u32>(value));
+    } else if constexpr (std::is_same_v<T, f64>) {
+        return std::bit_cast<f64>(value);
+    } else {
+        return static_cast<T>(value);
+    }
+}
+
+/// Bring an integer to the form that `encode` gives values of `scalar`
+constexpr Value narrow(Value value, Scalar scalar) {
+    switch (scalar) {
+        case Scalar::I8: return encode(static_cast<i8>(value));
+        case Scalar::I16: return encode(static_cast<i16>(value));
+        case Scalar::I32: return encode(static_cast<i32>(value));
+        case Scalar::U8: return encode(static_cast<u8>(value));
+        case Scalar::U16: return encode(static_cast<u16>(value));
+        case Scalar::U32: return encode(static_cast<u32>(value));
+        default: return value;
+    }
+}
+
+struct Function {
+    std::string name;
+    u32 param_count;    // the parameters are the first registers
+    u32 register_count;
+    std::vector<Instruction> code;
+};
+
+/// A whole program in bytecode. Function `init` computes the globals
+/// and has to run before any other
+struct Module {
+    std::vector<Value> constants;
+    std::vector<Function> functions;
+    u32 global_count = 0;
+    u32 init = 0;
+
+    /// Index of the function called `name`, or -1
+    i64 find(std::string_view name) const {
+        for (usize i = 0; i < functions.size(); i++) {
+            if (functions[i].name == name) {
+                return static_cast<i64>(i);
+            }
+        }
+        return -1;
+    }
+};
+
+} // namespace vm
+} // namespace compiler
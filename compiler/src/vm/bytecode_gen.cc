@@ -0,0 +1,539 @@
+#include "bytecode_gen.h"
+#include "core/interner.h"
+#include "core/utils.h"
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace compiler {
+namespace vm {
+
+using namespace core;
+
+/// Registers that an instruction can address
+constexpr u32 MAX_REGISTERS = 1u << 16;
+
+/// The register type of values of `type`, if they fit in one
+static std::optional<Scalar>
+scalar_of(const Type* type) {
+    if (const TypeInteger* integer = utils::dyn_cast<TypeInteger>(type)) {
+        switch (integer->size) {
+            case 1: return integer->is_signed ? Scalar::I8 : Scalar::U8;
+            case 2: return integer->is_signed ? Scalar::I16 : Scalar::U16;
+            case 4: return integer->is_signed ? Scalar::I32 : Scalar::U32;
+            case 8: return integer->is_signed ? Scalar::I64 : Scalar::U64;
+            default: return {};
+        }
+    }
+    if (const TypeFloat* floating = utils::dyn_cast<TypeFloat>(type)) {
+        return floating->size == 4 ? Scalar::F32 : Scalar::F64;
+    }
+    if (utils::isa<TypeBoolean>(type)) {
+        return Scalar::U8;
+    }
+    return {};
+}
+
+static Error
+unsupported_type(const Type* type) {
+    return Error(ErrorCode::UnsupportedType, { DiagnosticArg::text(type->to_str()) });
+}
+
+static Error
+unsupported_operator(Operator op) {
+    return Error(ErrorCode::UnsupportedOperator, { DiagnosticArg::text(operator_to_cstr(op)) });
+}
+
+BytecodeGen::BytecodeGen(Program& program)
+    : m_program(program)
+    {}
+
+Result<Module, Error> BytecodeGen::generate() {
+    // Functions get their indices first, since the values of globals can call them
+    std::vector<const AstFunctionDecl*> functions;
+    for (const AstNode* node : m_program.nodes()) {
+        if (const AstFunctionDecl* function = utils::dyn_cast<AstFunctionDecl>(node)) {
+            m_functions[function] = static_cast<u32>(functions.size());
+            functions.push_back(function);
+        }
+    }
+
+    m_module.functions.resize(functions.size() + 1);
+    m_module.init = static_cast<u32>(functions.size());
+    m_module.functions[m_module.init].name = "craft.init";
+
+    Result<Unit, Error> init = lower_init(m_module.functions[m_module.init]);
+    if (init.is_err()) {
+        return Err(init.unwrap_err());
+    }
+
+    for (usize i = 0; i < functions.size(); i++) {
+        Result<Unit, Error> lowered = lower_function(functions[i], m_module.functions[i]);
+        if (lowered.is_err()) {
+            return Err(lowered.unwrap_err());
+        }
+    }
+    return Ok(std::move(m_module));
+}
+
+void BytecodeGen::begin_function(Function& function) {
+    m_function = &function;
+    m_first_temp = function.param_count;
+    m_next_register = m_first_temp;
+    m_register_count = m_first_temp;
+}
+
+Result<Unit, Error> BytecodeGen::end_function() {
+    if (m_register_count > MAX_REGISTERS) {
+        return Err(Error(ErrorCode::TooManyRegisters, { DiagnosticArg::text(m_function->name) }));
+    }
+    // `Return` always reads a register, even when there is nothing to return
+    m_function->register_count = std::max<u32>(m_register_count, 1);
+    return Ok(Unit());
+}
+
+Result<Unit, Error> BytecodeGen::lower_init(Function& function) {
+    function.param_count = 0;
+    begin_function(function);
+
+    for (const AstNode* node : m_program.nodes()) {
+        const AstVarDecl* decl = utils::dyn_cast<AstVarDecl>(node);
+        if (decl == nullptr) {
+            continue;
+        }
+
+        const Type* type = decl->type.value_or(decl->value->get_type());
+        if (type == nullptr) {
+            return Err(Error(ErrorCode::UntypedExpression));
+        }
+        if (!scalar_of(type).has_value()) {
+            return Err(unsupported_type(type));
+        }
+
+        Result<u16, Error> value = lower_expr(decl->value);
+        if (value.is_err()) {
+            return Err(value.unwrap_err());
+        }
+        Result<u16, Error> converted = convert(value.unwrap(), decl->value->get_type(), type);
+        if (converted.is_err()) {
+            return Err(converted.unwrap_err());
+        }
+
+        u32 global = m_module.global_count++;
+        emit(Instruction::abx(Op::StoreGlobal, converted.unwrap(), global));
+        m_next_register = m_first_temp;
+
+        // Added after its value is lowered, so it cannot refer to itself
+        m_slots[decl] = Slot{ global, true };
+    }
+
+    emit(Instruction::abc(Op::Return, 0, 0));
+    return end_function();
+}
+
+Result<Unit, Error> BytecodeGen::lower_function(const AstFunctionDecl* decl, Function& function) {
+    function.name = std::string(Interner::global().lookup(decl->name));
+    function.param_count = static_cast<u32>(decl->params.size());
+    begin_function(function);
+
+    for (usize i = 0; i < decl->params.size(); i++) {
+        m_slots[decl->params[i]] = Slot{ static_cast<u32>(i), false };
+    }
+
+    for (const AstNode* stmt : decl->body) {
+        if (const AstReturnStmt* ret = utils::dyn_cast<AstReturnStmt>(stmt)) {
+            Result<u16, Error> value = lower_expr(ret->value);
+            if (value.is_err()) {
+                return Err(value.unwrap_err());
+            }
+            Result<u16, Error> converted = convert(value.unwrap(), ret->value->get_type(), decl->return_type);
+            if (converted.is_err()) {
+                return Err(converted.unwrap_err());
+            }
+            emit(Instruction::abc(Op::Return, converted.unwrap(), 0));
+
+            // Nothing after a return is ever run
+            break;
+        }
+
+        const AstVarDecl* local = utils::cast<AstVarDecl>(stmt);
+        const Type* type = local->type.value_or(local->value->get_type());
+        if (!scalar_of(type).has_value()) {
+            return Err(unsupported_type(type));
+        }
+
+        Result<u16, Error> value = lower_expr(local->value);
+        if (value.is_err()) {
+            return Err(value.unwrap_err());
+        }
+        Result<u16, Error> converted = convert(value.unwrap(), local->value->get_type(), type);
+        if (converted.is_err()) {
+            return Err(converted.unwrap_err());
+        }
+
+        // The local takes the first free register for good. A value that
+        // was computed there already needs no move
+        u16 reg = static_cast<u16>(m_first_temp);
+        if (converted.unwrap() != reg) {
+            emit(Instruction::abc(Op::Move, reg, converted.unwrap()));
+        }
+        m_first_temp++;
+        m_next_register = m_first_temp;
+        m_register_count = std::max(m_register_count, m_next_register);
+        m_slots[local] = Slot{ reg, false };
+    }
+    return end_function();
+}
+
+Result<u16, Error> BytecodeGen::lower_expr(const AstExpr* root) {
+    // Walked with an explicit stack like CodeGen does, since
+    // expressions can be far too deep to recurse over
+    struct Frame {
+        const AstExpr* expr;
+        u32 stage;  // operands lowered so far
+        u32 jump;   // for `&&` and `||`, the jump over the rhs
+        u16 base;   // register of the result of `&&`, `||` and calls
+    };
+
+    std::vector<Frame> stack;
+    std::vector<u16> values;
+    stack.push_back(Frame{ root, 0, 0, 0 });
+
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        const AstExpr* expr = frame.expr;
+
+        if (expr->get_type() == nullptr) {
+            if (const AstBinaryExpr* binary = utils::dyn_cast<AstBinaryExpr>(expr)) {
+                return Err(Error(ErrorCode::UnsupportedOperator, { DiagnosticArg::text(operator_to_cstr(binary->op)) }));
+            }
+            return Err(Error(ErrorCode::UntypedExpression));
+        }
+
+        if (const AstIdentifierExpr* identifier = utils::dyn_cast<AstIdentifierExpr>(expr)) {
+            const Slot& slot = m_slots.at(identifier->decl);
+            if (slot.is_global) {
+                u16 reg = alloc();
+                emit(Instruction::abx(Op::LoadGlobal, reg, slot.index));
+                values.push_back(reg);
+            } else {
+                values.push_back(static_cast<u16>(slot.index));
+            }
+            stack.pop_back();
+            continue;
+        }
+
+        // Arguments go in consecutive registers, which become the first
+        // registers of the callee
+        if (const AstCallExpr* call = utils::dyn_cast<AstCallExpr>(expr)) {
+            if (frame.stage == 0) {
+                frame.base = static_cast<u16>(m_next_register);
+            }
+            if (frame.stage > 0) {
+                // A temporary is already where the argument goes, anything else is copied there
+                u16 arg = values.back();
+                if (!is_temp(arg)) {
+                    values.back() = alloc();
+                    emit(Instruction::abc(Op::Move, values.back(), arg));
+                }
+            }
+            if (frame.stage < call->args.size()) {
+                AstExpr* arg = call->args[frame.stage++];
+                stack.push_back(Frame{ arg, 0, 0, 0 });
+                continue;
+            }
+
+            values.resize(values.size() - call->args.size());
+            emit(Instruction::abx(Op::Call, frame.base, m_functions.at(call->target)));
+            m_next_register = frame.base;
+            values.push_back(alloc());
+            stack.pop_back();
+            continue;
+        }
+
+        if (const AstPrefixExpr* prefix = utils::dyn_cast<AstPrefixExpr>(expr)) {
+            if (frame.stage == 0) {
+                frame.stage = 1;
+                stack.push_back(Frame{ prefix->rhs, 0, 0, 0 });
+                continue;
+            }
+
+            u16 rhs = values.back();
+            values.pop_back();
+            Result<u16, Error> value = lower_prefix(prefix, rhs);
+            if (value.is_err()) {
+                return value;
+            }
+            values.push_back(value.unwrap());
+            stack.pop_back();
+            continue;
+        }
+
+        if (const AstBinaryExpr* binary = utils::dyn_cast<AstBinaryExpr>(expr)) {
+            bool is_and = binary->op == Operator::LOGICAL_AND;
+            bool is_logical = is_and || binary->op == Operator::LOGICAL_OR;
+
+            if (frame.stage == 0) {
+                frame.stage = 1;
+                stack.push_back(Frame{ binary->lhs, 0, 0, 0 });
+                continue;
+            }
+
+            // The rhs of `&&` and `||` is only evaluated if the lhs
+            // does not decide the result already. Both end up in the
+            // same register, which the jump over the rhs tests
+            if (frame.stage == 1) {
+                frame.stage = 2;
+                if (is_logical) {
+                    u16 lhs = values.back();
+                    frame.base = is_temp(lhs) ? lhs : alloc();
+                    if (frame.base != lhs) {
+                        emit(Instruction::abc(Op::Move, frame.base, lhs));
+                    }
+                    values.back() = frame.base;
+                    frame.jump = emit(Instruction::abx(is_and ? Op::JumpIfFalse : Op::JumpIfTrue, frame.base, 0));
+                }
+                stack.push_back(Frame{ binary->rhs, 0, 0, 0 });
+                continue;
+            }
+
+            u16 rhs = values.back();
+            values.pop_back();
+            u16 lhs = values.back();
+            values.pop_back();
+
+            if (is_logical) {
+                if (rhs != frame.base) {
+                    emit(Instruction::abc(Op::Move, frame.base, rhs));
+                }
+                m_next_register = frame.base + 1u;
+
+                u32 distance = static_cast<u32>(m_function->code.size()) - (frame.jump + 1);
+                m_function->code[frame.jump] = Instruction::abx(m_function->code[frame.jump].op, frame.base, distance);
+                values.push_back(frame.base);
+            } else {
+                Result<u16, Error> value = lower_binary(binary, lhs, rhs);
+                if (value.is_err()) {
+                    return value;
+                }
+                values.push_back(value.unwrap());
+            }
+            stack.pop_back();
+            continue;
+        }
+
+        Result<u16, Error> literal = lower_literal(expr);
+        if (literal.is_err()) {
+            return literal;
+        }
+        values.push_back(literal.unwrap());
+        stack.pop_back();
+    }
+
+    return Ok(values.back());
+}
+
+Result<u16, Error> BytecodeGen::lower_literal(const AstExpr* expr) {
+    std::optional<Scalar> scalar = scalar_of(expr->get_type());
+    if (!scalar.has_value()) {
+        return Err(unsupported_type(expr->get_type()));
+    }
+
+    Value value = 0;
+    switch (expr->kind) {
+        case AstKind::IntegerExpr:
+            value = narrow(utils::cast<AstIntegerExpr>(expr)->value, scalar.value());
+            break;
+        case AstKind::FloatExpr: {
+            f64 floating = utils::cast<AstFloatExpr>(expr)->value;
+            value = scalar == Scalar::F32 ? encode(static_cast<f32>(floating)) : encode(floating);
+            break;
+        }
+        case AstKind::BoolExpr:
+            value = utils::cast<AstBoolExpr>(expr)->value ? 1 : 0;
+            break;
+        default:
+            return Err(Error(ErrorCode::UntypedExpression));
+    }
+
+    u16 reg = alloc();
+    emit(Instruction::abx(Op::LoadConst, reg, constant(value)));
+    return Ok(reg);
+}
+
+Result<u16, Error> BytecodeGen::convert(u16 reg, const Type* from, const Type* to) {
+    if (from == to) {
+        return Ok(reg);
+    }
+
+    std::optional<Scalar> source = scalar_of(from);
+    std::optional<Scalar> target = scalar_of(to);
+    if (!source.has_value()) {
+        return Err(unsupported_type(from));
+    }
+    if (!target.has_value()) {
+        return Err(unsupported_type(to));
+    }
+
+    Op op;
+    const TypeInteger* int_from = utils::dyn_cast<TypeInteger>(from);
+    const TypeInteger* int_to = utils::dyn_cast<TypeInteger>(to);
+    if (int_from != nullptr && int_to != nullptr) {
+        // Widening keeps the bits when the sign extension stays valid
+        bool keeps_bits = int_from->size < int_to->size && (!int_from->is_signed || int_to->is_signed);
+        if (keeps_bits) {
+            return Ok(reg);
+        }
+        op = typed_op(target.value(), TypedOp::Narrow);
+    } else if (int_from != nullptr && is_float(target.value())) {
+        bool to_f32 = target == Scalar::F32;
+        op = int_from->is_signed
+            ? (to_f32 ? Op::SignedToF32 : Op::SignedToF64)
+            : (to_f32 ? Op::UnsignedToF32 : Op::UnsignedToF64);
+    } else if (is_float(source.value()) && is_float(target.value())) {
+        op = target == Scalar::F64 ? Op::F32ToF64 : Op::F64ToF32;
+    } else {
+        return Ok(reg);
+    }
+
+    // Temporaries are converted in place, so an operand that is
+    // converted does not free the one above it
+    u16 dst = is_temp(reg) ? reg : alloc();
+    emit(Instruction::abc(op, dst, reg));
+    return Ok(dst);
+}
+
+Result<u16, Error> BytecodeGen::lower_prefix(const AstPrefixExpr* expr, u16 rhs) {
+    std::optional<Scalar> scalar = scalar_of(expr->get_type());
+    if (!scalar.has_value()) {
+        return Err(unsupported_type(expr->get_type()));
+    }
+
+    Op op;
+    switch (expr->op) {
+        case Operator::MINUS:
+            op = typed_op(scalar.value(), TypedOp::Neg);
+            break;
+        case Operator::BINARY_NOT:
+            if (is_float(scalar.value())) {
+                return Err(unsupported_operator(expr->op));
+            }
+            op = typed_op(scalar.value(), TypedOp::Complement);
+            break;
+        case Operator::LOGICAL_NOT:
+            op = Op::Not;
+            break;
+        default:
+            return Err(unsupported_operator(expr->op));
+    }
+
+    u16 dst = result({ rhs });
+    emit(Instruction::abc(op, dst, rhs));
+    return Ok(dst);
+}
+
+Result<u16, Error> BytecodeGen::lower_binary(const AstBinaryExpr* expr, u16 lhs, u16 rhs) {
+    const Type* lhs_type = expr->lhs->get_type();
+    const Type* rhs_type = expr->rhs->get_type();
+
+    // Shifts keep the type of the value and take an amount of any width
+    if (expr->op == Operator::SHIFT_LEFT || expr->op == Operator::SHIFT_RIGHT) {
+        if (!utils::isa<TypeInteger>(lhs_type) || !utils::isa<TypeInteger>(rhs_type)) {
+            return Err(unsupported_operator(expr->op));
+        }
+
+        Scalar scalar = scalar_of(lhs_type).value();
+        Op op = typed_op(scalar, expr->op == Operator::SHIFT_LEFT ? TypedOp::Shl : TypedOp::Shr);
+        u16 dst = result({ lhs, rhs });
+        emit(Instruction::abc(op, dst, lhs, rhs));
+        return Ok(dst);
+    }
+
+    // Both operands are brought to their coalesced type first. For
+    // arithmetic that is the type of the result, and for comparisons
+    // it is the type they are compared in
+    const Type* common = lhs_type;
+    if (lhs_type != rhs_type) {
+        ResultType coalesced = m_program.types().coalesce(lhs_type, rhs_type);
+        if (coalesced.is_err()) {
+            return Err(coalesced.unwrap_err());
+        }
+        common = coalesced.unwrap();
+
+        Result<u16, Error> lhs_converted = convert(lhs, lhs_type, common);
+        if (lhs_converted.is_err()) {
+            return lhs_converted;
+        }
+        Result<u16, Error> rhs_converted = convert(rhs, rhs_type, common);
+        if (rhs_converted.is_err()) {
+            return rhs_converted;
+        }
+        lhs = lhs_converted.unwrap();
+        rhs = rhs_converted.unwrap();
+    }
+
+    std::optional<Scalar> scalar = scalar_of(common);
+    if (!scalar.has_value()) {
+        return Err(unsupported_type(common));
+    }
+
+    TypedOp op;
+    switch (expr->op) {
+        case Operator::PLUS: op = TypedOp::Add; break;
+        case Operator::MINUS: op = TypedOp::Sub; break;
+        case Operator::MUL: op = TypedOp::Mul; break;
+        case Operator::DIV: op = TypedOp::Div; break;
+        case Operator::MOD: op = TypedOp::Rem; break;
+        case Operator::BINARY_AND: op = TypedOp::And; break;
+        case Operator::BINARY_OR: op = TypedOp::Or; break;
+        case Operator::BINARY_XOR: op = TypedOp::Xor; break;
+        case Operator::EQUAL: op = TypedOp::Eq; break;
+        case Operator::NOT_EQUAL: op = TypedOp::Ne; break;
+        case Operator::LESS_THAN: op = TypedOp::Lt; break;
+        case Operator::GREATER_THAN: op = TypedOp::Gt; break;
+        case Operator::LESS_EQUAL: op = TypedOp::Le; break;
+        case Operator::GREATER_EQUAL: op = TypedOp::Ge; break;
+        default: return Err(unsupported_operator(expr->op));
+    }
+    if (is_float(scalar.value()) && op > TypedOp::Ge) {
+        return Err(unsupported_operator(expr->op));
+    }
+
+    u16 dst = result({ lhs, rhs });
+    emit(Instruction::abc(typed_op(scalar.value(), op), dst, lhs, rhs));
+    return Ok(dst);
+}
+
+u16 BytecodeGen::alloc() {
+    u16 reg = static_cast<u16>(m_next_register++);
+    m_register_count = std::max(m_register_count, m_next_register);
+    return reg;
+}
+
+// Temporaries are freed in the reverse order they were allocated in,
+// so everything from the lowest one up is free once the operands are used
+u16 BytecodeGen::result(std::initializer_list<u16> operands) {
+    for (u16 operand : operands) {
+        if (is_temp(operand)) {
+            m_next_register = std::min<u32>(m_next_register, operand);
+        }
+    }
+    return alloc();
+}
+
+u32 BytecodeGen::constant(Value value) {
+    auto [it, inserted] = m_constants.try_emplace(value, static_cast<u32>(m_module.constants.size()));
+    if (inserted) {
+        m_module.constants.push_back(value);
+    }
+    return it->second;
+}
+
+u32 BytecodeGen::emit(Instruction instruction) {
+    m_function->code.push_back(instruction);
+    return static_cast<u32>(m_function->code.size() - 1);
+}
+
+} // namespace vm
+} // namespace compiler
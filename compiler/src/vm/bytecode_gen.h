@@ -0,0 +1,77 @@
+#pragma once
+#include "defines.h"
+#include "bytecode.h"
+#include "core/ast.h"
+#include "core/error.h"
+#include "core/result.h"
+#include "core/type.h"
+#include <initializer_list>
+#include <unordered_map>
+
+namespace compiler {
+namespace vm {
+
+using core::Error;
+using core::Result;
+using core::Unit;
+
+/// Lowers an analyzed program to bytecode, the way CodeGen lowers it to
+/// LLVM IR. Every top level `let` gets a global slot, which the `init`
+/// function fills in source order, and every `define` becomes a function.
+/// Parameters and locals live in fixed registers, and the temporaries of
+/// an expression are allocated above them like a stack, so an operand
+/// that is already in a register is used from there without a copy
+class BytecodeGen {
+public:
+    explicit BytecodeGen(core::Program& program);
+
+    Result<Module, Error> generate();
+
+private:
+    /// Where the value of a declaration lives
+    struct Slot {
+        u32 index;
+        bool is_global;
+    };
+
+    Result<Unit, Error> lower_function(const core::AstFunctionDecl* decl, Function& function);
+    Result<Unit, Error> lower_init(Function& function);
+
+    /// Lower `root`, returning the register that holds its value
+    Result<u16, Error> lower_expr(const core::AstExpr* root);
+    Result<u16, Error> lower_binary(const core::AstBinaryExpr* expr, u16 lhs, u16 rhs);
+    Result<u16, Error> lower_prefix(const core::AstPrefixExpr* expr, u16 rhs);
+    Result<u16, Error> lower_literal(const core::AstExpr* expr);
+
+    /// Convert a value between Craft types
+    Result<u16, Error> convert(u16 reg, const core::Type* from, const core::Type* to);
+
+    void begin_function(Function& function);
+    Result<Unit, Error> end_function();
+
+    /// Allocate a register for a temporary
+    u16 alloc();
+    /// Allocate the register of a result, after freeing the temporaries
+    /// among the operands it is computed from
+    u16 result(std::initializer_list<u16> operands);
+    bool is_temp(u16 reg) const { return reg >= m_first_temp; }
+
+    u32 constant(Value value);
+    u32 emit(Instruction instruction);
+
+    core::Program& m_program;
+    Module m_module;
+
+    // State of the function being lowered
+    Function* m_function = nullptr;
+    u32 m_first_temp = 0;    // registers below are parameters and locals
+    u32 m_next_register = 0;
+    u32 m_register_count = 0;
+
+    std::unordered_map<const core::AstNode*, Slot> m_slots;
+    std::unordered_map<const core::AstFunctionDecl*, u32> m_functions;
+    std::unordered_map<Value, u32> m_constants;
+};
+
+} // namespace vm
+} // namespace compiler
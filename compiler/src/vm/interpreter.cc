@@ -0,0 +1,293 @@
+#include "interpreter.h"
+#include "bytecode_gen.h"
+#include "core/interner.h"
+#include <cmath>
+#include <string>
+#include <type_traits>
+
+// GCC and Clang can jump straight from one handler to the next through a
+// table of label addresses. Each handler then ends in its own indirect
+// jump, which branch predictors handle far better than the single one of
+// a switch. Other compilers get the switch
+#if defined(__GNUC__) || defined(__clang__)
+#define VM_COMPUTED_GOTO 1
+#else
+#define VM_COMPUTED_GOTO 0
+#endif
+
+namespace compiler {
+namespace vm {
+
+using namespace core;
+
+/// Calls that can be active at once
+constexpr usize MAX_FRAMES = 1 << 16;
+
+// Integer arithmetic wraps around like it does in the generated machine
+// code. It is done on 64 bit unsigned values, where wrapping is defined
+
+template <typename T>
+static T add(T a, T b) {
+    if constexpr (std::is_floating_point_v<T>) {
+        return a + b;
+    } else {
+        return static_cast<T>(static_cast<u64>(a) + static_cast<u64>(b));
+    }
+}
+
+template <typename T>
+static T sub(T a, T b) {
+    if constexpr (std::is_floating_point_v<T>) {
+        return a - b;
+    } else {
+        return static_cast<T>(static_cast<u64>(a) - static_cast<u64>(b));
+    }
+}
+
+template <typename T>
+static T mul(T a, T b) {
+    if constexpr (std::is_floating_point_v<T>) {
+        return a * b;
+    } else {
+        return static_cast<T>(static_cast<u64>(a) * static_cast<u64>(b));
+    }
+}
+
+template <typename T>
+static T neg(T a) {
+    if constexpr (std::is_floating_point_v<T>) {
+        return -a;
+    } else {
+        return static_cast<T>(0 - static_cast<u64>(a));
+    }
+}
+
+// Dividing the lowest signed value by -1 overflows, so it is
+// handled as the negation it is. The divisor is never zero
+
+template <typename T>
+static T div(T a, T b) {
+    if constexpr (std::is_signed_v<T>) {
+        if (b == -1) {
+            return neg(a);
+        }
+    }
+    return static_cast<T>(a / b);
+}
+
+template <typename T>
+static T rem(T a, T b) {
+    if constexpr (std::is_signed_v<T>) {
+        if (b == -1) {
+            return 0;
+        }
+    }
+    return static_cast<T>(a % b);
+}
+
+/// Shift amounts are taken modulo the width of the type
+template <typename T>
+static u32 shift_amount(Value amount) {
+    return static_cast<u32>(amount) & (sizeof(T) * 8 - 1);
+}
+
+Interpreter::Interpreter(const Module& module, usize stack_size)
+    : m_module(module)
+      , m_globals(module.global_count, 0)
+      , m_stack(stack_size, 0)
+    {}
+
+Result<Unit, Error> Interpreter::initialize() {
+    Result<Value, Error> ran = execute(m_module.init, m_stack.data());
+    if (ran.is_err()) {
+        return Err(ran.unwrap_err());
+    }
+    return Ok(Unit());
+}
+
+Result<Value, Error> Interpreter::call(u32 function, std::span<const Value> args) {
+    std::copy(args.begin(), args.end(), m_stack.begin());
+    return execute(function, m_stack.data());
+}
+
+Result<Value, Error> Interpreter::execute(u32 entry, Value* registers) {
+    const Function* functions = m_module.functions.data();
+    const Value* constants = m_module.constants.data();
+    Value* globals = m_globals.data();
+    const Value* stack_end = m_stack.data() + m_stack.size();
+    m_frames.clear();
+
+    const Function* function = &functions[entry];
+    if (registers + function->register_count > stack_end) {
+        return Err(Error(ErrorCode::StackOverflow, { DiagnosticArg::text(function->name) }));
+    }
+    const Instruction* pc = function->code.data();
+    Value* r = registers;
+
+#if VM_COMPUTED_GOTO
+    static const void* const HANDLERS[] = {
+#define VM_LABEL(name) &&op_##name,
+        VM_OPCODES(VM_LABEL)
+#undef VM_LABEL
+    };
+#define VM_CASE(name) op_##name:
+#define VM_DISPATCH() goto *HANDLERS[static_cast<u8>(pc->op)]
+#define VM_NEXT() { ++pc; VM_DISPATCH(); }
+#else
+#define VM_CASE(name) case Op::name:
+#define VM_DISPATCH() continue
+#define VM_NEXT() { ++pc; continue; }
+#endif
+
+// Handlers of the operations that every number type has.
+// Comparisons leave a boolean
+#define VM_NUMBER_HANDLERS(T, type) \
+    VM_CASE(Add##T) r[pc->a] = encode<type>(add(decode<type>(r[pc->b]), decode<type>(r[pc->c]))); VM_NEXT(); \
+    VM_CASE(Sub##T) r[pc->a] = encode<type>(sub(decode<type>(r[pc->b]), decode<type>(r[pc->c]))); VM_NEXT(); \
+    VM_CASE(Mul##T) r[pc->a] = encode<type>(mul(decode<type>(r[pc->b]), decode<type>(r[pc->c]))); VM_NEXT(); \
+    VM_CASE(Neg##T) r[pc->a] = encode<type>(neg(decode<type>(r[pc->b]))); VM_NEXT(); \
+    VM_CASE(Eq##T) r[pc->a] = decode<type>(r[pc->b]) == decode<type>(r[pc->c]); VM_NEXT(); \
+    VM_CASE(Ne##T) r[pc->a] = decode<type>(r[pc->b]) != decode<type>(r[pc->c]); VM_NEXT(); \
+    VM_CASE(Lt##T) r[pc->a] = decode<type>(r[pc->b]) < decode<type>(r[pc->c]); VM_NEXT(); \
+    VM_CASE(Le##T) r[pc->a] = decode<type>(r[pc->b]) <= decode<type>(r[pc->c]); VM_NEXT(); \
+    VM_CASE(Gt##T) r[pc->a] = decode<type>(r[pc->b]) > decode<type>(r[pc->c]); VM_NEXT(); \
+    VM_CASE(Ge##T) r[pc->a] = decode<type>(r[pc->b]) >= decode<type>(r[pc->c]); VM_NEXT();
+
+#define VM_INTEGER_HANDLERS(T, type) \
+    VM_NUMBER_HANDLERS(T, type) \
+    VM_CASE(Div##T) { \
+        type divisor = decode<type>(r[pc->c]); \
+        if (divisor == 0) goto division_by_zero; \
+        r[pc->a] = encode<type>(div(decode<type>(r[pc->b]), divisor)); \
+    } VM_NEXT(); \
+    VM_CASE(Rem##T) { \
+        type divisor = decode<type>(r[pc->c]); \
+        if (divisor == 0) goto division_by_zero; \
+        r[pc->a] = encode<type>(rem(decode<type>(r[pc->b]), divisor)); \
+    } VM_NEXT(); \
+    VM_CASE(Shl##T) \
+        r[pc->a] = encode<type>(static_cast<type>(static_cast<u64>(decode<type>(r[pc->b])) << shift_amount<type>(r[pc->c]))); \
+        VM_NEXT(); \
+    VM_CASE(Shr##T) r[pc->a] = encode<type>(static_cast<type>(decode<type>(r[pc->b]) >> shift_amount<type>(r[pc->c]))); VM_NEXT(); \
+    VM_CASE(And##T) r[pc->a] = encode<type>(static_cast<type>(decode<type>(r[pc->b]) & decode<type>(r[pc->c]))); VM_NEXT(); \
+    VM_CASE(Or##T) r[pc->a] = encode<type>(static_cast<type>(decode<type>(r[pc->b]) | decode<type>(r[pc->c]))); VM_NEXT(); \
+    VM_CASE(Xor##T) r[pc->a] = encode<type>(static_cast<type>(decode<type>(r[pc->b]) ^ decode<type>(r[pc->c]))); VM_NEXT(); \
+    VM_CASE(Complement##T) r[pc->a] = encode<type>(static_cast<type>(~decode<type>(r[pc->b]))); VM_NEXT(); \
+    VM_CASE(Narrow##T) r[pc->a] = encode<type>(static_cast<type>(r[pc->b])); VM_NEXT();
+
+#define VM_FLOAT_HANDLERS(T, type) \
+    VM_NUMBER_HANDLERS(T, type) \
+    VM_CASE(Div##T) r[pc->a] = encode<type>(decode<type>(r[pc->b]) / decode<type>(r[pc->c])); VM_NEXT(); \
+    VM_CASE(Rem##T) r[pc->a] = encode<type>(std::fmod(decode<type>(r[pc->b]), decode<type>(r[pc->c]))); VM_NEXT();
+
+#if VM_COMPUTED_GOTO
+    VM_DISPATCH();
+#else
+    for (;;) {
+    switch (pc->op) {
+#endif
+
+    VM_CASE(Move) r[pc->a] = r[pc->b]; VM_NEXT();
+    VM_CASE(LoadConst) r[pc->a] = constants[pc->bx()]; VM_NEXT();
+    VM_CASE(LoadGlobal) r[pc->a] = globals[pc->bx()]; VM_NEXT();
+    VM_CASE(StoreGlobal) globals[pc->bx()] = r[pc->a]; VM_NEXT();
+    VM_CASE(Jump) pc += pc->sbx(); VM_NEXT();
+    VM_CASE(JumpIfFalse) if (r[pc->a] == 0) pc += pc->sbx(); VM_NEXT();
+    VM_CASE(JumpIfTrue) if (r[pc->a] != 0) pc += pc->sbx(); VM_NEXT();
+
+    VM_CASE(Call) {
+        const Function* callee = &functions[pc->bx()];
+        Value* callee_registers = r + pc->a;
+        if (callee_registers + callee->register_count > stack_end || m_frames.size() == MAX_FRAMES) {
+            function = callee;
+            goto stack_overflow;
+        }
+
+        m_frames.push_back(Frame{ function, pc, r });
+        function = callee;
+        r = callee_registers;
+        pc = callee->code.data();
+        VM_DISPATCH();
+    }
+
+    VM_CASE(Return) {
+        Value result = r[pc->a];
+        if (m_frames.empty()) {
+            return Ok(result);
+        }
+
+        const Frame& frame = m_frames.back();
+        function = frame.function;
+        pc = frame.call;
+        r = frame.registers;
+        m_frames.pop_back();
+        r[pc->a] = result;
+        VM_NEXT();
+    }
+
+    VM_CASE(Not) r[pc->a] = r[pc->b] ^ 1; VM_NEXT();
+
+    VM_INTEGER_HANDLERS(I8, i8)
+    VM_INTEGER_HANDLERS(I16, i16)
+    VM_INTEGER_HANDLERS(I32, i32)
+    VM_INTEGER_HANDLERS(I64, i64)
+    VM_INTEGER_HANDLERS(U8, u8)
+    VM_INTEGER_HANDLERS(U16, u16)
+    VM_INTEGER_HANDLERS(U32, u32)
+    VM_INTEGER_HANDLERS(U64, u64)
+    VM_FLOAT_HANDLERS(F32, f32)
+    VM_FLOAT_HANDLERS(F64, f64)
+
+    VM_CASE(SignedToF32) r[pc->a] = encode(static_cast<f32>(static_cast<i64>(r[pc->b]))); VM_NEXT();
+    VM_CASE(SignedToF64) r[pc->a] = encode(static_cast<f64>(static_cast<i64>(r[pc->b]))); VM_NEXT();
+    VM_CASE(UnsignedToF32) r[pc->a] = encode(static_cast<f32>(r[pc->b])); VM_NEXT();
+    VM_CASE(UnsignedToF64) r[pc->a] = encode(static_cast<f64>(r[pc->b])); VM_NEXT();
+    VM_CASE(F32ToF64) r[pc->a] = encode(static_cast<f64>(decode<f32>(r[pc->b]))); VM_NEXT();
+    VM_CASE(F64ToF32) r[pc->a] = encode(static_cast<f32>(decode<f64>(r[pc->b]))); VM_NEXT();
+
+#if !VM_COMPUTED_GOTO
+    }
+    }
+#endif
+
+#undef VM_FLOAT_HANDLERS
+#undef VM_INTEGER_HANDLERS
+#undef VM_NUMBER_HANDLERS
+#undef VM_NEXT
+#undef VM_DISPATCH
+#undef VM_CASE
+
+division_by_zero:
+    return Err(Error(ErrorCode::IntegerDivisionByZero, { DiagnosticArg::text(function->name) }));
+stack_overflow:
+    return Err(Error(ErrorCode::StackOverflow, { DiagnosticArg::text(function->name) }));
+}
+
+Result<i32, Error> run_bytecode(Program& program) {
+    Result<const AstFunctionDecl*, Error> main_res = program.entry_point();
+    if (main_res.is_err()) {
+        return Err(main_res.unwrap_err());
+    }
+
+    Result<Module, Error> generated = BytecodeGen(program).generate();
+    if (generated.is_err()) {
+        return Err(generated.unwrap_err());
+    }
+    Module module = generated.unwrap();
+
+    Interpreter interpreter(module);
+    Result<Unit, Error> initialized = interpreter.initialize();
+    if (initialized.is_err()) {
+        return Err(initialized.unwrap_err());
+    }
+
+    i64 main = module.find(Interner::global().lookup(main_res.unwrap()->name));
+    Result<Value, Error> result = interpreter.call(static_cast<u32>(main), {});
+    if (result.is_err()) {
+        return Err(result.unwrap_err());
+    }
+    return Ok(decode<i32>(result.unwrap()));
+}
+
+} // namespace vm
+} // namespace compiler
@@ -0,0 +1,56 @@
+#pragma once
+#include "defines.h"
+#include "bytecode.h"
+#include "core/ast.h"
+#include "core/error.h"
+#include "core/result.h"
+#include <span>
+#include <vector>
+
+namespace compiler {
+namespace vm {
+
+using core::Error;
+using core::Result;
+using core::Unit;
+
+/// Runs the functions of a bytecode module. Every call gets a window of
+/// registers on one stack that starts at the caller's argument registers,
+/// so arguments are passed without copying them
+class Interpreter {
+public:
+    /// Registers on the stack unless another size is asked for
+    static constexpr usize DEFAULT_STACK_SIZE = 1 << 20;
+
+    explicit Interpreter(const Module& module, usize stack_size = DEFAULT_STACK_SIZE);
+
+    /// Compute the globals. Has to run before any other function
+    Result<Unit, Error> initialize();
+
+    /// Call a function and return its result
+    Result<Value, Error> call(u32 function, std::span<const Value> args);
+
+    Value global(u32 index) const { return m_globals[index]; }
+
+private:
+    /// Where a call returns to
+    struct Frame {
+        const Function* function;
+        const Instruction* call; // the `Call` instruction
+        Value* registers;
+    };
+
+    Result<Value, Error> execute(u32 function, Value* registers);
+
+    const Module& m_module;
+    std::vector<Value> m_globals;
+    std::vector<Value> m_stack;
+    std::vector<Frame> m_frames;
+};
+
+/// Lower an analyzed program to bytecode and run its
+/// `define main(): i32`, returning what it returned
+Result<i32, Error> run_bytecode(core::Program& program);
+
+} // namespace vm
+} // namespace compiler
@@ -0,0 +1,76 @@
+#include "const_eval_tests.h"
+#include "core/ast.h"
+#include "core/utils.h"
+#include "frontend/parser.h"
+
+using namespace compiler;
+using namespace compiler::core;
+
+/// Parse and analyze `source`. Returns the number of errors
+static usize
+analyze(Program& program, const char* source) {
+    Parser parser(source, program);
+    for (AstNode* node = parser.next_node(); node != nullptr; node = parser.next_node()) {
+        program.add_node(node);
+    }
+    return program.analyze(1);
+}
+
+/// Does the last global fold to `value` of the integer type `is_signed`, `size`?
+static bool
+folds_to(Program& program, i64 value, bool is_signed, i32 size) {
+    const AstVarDecl* decl = utils::dyn_cast<AstVarDecl>(program.nodes().back());
+    const AstIntegerExpr* integer = decl ? utils::dyn_cast<AstIntegerExpr>(decl->value) : nullptr;
+    if (integer == nullptr) {
+        return false;
+    }
+    const TypeInteger* type = utils::cast<TypeInteger>(integer->type);
+    return static_cast<i64>(integer->value) == value && type->is_signed == is_signed && type->size == size;
+}
+
+void register_const_eval_tests(TestManager& manager) {
+    manager.register_test([]() -> uint8_t {
+        Program program;
+        return analyze(program, "let x: i32 = 1 - 2;") == 0 && folds_to(program, -1, true, 4);
+    }, "Constants are folded in the annotated type");
+
+    manager.register_test([]() -> uint8_t {
+        Program program;
+        return analyze(program, "let x: u8 = -200;") == 1;
+    }, "A negated literal out of range of an unsigned annotation is rejected");
+
+    manager.register_test([]() -> uint8_t {
+        Program program;
+        return analyze(program, "define f(): u8 { return -200; }") == 1;
+    }, "A negated literal out of range of an unsigned return type is rejected");
+
+    manager.register_test([]() -> uint8_t {
+        Program program;
+        return analyze(program, "let x: i8 = -200;") == 1;
+    }, "A negated literal out of range of a signed annotation is rejected");
+
+    manager.register_test([]() -> uint8_t {
+        Program program;
+        return analyze(program, "let x: i8 = -128;") == 0 && folds_to(program, -128, true, 1);
+    }, "The smallest value of a signed type can be written as a negated literal");
+
+    manager.register_test([]() -> uint8_t {
+        Program program;
+        return analyze(program, "let x = -9223372036854775808;") == 0 && folds_to(program, INT64_MIN, true, 8);
+    }, "The smallest i64 can be written as a negated literal");
+
+    manager.register_test([]() -> uint8_t {
+        Program program;
+        return analyze(program, "let x = -9223372036854775809;") == 1;
+    }, "Negating a literal too large for any signed type is rejected");
+
+    manager.register_test([]() -> uint8_t {
+        Program program;
+        return analyze(program, "let s: i32 = 4;\nlet x: i32 = 1 << s;") == 0;
+    }, "The literal value of a shift takes the annotated type");
+
+    manager.register_test([]() -> uint8_t {
+        Program program;
+        return analyze(program, "let s: i32 = 4;\nlet x: i64 = s + 1;") == 1;
+    }, "Literals next to a typed operand do not take the annotated type");
+}
@@ -0,0 +1,5 @@
+#pragma once
+#include "test_manager.h"
+
+/// Folding of constant expressions during semantic analysis
+void register_const_eval_tests(TestManager& manager);
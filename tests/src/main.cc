@@ -1,7 +1,9 @@
 #include "test_manager.h"
+#include "const_eval_tests.h"
 
 int main(void) {
     TestManager manager = TestManager();
+    register_const_eval_tests(manager);
 
     manager.run_tests();
     return 0;